@@ -21,10 +21,14 @@ import androidx.lifecycle.MutableLiveData
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
+import kotlinx.coroutines.channels.Channel
 import kotlinx.coroutines.delay
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.first
+import kotlinx.coroutines.isActive
 import kotlinx.coroutines.launch
-import kotlinx.coroutines.runBlocking
 import kotlinx.coroutines.withContext
+import kotlinx.coroutines.withTimeoutOrNull
 import java.io.IOException
 import java.io.InputStream
 import java.io.OutputStream
@@ -46,12 +50,19 @@ import java.util.UUID
  * - `discoveredDevicesSet`: A mutable set of `BluetoothDevice` objects used internally to keep track of discovered devices.
  * - `myUUID`: A unique identifier for creating RFCOMM Bluetooth sockets.
  * - `connectJob`, `sendJob`: `Coroutine` jobs managing connection and data transmission, respectively.
+ * - `readerJob`: The `Coroutine` job that reads the socket for as long as the connection lasts, see `startReader`.
+ * - `lineIdleJob`: The `Coroutine` job that ends an unterminated line once the device stopped sending, see `endLineWhenIdle`.
+ * - `replyLines`: A `Channel` of the lines the device sent, in order, from which `receiveData` takes them. Every connection gets a new
+ *   one; `cancelConnection` closes it.
+ * - `deviceBusy`: `true` between a "busy" and a "ready" line of the device (`PROTO_CAP_FLOW_CONTROL`). The reader keeps the flow
+ *   state here instead of queueing the lines, so `discardReplies` cannot drop a "busy" and let the app send into a full buffer.
  * - `connectionTimeout`: The timeout period for establishing a Bluetooth connection.
  * - `bluetoothSocket`: The `BluetoothSocket` used for communication with a connected device.
  * - `outputStream`, `inputStream`: Streams for sending and receiving data through the Bluetooth socket.
  *
  * **Companion Object:**
  * - `TAG`: A constant used for logging.
+ * - `READ_BUFFER_SIZE`, `LINE_IDLE_MILLIS`: The reusable read buffer of `startReader` and how long an unterminated line may stay quiet.
  *
  * **Private Inner Classes:**
  * - `discoveryReceiver`: A `BroadcastReceiver` that handles device discovery results by adding found devices
@@ -74,9 +85,16 @@ class BluetoothManager(private val context: Context) {
     private var bluetoothSocket: BluetoothSocket? = null
     private var outputStream: OutputStream? = null
     private var inputStream: InputStream? = null
+    private var readerJob: Job? = null
+    private var lineIdleJob: Job? = null
+    @Volatile
+    private var replyLines = Channel<String>(Channel.UNLIMITED)
+    private val deviceBusy = MutableStateFlow(false)
 
     companion object {
         private const val TAG = "BluetoothManager"
+        private const val READ_BUFFER_SIZE = 256
+        private const val LINE_IDLE_MILLIS = 20L  // ends an unterminated reply of firmware that does not end its replies with a newline
     }
 
     private val discoveryReceiver = object : BroadcastReceiver() {
@@ -224,6 +242,7 @@ class BluetoothManager(private val context: Context) {
 
                 outputStream = bluetoothSocket?.outputStream
                 inputStream = bluetoothSocket?.inputStream
+                inputStream?.let { startReader(it) }
 
                 withContext(Dispatchers.Main) {
                     onConnectionResult(true)
@@ -259,14 +278,19 @@ class BluetoothManager(private val context: Context) {
         return bluetoothSocket?.isConnected ?: false
     }
 
-    /** `sendData(message: String)`: Sends a string message to the connected Bluetooth device. Logs an error if the
-     *   socket is not connected. */
-    fun sendData(message: String) {
+    /** `sendData(message: String, keepReplies: Boolean = false)`: Sends a string message to the connected Bluetooth device.
+     *   Replies that arrived since the last `receiveData` answer an earlier message and are dropped first, see `discardReplies`,
+     *   unless `keepReplies` is set: a message resent after its timeout keeps the late reply to its first copy. Logs an error if
+     *   the socket is not connected. */
+    fun sendData(message: String, keepReplies: Boolean = false) {
         if (bluetoothSocket == null || bluetoothSocket?.isConnected == false) {
             Log.e(TAG, "Cannot send data: socket is not connected")
             return
         }
 
+        if (!keepReplies) {
+            discardReplies()
+        }
         try {
             Log.d(TAG, "Sending data: $message")
             bluetoothSocket?.outputStream?.write((message + "\n").toByteArray())  // Adding newline to delimit messages
@@ -276,54 +300,162 @@ class BluetoothManager(private val context: Context) {
         }
     }
 
-    /** `receiveData(timeoutMillis: Long = 5000L)`: Waits for data from the connected Bluetooth device within a
-     *   specified timeout period. Returns the received data as a string or `null` if no data is received. */
-    fun receiveData(timeoutMillis: Long = 5000L): String? {
-        return runBlocking {
-            val socket = bluetoothSocket
-            if (socket == null || !socket.isConnected) {
-                Log.e(TAG, "Cannot receive data: socket is not connected")
-                return@runBlocking null
-            }
+    /** `sendBytes(bytes: ByteArray, keepReplies: Boolean = false)`: Sends raw bytes, such as a binary frame, to the connected
+     *   Bluetooth device without appending a newline. Like `sendData` it drops the replies nobody waited for, unless `keepReplies`
+     *   is set: a window of sequenced frames is answered by cumulative acknowledgments, which stay valid for every frame that
+     *   follows, and the late reply to a resent frame still confirms it. Logs an error if the socket is not connected. */
+    fun sendBytes(bytes: ByteArray, keepReplies: Boolean = false) {
+        if (bluetoothSocket == null || bluetoothSocket?.isConnected == false) {
+            Log.e(TAG, "Cannot send data: socket is not connected")
+            return
+        }
+
+        if (!keepReplies) {
+            discardReplies()
+        }
+        try {
+            Log.d(TAG, "Sending ${bytes.size} bytes")
+            bluetoothSocket?.outputStream?.write(bytes)
+        } catch (e: IOException) {
+            Log.e(TAG, "Failed to send data: ${e.message}", e)
+        }
+    }
 
-            withContext(Dispatchers.IO) {
-                val inputStream = socket.inputStream
-                try {
-                    val startTime = System.currentTimeMillis()
-                    while (System.currentTimeMillis() - startTime < timeoutMillis) {
-                        val available = inputStream.available()
-                        if (available > 0) {
-                            val buffer = ByteArray(available)
-                            inputStream.read(buffer)
-                            val response = String(buffer).trim()
-                            Log.d(TAG, "Received data: $response")
-                            return@withContext response
+    /** `discardReplies()`: Drops every line that is queued but was not taken by `receiveData`, such as a reply that arrived after
+     *   its timeout. Otherwise the next `receiveData` would return it as the answer to the following message. The flow state in
+     *   `deviceBusy` is kept. */
+    fun discardReplies() {
+        while (true) {
+            val line = replyLines.tryReceive().getOrNull() ?: break
+            Log.d(TAG, "Dropped stale reply: $line")
+        }
+    }
+
+    /** `startReader(stream: InputStream)`: Starts the reader coroutine of a new connection on `Dispatchers.IO`, with a new
+     *   `replyLines`. It blocks in `read` until bytes arrive, reusing one buffer, splits them into lines at "\n" and "\r" and queues
+     *   every non-empty line right away, so a reply is available as soon as its newline arrives. The reader ends when the socket is
+     *   closed or the connection is cancelled, and its idle timer with it. */
+    private fun startReader(stream: InputStream) {
+        readerJob?.cancel()
+        lineIdleJob?.cancel()
+        replyLines.close()
+        replyLines = Channel(Channel.UNLIMITED)
+        deviceBusy.value = false
+        readerJob = CoroutineScope(Dispatchers.IO).launch {
+            val reader = this
+            val buffer = ByteArray(READ_BUFFER_SIZE)
+            val line = StringBuilder()
+            try {
+                while (isActive) {
+                    val count = stream.read(buffer)
+                    if (count < 0) {
+                        break
+                    }
+                    lineIdleJob?.cancel()
+                    synchronized(line) {
+                        for (i in 0 until count) {
+                            val c = (buffer[i].toInt() and 0xFF).toChar()
+                            if (c == '\n' || c == '\r') {
+                                queueLine(line)
+                            } else {
+                                line.append(c)
+                            }
+                        }
+                        if (line.isNotEmpty()) {
+                            endLineWhenIdle(reader, line)
                         }
-                        delay(25)
                     }
-                    Log.d(TAG, "Timeout waiting for response")
-                } catch (e: IOException) {
-                    Log.e(TAG, "Error reading from input stream", e)
                 }
-                null
+            } catch (e: IOException) {
+                Log.d(TAG, "Reader stopped: ${e.message}")
+            }
+        }
+    }
+
+    /** `endLineWhenIdle(reader: CoroutineScope, line: StringBuilder)`: Queues an unterminated line once no byte followed it for
+     *   `LINE_IDLE_MILLIS`, as after a reply of older firmware that does not end its replies with a newline. The timer runs as a
+     *   child of the `reader` coroutine, so it ends with the connection; the reader cancels it as soon as more bytes arrive, so it
+     *   costs nothing while a line is still coming in. */
+    private fun endLineWhenIdle(reader: CoroutineScope, line: StringBuilder) {
+        lineIdleJob = reader.launch {
+            delay(LINE_IDLE_MILLIS)
+            synchronized(line) {
+                if (isActive) {
+                    queueLine(line)
+                }
+            }
+        }
+    }
+
+    /** `queueLine(line: StringBuilder)`: Queues the trimmed line in `replyLines` unless it is empty or a flow-control line, which
+     *   sets `deviceBusy` instead, and clears it for the next one. */
+    private fun queueLine(line: StringBuilder) {
+        val text = line.trim().toString()
+        line.setLength(0)
+        when (text) {
+            "" -> {}
+            "busy" -> deviceBusy.value = true
+            "ready" -> deviceBusy.value = false
+            else -> replyLines.trySend(text)
+        }
+    }
+
+    /** `receiveData(timeoutMillis: Long = 5000L, accept: (String) -> Boolean = { true })`: Waits within the timeout for the next
+     *   line from the connected Bluetooth device that `accept` matches, and returns it, or `null` if none arrives. Lines `accept`
+     *   rejects, such as the late reply to an earlier message, are dropped. It suspends on `replyLines` instead of polling, so it
+     *   returns as soon as the reader queued the line, and one call returns one line; the next call returns the next one.
+     *   The flow-control lines "busy" and "ready" are never returned. While the device is busy (`deviceBusy`) the function keeps
+     *   waiting until "ready" arrives, so the caller only sends again once the device listens. */
+    suspend fun receiveData(timeoutMillis: Long = 5000L, accept: (String) -> Boolean = { true }): String? {
+        val socket = bluetoothSocket
+        if (socket == null || !socket.isConnected) {
+            Log.e(TAG, "Cannot receive data: socket is not connected")
+            return null
+        }
+
+        val channel = replyLines
+        val response = withTimeoutOrNull(timeoutMillis) {
+            var accepted: String? = null
+            while (accepted == null) {
+                val line = channel.receiveCatching().getOrNull() ?: return@withTimeoutOrNull null
+                if (accept(line)) {
+                    accepted = line
+                } else {
+                    Log.d(TAG, "Dropped unexpected reply: $line")
+                }
             }
+            deviceBusy.first { !it }
+            accepted
+        }
+        if (response == null) {
+            Log.d(TAG, "Timeout waiting for response")
+            return null
         }
+        Log.d(TAG, "Received data: $response")
+        return response
     }
 
-    /** `cancelConnection()`: Cancels any ongoing connection or data transmission, closes the Bluetooth socket and
-     *   associated streams, and cleans up resources. */
+    /** `cancelConnection()`: Cancels any ongoing connection, data transmission and the reader, closes the Bluetooth socket and
+     *   associated streams, and cleans up resources. Closing `replyLines` ends a pending `receiveData` right away with `null`. */
     fun cancelConnection() {
         try {
             connectJob?.cancel()
             sendJob?.cancel()
+            readerJob?.cancel()
+            lineIdleJob?.cancel()
             connectJob = null
             sendJob = null
+            readerJob = null
+            lineIdleJob = null
+            replyLines.close()
             outputStream?.close()
+            inputStream?.close()
             bluetoothSocket?.closeSilently()
         } catch (e: IOException) {
             Log.e(TAG, "Error closing socket or stream: ${e.message}", e)
         } finally {
             outputStream = null
+            inputStream = null
             bluetoothSocket = null
         }
     }
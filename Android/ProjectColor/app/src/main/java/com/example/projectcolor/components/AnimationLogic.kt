@@ -0,0 +1,148 @@
+package com.example.projectcolor.components
+
+const val ANIM_HEADER_SIZE = 8
+const val ANIM_MAGIC = 0xA5
+const val ANIM_FLAG_LOOP = 0x01
+const val ANIM_FLAG_AUTOPLAY = 0x02
+const val ANIM_MAX_FPS = 50
+const val ANIM_DATA_OFFSET_SIZE = 2
+const val ANIM_BLOCK_SIZE = FRAME_MAX_PAYLOAD - ANIM_DATA_OFFSET_SIZE
+const val ANIM_MERGE_GAP = 2
+const val ANIM_INFO = "anim-info"
+const val ANIM_PLAY = "anim-play"
+const val ANIM_ACK = "anim-ack"
+
+/**
+ * animationChunks is a function that encodes one frame of a stored animation as the chunks the firmware plays back.
+ *
+ * **Parameters:**
+ *
+ * - `current`: An `IntArray` holding the colors of the frame, indexed by pixel position.
+ * - `previous`: An `IntArray` holding the colors of the frame shown before it, or `null` for the first frame.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns the chunks of the frame, each a length byte and a `FRAME_TYPE_PIXELS_COMPRESSED` payload, closed by a 0 byte.
+ *
+ * **Functionality:**
+ *
+ * - The first frame is encoded whole with `compressedPayloads`. Later frames only encode the runs of pixels that differ from
+ *   `previous`; runs separated by up to `ANIM_MERGE_GAP` unchanged pixels are merged, since a new chunk costs more than a few pixels.
+ */
+fun animationChunks(current: IntArray, previous: IntArray?): ByteArray {
+    val runs = mutableListOf<IntRange>()
+    if (previous == null) {
+        runs.add(current.indices)
+    } else {
+        var index = 0
+        while (index < current.size) {
+            if (current[index] == previous[index]) {
+                index++
+                continue
+            }
+            var end = index
+            var next = index + 1
+            while (next < current.size && next - end <= ANIM_MERGE_GAP + 1) {
+                if (current[next] != previous[next]) {
+                    end = next
+                }
+                next++
+            }
+            runs.add(index..end)
+            index = end + 1
+        }
+    }
+
+    val chunks = mutableListOf<Byte>()
+    for (run in runs) {
+        for (payload in compressedPayloads(current.copyOfRange(run.first, run.last + 1), run.first)) {
+            chunks.add(payload.size.toByte())
+            chunks.addAll(payload.toList())
+        }
+    }
+    chunks.add(0)
+    return chunks.toByteArray()
+}
+
+/**
+ * buildAnimation is a function that encodes a list of frames into the stored animation format of the firmware, see `animation.h`.
+ *
+ * **Parameters:**
+ *
+ * - `frames`: A `List<IntArray>` holding the colors of every frame, indexed by pixel position. At most 255 frames.
+ * - `fps`: An `Int` holding the playback rate, 1..`ANIM_MAX_FPS`.
+ * - `loop`: A `Boolean` that makes the firmware start over after the last frame instead of stopping on it.
+ * - `autoplay`: A `Boolean` that makes the firmware start the animation after a reset.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns the header (magic, frame count, fps, flags, data length and CRC-16 of the data, both big-endian) followed
+ *   by the frame data built with `animationChunks`.
+ */
+fun buildAnimation(frames: List<IntArray>, fps: Int, loop: Boolean, autoplay: Boolean): ByteArray {
+    var data = ByteArray(0)
+    frames.forEachIndexed { index, frame ->
+        data += animationChunks(frame, frames.getOrNull(index - 1))
+    }
+    val flags = (if (loop) ANIM_FLAG_LOOP else 0) or (if (autoplay) ANIM_FLAG_AUTOPLAY else 0)
+    val crc = crc16(data)
+    val header = byteArrayOf(
+        ANIM_MAGIC.toByte(), frames.size.toByte(), fps.toByte(), flags.toByte(),
+        (data.size shr 8).toByte(), data.size.toByte(), (crc shr 8).toByte(), crc.toByte()
+    )
+    return header + data
+}
+
+/**
+ * buildAnimationUploadFrames is a function that splits an encoded animation into `FRAME_TYPE_ANIMATION_DATA` frames.
+ *
+ * **Parameters:**
+ *
+ * - `animation`: A `ByteArray` holding the animation, as built by `buildAnimation`.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the complete frames, as built by `buildFrame`, each holding a 2-byte storage offset (big-endian) and
+ *   up to `ANIM_BLOCK_SIZE` bytes.
+ *
+ * **Functionality:**
+ *
+ * - The header is sent last. Until it arrives the firmware still holds the old header, whose CRC no longer matches the data, so an
+ *   interrupted upload is never played.
+ */
+fun buildAnimationUploadFrames(animation: ByteArray): List<ByteArray> {
+    fun block(offset: Int, length: Int): ByteArray {
+        val payload = byteArrayOf((offset shr 8).toByte(), offset.toByte()) + animation.copyOfRange(offset, offset + length)
+        return buildFrame(FRAME_TYPE_ANIMATION_DATA, payload)
+    }
+
+    val frames = mutableListOf<ByteArray>()
+    for (offset in ANIM_HEADER_SIZE until animation.size step ANIM_BLOCK_SIZE) {
+        frames.add(block(offset, minOf(ANIM_BLOCK_SIZE, animation.size - offset)))
+    }
+    frames.add(block(0, ANIM_HEADER_SIZE))
+    return frames
+}
+
+/**
+ * scrollAnimation is a function that builds the frames of a picture scrolling to the left and wrapping around.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the colors of the picture, as returned by `matrixColors`.
+ * - `width`: An `Int` holding the number of columns of the grid.
+ * - `step`: An `Int` holding the number of columns the picture moves per frame. It should divide `width`.
+ *
+ * **Returns:**
+ *
+ * - `List<IntArray>`: Returns `width / step` frames; the one after the last frame is the picture again, so the animation loops.
+ */
+fun scrollAnimation(colors: IntArray, width: Int, step: Int): List<IntArray> {
+    return (0 until width / step).map { frame ->
+        IntArray(colors.size) { index ->
+            val row = index / width
+            val column = index % width
+            colors[row * width + (column + frame * step) % width]
+        }
+    }
+}
@@ -1,163 +1,142 @@
 package com.example.projectcolor.components
 
 /**
- * onesComplement is a function that computes the one's complement of a given binary string. The one's complement is obtained by inverting each bit in the string.
+ * CRC8_TABLE and CRC16_TABLE hold the precomputed remainders for every byte value, the same tables the firmware keeps in PROGMEM.
+ */
+private val CRC8_TABLE = IntArray(256) { index ->
+    var crc = index
+    repeat(8) {
+        crc = if ((crc and 0x80) != 0) ((crc shl 1) xor 0x07) and 0xFF else (crc shl 1) and 0xFF
+    }
+    crc
+}
+
+private val CRC16_TABLE = IntArray(256) { index ->
+    var crc = index shl 8
+    repeat(8) {
+        crc = if ((crc and 0x8000) != 0) ((crc shl 1) xor 0x1021) and 0xFFFF else (crc shl 1) and 0xFFFF
+    }
+    crc
+}
+
+/**
+ * onesComplementSum is a function that adds a block of bytes to a running 8-bit one's complement sum. It replaces the old
+ * bit-string implementation and produces the same values, so the checksums stay compatible with every firmware build.
  *
  * **Parameters:**
  *
- * - `data`: A `String` representing the binary data for which the one's complement will be calculated.
+ * - `data`: A `ByteArray` holding the bytes to be added.
+ * - `offset`: An `Int` index of the first byte to add. The default value is `0`.
+ * - `length`: An `Int` number of bytes to add. The default value is the rest of the array.
+ * - `sum`: An `Int` holding the running sum from a previous block. The default value is `0`.
  *
  * **Returns:**
  *
- * - `String`: Returns a new binary string where each bit is the inverse of the corresponding bit in the input string. Specifically, '0' becomes '1' and '1' becomes '0'.
+ * - `Int`: Returns the updated sum, in the range 0..255.
  *
  * **Functionality:**
  *
- * - The function iterates over each character in the input string.
- * - For each character, it inverts the bit: '0' is changed to '1', and '1' is changed to '0'.
- * - The inverted bits are stored in a `CharArray`, which is then converted back into a string and returned.
- *
- * - This function is typically used as part of a checksum calculation to help verify data integrity by ensuring that the transmitted data can be checked for errors.
+ * - Every byte is added as an 8-bit block; a carry out of the top bit is added back to the lowest bit (end-around carry).
  */
-fun onesComplement(data: String): String {
-    val result = CharArray(data.length)
-    for (index in data.indices) {
-        result[index] = if (data[index] == '0') '1' else '0'
+fun onesComplementSum(data: ByteArray, offset: Int = 0, length: Int = data.size - offset, sum: Int = 0): Int {
+    var accumulator = sum
+    for (index in offset until offset + length) {
+        accumulator += data[index].toInt() and 0xFF
+        accumulator = (accumulator and 0xFF) + (accumulator shr 8)
     }
-    return result.concatToString()
+    return accumulator
 }
 
 /**
- * binaryAdd is a function that performs binary addition of two binary strings, each representing a block of bits, and returns the result.
- * The function also handles any carry-over that results from the addition, ensuring that the final binary string is accurate.
+ * onesComplementChecksum is a function that calculates the checksum byte appended to "data:" messages.
  *
  * **Parameters:**
  *
- * - `result`: A `String` representing the first binary block to be added. This is typically the cumulative result of previous additions.
- * - `nextBlock`: A `String` representing the next binary block to be added to the `result`.
- * - `blockSize`: An `Int` specifying the size of the blocks (i.e., the number of bits) involved in the binary addition.
+ * - `data`: A `ByteArray` holding the message bytes.
+ * - `length`: An `Int` number of bytes to include. The default value is the full array.
  *
  * **Returns:**
  *
- * - `String`: Returns the binary string that results from the addition of `result` and `nextBlock`, taking into account any carry-over.
+ * - `Int`: Returns the one's complement of the one's complement sum of the message, in the range 0..255.
+ */
+fun onesComplementChecksum(data: ByteArray, length: Int = data.size): Int {
+    return onesComplementSum(data, 0, length).inv() and 0xFF
+}
+
+/**
+ * crc8Update is a function that feeds a block of bytes into a running CRC-8 (polynomial 0x07, initial value 0x00). It matches
+ * `crc8Update` in the firmware, which verifies binary frames with it.
  *
- * **Functionality:**
+ * **Parameters:**
  *
- * - The function initializes an array of characters (`resultArray`) from the `result` string, which will hold the result of the addition.
- * - Starting from the least significant bit (rightmost), it iterates through each bit in the `result` and `nextBlock`, performs binary addition, and accounts for carry.
- * - If there is any carry remaining after the initial pass, the function continues to propagate the carry through the more significant bits (moving left).
- * - The final result, which includes any carry-over, is returned as a new binary string.
+ * - `crc`: An `Int` holding the running CRC. Start with `0`.
+ * - `data`: A `ByteArray` holding the bytes to be checked.
+ * - `offset`: An `Int` index of the first byte. The default value is `0`.
+ * - `length`: An `Int` number of bytes. The default value is the rest of the array.
  *
- * - This function is typically used in the context of checksum calculations, where multiple binary blocks are summed to create a final checksum value.
+ * **Returns:**
+ *
+ * - `Int`: Returns the updated CRC, in the range 0..255.
  */
-fun binaryAdd(result: String, nextBlock: String, blockSize: Int): String {
-    val resultArray = result.toCharArray()
-    var carry = 0
-    for (k in blockSize - 1 downTo 0) {
-        val sum = (nextBlock[k] - '0') + (resultArray[k] - '0') + carry
-        resultArray[k] = (sum % 2 + '0'.toInt()).toChar()
-        carry = sum / 2
-    }
-
-    // Handle the carry
-    if (carry != 0) {
-        for (l in blockSize - 1 downTo 0) {
-            val sum = (resultArray[l] - '0') + carry
-            resultArray[l] = (sum % 2 + '0'.toInt()).toChar()
-            carry = sum / 2
-            if (carry == 0) break
-        }
+fun crc8Update(crc: Int, data: ByteArray, offset: Int = 0, length: Int = data.size - offset): Int {
+    var result = crc
+    for (index in offset until offset + length) {
+        result = CRC8_TABLE[result xor (data[index].toInt() and 0xFF)]
     }
-    return resultArray.concatToString()
+    return result
 }
 
 /**
- * checkSum is a function that calculates the checksum of a given binary string by breaking it into blocks, performing binary addition on each block,
- * and then applying a one's complement to the result. This checksum is typically used to verify the integrity of data during transmission.
+ * crc8 is a function that calculates the CRC-8 over the first `length` bytes of a byte array with `crc8Update`.
  *
  * **Parameters:**
  *
- * - `data`: A `String` representing the binary data for which the checksum will be calculated.
- * - `blockSize`: An `Int` representing the size of the blocks in which the binary data will be divided for the checksum calculation.
+ * - `data`: A `ByteArray` holding the bytes to be checked.
+ * - `length`: An `Int` specifying how many bytes from the start of `data` are included. The default value is the full array.
  *
  * **Returns:**
  *
- * - `String`: Returns the one's complement of the binary addition result as a binary string, which serves as the checksum.
+ * - `Int`: Returns the CRC-8 of the bytes, in the range 0..255.
+ */
+fun crc8(data: ByteArray, length: Int = data.size): Int {
+    return crc8Update(0, data, 0, length)
+}
+
+/**
+ * crc16Update is a function that feeds a block of bytes into a running CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF).
+ * It matches `crc16Update` in the firmware.
  *
- * **Functionality:**
+ * **Parameters:**
+ *
+ * - `crc`: An `Int` holding the running CRC. Start with `0xFFFF`.
+ * - `data`: A `ByteArray` holding the bytes to be checked.
+ * - `offset`: An `Int` index of the first byte. The default value is `0`.
+ * - `length`: An `Int` number of bytes. The default value is the rest of the array.
  *
- * - The function pads the input binary string with leading zeros if its length is not a multiple of `blockSize`.
- * - It initializes the result with the first block of the padded data.
- * - The function then iterates over the remaining blocks, performing binary addition of each block to the cumulative result.
- * - After processing all blocks, the function calculates the one's complement of the result, which is returned as the checksum.
+ * **Returns:**
  *
- * - This function is typically used in data integrity checks, where the checksum is appended to data before transmission, allowing the receiver to verify that the data has not been altered.
+ * - `Int`: Returns the updated CRC, in the range 0..65535.
  */
-fun checkSum(data: String, blockSize: Int): String {
-    var paddedData = data
-    val n = data.length
-
-    // Pad with leading zeros if necessary
-    val padSize = blockSize - (n % blockSize)
-    if (padSize != blockSize) {
-        paddedData = "0".repeat(padSize) + data
+fun crc16Update(crc: Int, data: ByteArray, offset: Int = 0, length: Int = data.size - offset): Int {
+    var result = crc
+    for (index in offset until offset + length) {
+        result = ((result shl 8) and 0xFFFF) xor CRC16_TABLE[(result shr 8) xor (data[index].toInt() and 0xFF)]
     }
-
-    // Initialize the result with the first block
-    var result = paddedData.substring(0, blockSize)
-
-    // Process each block
-    for (i in blockSize until paddedData.length step blockSize) {
-        result = binaryAdd(result, paddedData.substring(i, i + blockSize), blockSize)
-    }
-
-    // Compute one's complement
-    return onesComplement(result)
+    return result
 }
 
 /**
- * hexStringToBinaryString is a function that converts a hexadecimal string into its equivalent binary string representation.
- * Each hexadecimal digit is translated into a 4-bit binary sequence.
+ * crc16 is a function that calculates the CRC-16/CCITT-FALSE over the first `length` bytes of a byte array with `crc16Update`.
  *
  * **Parameters:**
  *
- * - `hexString`: A `String` representing the hexadecimal data to be converted to binary.
+ * - `data`: A `ByteArray` holding the bytes to be checked.
+ * - `length`: An `Int` specifying how many bytes from the start of `data` are included. The default value is the full array.
  *
  * **Returns:**
  *
- * - `String`: Returns a binary string equivalent to the input hexadecimal string, where each hex digit is converted into a 4-bit binary sequence.
- *
- * **Functionality:**
- *
- * - The function iterates over each character in the input `hexString`.
- * - For each character, it appends the corresponding 4-bit binary string to the `binaryString` variable.
- * - The conversion accounts for both uppercase and lowercase hexadecimal digits.
- * - If an invalid hexadecimal character is encountered, the function throws an `IllegalArgumentException`.
- *
- * - This function is typically used when binary data needs to be processed in its binary form but is originally provided in a hexadecimal format.
+ * - `Int`: Returns the CRC-16 of the bytes, in the range 0..65535.
  */
-fun hexStringToBinaryString(hexString: String): String {
-    var binaryString = ""
-    for (char in hexString) {
-        binaryString += when (char) {
-            '0' -> "0000"
-            '1' -> "0001"
-            '2' -> "0010"
-            '3' -> "0011"
-            '4' -> "0100"
-            '5' -> "0101"
-            '6' -> "0110"
-            '7' -> "0111"
-            '8' -> "1000"
-            '9' -> "1001"
-            'a', 'A' -> "1010"
-            'b', 'B' -> "1011"
-            'c', 'C' -> "1100"
-            'd', 'D' -> "1101"
-            'e', 'E' -> "1110"
-            'f', 'F' -> "1111"
-            else -> throw IllegalArgumentException("Invalid hex character")
-        }
-    }
-    return binaryString
-}
\ No newline at end of file
+fun crc16(data: ByteArray, length: Int = data.size): Int {
+    return crc16Update(0xFFFF, data, 0, length)
+}
@@ -0,0 +1,172 @@
+package com.example.projectcolor.components
+
+const val COLOR_DEPTH_RGB888 = 0x00
+const val COLOR_DEPTH_RGB565 = 0x01
+const val COLOR_DEPTH_RGB444 = 0x02
+const val COLOR_DEPTH_RGB332 = 0x03
+const val PACKED_HEADER_SIZE = 3
+
+/**
+ * COLOR_DEPTH_BITS holds the bits per red, green and blue component of every `COLOR_DEPTH_*` value, ordered from the smallest
+ * encoding to the largest.
+ */
+private val COLOR_DEPTH_BITS = linkedMapOf(
+    COLOR_DEPTH_RGB332 to intArrayOf(3, 3, 2),
+    COLOR_DEPTH_RGB444 to intArrayOf(4, 4, 4),
+    COLOR_DEPTH_RGB565 to intArrayOf(5, 6, 5),
+    COLOR_DEPTH_RGB888 to intArrayOf(8, 8, 8),
+)
+
+/**
+ * expandComponent is a function that expands an n-bit color component to 8 bits by bit replication, the same way the `EXPAND_*BIT`
+ * tables of the firmware do.
+ *
+ * **Parameters:**
+ *
+ * - `value`: An `Int` holding the reduced component.
+ * - `bits`: An `Int` holding the width of the component, between 1 and 8.
+ *
+ * **Returns:**
+ *
+ * - `Int`: Returns the expanded component, in the range 0..255.
+ */
+fun expandComponent(value: Int, bits: Int): Int {
+    var result = 0
+    var shift = 8 - bits
+    while (shift > -bits) {
+        result = result or (if (shift >= 0) value shl shift else value shr -shift)
+        shift -= bits
+    }
+    return result and 0xFF
+}
+
+/**
+ * losslessColorDepth is a function that picks the smallest color depth in which every color of a frame survives quantisation unchanged.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed `0xRRGGBB` colors of the frame.
+ *
+ * **Returns:**
+ *
+ * - `Int`: Returns one of the `COLOR_DEPTH_*` values; `COLOR_DEPTH_RGB888` if no reduced depth is lossless.
+ *
+ * **Functionality:**
+ *
+ * - A component survives if expanding its upper bits with `expandComponent` gives back the original value, for example 0xCC in RGB444.
+ */
+fun losslessColorDepth(colors: IntArray): Int {
+    val distinct = colors.toSet()
+    for ((depth, bits) in COLOR_DEPTH_BITS) {
+        val lossless = distinct.all { color ->
+            (0 until 3).all { component ->
+                val value = (color shr (16 - 8 * component)) and 0xFF
+                expandComponent(value shr (8 - bits[component]), bits[component]) == value
+            }
+        }
+        if (lossless) {
+            return depth
+        }
+    }
+    return COLOR_DEPTH_RGB888
+}
+
+/**
+ * packedColorBytes is a function that returns how many bytes a run of pixels takes in a given color depth.
+ *
+ * **Parameters:**
+ *
+ * - `depth`: An `Int` holding one of the `COLOR_DEPTH_*` values.
+ * - `count`: An `Int` specifying the number of pixels.
+ *
+ * **Returns:**
+ *
+ * - `Int`: Returns the number of bytes.
+ */
+fun packedColorBytes(depth: Int, count: Int): Int {
+    return when (depth) {
+        COLOR_DEPTH_RGB565 -> count * 2
+        COLOR_DEPTH_RGB444 -> (count * 3 + 1) / 2
+        COLOR_DEPTH_RGB332 -> count
+        else -> count * 3
+    }
+}
+
+/**
+ * buildPackedFrames is a function that wraps a frame into `FRAME_TYPE_PIXELS_PACKED` frames with a reduced color depth.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the frame, as returned by `matrixColors` for a grid with 16 columns, so that
+ *   the array index of a pixel equals its position `(row shl 4) + column`.
+ * - `depth`: An `Int` holding one of the `COLOR_DEPTH_*` values, usually the result of `losslessColorDepth`.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the complete frames, as built by `buildFrame`.
+ *
+ * **Functionality:**
+ *
+ * - Every frame starts with the position of its first pixel, the depth and the pixel count, and is filled up to `FRAME_MAX_PAYLOAD`.
+ * - RGB565 is stored big-endian; RGB444 packs two pixels into three bytes; RGB332 takes one byte per pixel.
+ */
+fun buildPackedFrames(colors: IntArray, depth: Int): List<ByteArray> {
+    var pixelsPerFrame = FRAME_MAX_PAYLOAD - PACKED_HEADER_SIZE
+    while (packedColorBytes(depth, pixelsPerFrame) > FRAME_MAX_PAYLOAD - PACKED_HEADER_SIZE) {
+        pixelsPerFrame--
+    }
+
+    return (colors.indices step pixelsPerFrame).map { first ->
+        val count = minOf(pixelsPerFrame, colors.size - first)
+        val payload = ByteArray(PACKED_HEADER_SIZE + packedColorBytes(depth, count))
+        payload[0] = first.toByte()
+        payload[1] = depth.toByte()
+        payload[2] = count.toByte()
+        for (i in 0 until count) {
+            packColor(colors[first + i], depth, payload, PACKED_HEADER_SIZE, i)
+        }
+        buildFrame(FRAME_TYPE_PIXELS_PACKED, payload)
+    }
+}
+
+/**
+ * packColor is a function that writes the `i`-th pixel of a run into packed color data.
+ *
+ * **Parameters:**
+ *
+ * - `color`: An `Int` holding the packed `0xRRGGBB` color.
+ * - `depth`: An `Int` holding one of the `COLOR_DEPTH_*` values.
+ * - `output`: A `ByteArray` receiving the packed colors. Bytes shared by two RGB444 pixels must start out as zero.
+ * - `offset`: An `Int` index of the first packed byte of the run in `output`.
+ * - `i`: An `Int` holding the number of the pixel in the run.
+ */
+fun packColor(color: Int, depth: Int, output: ByteArray, offset: Int, i: Int) {
+    val r = (color shr 16) and 0xFF
+    val g = (color shr 8) and 0xFF
+    val b = color and 0xFF
+    when (depth) {
+        COLOR_DEPTH_RGB565 -> {
+            val value = ((r shr 3) shl 11) or ((g shr 2) shl 5) or (b shr 3)
+            output[offset + 2 * i] = (value shr 8).toByte()
+            output[offset + 2 * i + 1] = value.toByte()
+        }
+        COLOR_DEPTH_RGB444 -> {
+            val base = offset + 3 * (i / 2)
+            if (i % 2 == 0) {
+                output[base] = ((r shr 4 shl 4) or (g shr 4)).toByte()
+                output[base + 1] = ((output[base + 1].toInt() and 0x0F) or (b shr 4 shl 4)).toByte()
+            } else {
+                output[base + 1] = ((output[base + 1].toInt() and 0xF0) or (r shr 4)).toByte()
+                output[base + 2] = ((g shr 4 shl 4) or (b shr 4)).toByte()
+            }
+        }
+        COLOR_DEPTH_RGB332 -> {
+            output[offset + i] = ((r shr 5 shl 5) or (g shr 5 shl 2) or (b shr 6)).toByte()
+        }
+        else -> {
+            output[offset + 3 * i] = r.toByte()
+            output[offset + 3 * i + 1] = g.toByte()
+            output[offset + 3 * i + 2] = b.toByte()
+        }
+    }
+}
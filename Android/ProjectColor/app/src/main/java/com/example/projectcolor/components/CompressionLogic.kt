@@ -0,0 +1,189 @@
+package com.example.projectcolor.components
+
+const val COMPRESSED_HEADER_SIZE = 2
+const val CODEC_RLE = 0x01
+const val CODEC_LZ = 0x02
+const val LZ_LITERAL_FLAG = 0x80
+const val LZ_WINDOW_PIXELS = 255
+const val LZ_MAX_MATCH = 128
+const val LZ_MAX_LITERALS = (FRAME_MAX_PAYLOAD - COMPRESSED_HEADER_SIZE - 1) / 3
+
+/**
+ * encodeRle is a function that splits a frame into `CODEC_RLE` tokens: a run length (1..255) followed by the R, G, B bytes of the run.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the frame, indexed by pixel position.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns one `ByteArray` per token, in pixel order.
+ */
+fun encodeRle(colors: IntArray): List<ByteArray> {
+    val tokens = mutableListOf<ByteArray>()
+    var index = 0
+    while (index < colors.size) {
+        var run = 1
+        while (index + run < colors.size && run < 255 && colors[index + run] == colors[index]) {
+            run++
+        }
+        tokens.add(byteArrayOf(run.toByte()) + colorBytes(colors[index]))
+        index += run
+    }
+    return tokens
+}
+
+/**
+ * encodeLz is a function that splits a frame into `CODEC_LZ` tokens: literal runs of pixels and matches that copy earlier pixels.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the frame, indexed by pixel position.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns one `ByteArray` per token, in pixel order.
+ *
+ * **Functionality:**
+ *
+ * - At every pixel the longest match within the last `LZ_WINDOW_PIXELS` pixels is searched (greedy parsing). A match is written as
+ *   `LZ_LITERAL_FLAG - 1 + length` and the distance back, two bytes for up to `LZ_MAX_MATCH` pixels; the source may overlap the pixels
+ *   being written.
+ * - Pixels without a match are collected into literal runs of up to `LZ_MAX_LITERALS` pixels, so every token fits into one frame.
+ */
+fun encodeLz(colors: IntArray): List<ByteArray> {
+    val tokens = mutableListOf<ByteArray>()
+    val literals = mutableListOf<Int>()
+
+    fun flushLiterals() {
+        if (literals.isNotEmpty()) {
+            tokens.add(byteArrayOf((literals.size - 1).toByte()) + literals.flatMap { colorBytes(it).toList() })
+            literals.clear()
+        }
+    }
+
+    var index = 0
+    while (index < colors.size) {
+        var bestLength = 0
+        var bestDistance = 0
+        for (distance in 1..minOf(LZ_WINDOW_PIXELS, index)) {
+            var length = 0
+            while (length < LZ_MAX_MATCH && index + length < colors.size &&
+                colors[index + length] == colors[index + length - distance]) {
+                length++
+            }
+            if (length > bestLength) {
+                bestLength = length
+                bestDistance = distance
+            }
+        }
+
+        if (bestLength > 0) {
+            flushLiterals()
+            tokens.add(byteArrayOf((LZ_LITERAL_FLAG - 1 + bestLength).toByte(), bestDistance.toByte()))
+            index += bestLength
+        } else {
+            literals.add(colors[index])
+            if (literals.size == LZ_MAX_LITERALS) {
+                flushLiterals()
+            }
+            index++
+        }
+    }
+    flushLiterals()
+    return tokens
+}
+
+/**
+ * buildCompressedFrames is a function that compresses a frame with both codecs and wraps the smaller result into
+ * `FRAME_TYPE_PIXELS_COMPRESSED` frames.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the frame, as returned by `matrixColors` for a grid with 16 columns, so that
+ *   the array index of a pixel equals its position `(row shl 4) + column`.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the complete frames, as built by `buildFrame`.
+ *
+ * **Functionality:**
+ *
+ * - The payloads come from `compressedPayloads`, so every frame can be decoded on its own.
+ */
+fun buildCompressedFrames(colors: IntArray): List<ByteArray> {
+    return compressedPayloads(colors).map { buildFrame(FRAME_TYPE_PIXELS_COMPRESSED, it) }
+}
+
+/**
+ * compressedPayloads is a function that compresses a run of consecutive pixels with both codecs and splits the smaller result into
+ * `FRAME_TYPE_PIXELS_COMPRESSED` payloads.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the run.
+ * - `firstPosition`: An `Int` holding the position of the first pixel of the run, 0 for a whole frame.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the payloads, each starting with the position of its first pixel and the codec.
+ *
+ * **Functionality:**
+ *
+ * - `encodeRle` and `encodeLz` are both run and the codec with fewer token bytes is used for this run.
+ * - Every payload holds whole tokens up to `FRAME_MAX_PAYLOAD`. LZ matches only refer to pixels of the same run, which the firmware
+ *   has decoded before, so a run can be placed anywhere on the panel.
+ */
+fun compressedPayloads(colors: IntArray, firstPosition: Int = 0): List<ByteArray> {
+    val rleTokens = encodeRle(colors)
+    val lzTokens = encodeLz(colors)
+    val useLz = lzTokens.sumOf { it.size } < rleTokens.sumOf { it.size }
+    val tokens = if (useLz) lzTokens else rleTokens
+    val codec = if (useLz) CODEC_LZ else CODEC_RLE
+
+    val payloads = mutableListOf<ByteArray>()
+    var payload = mutableListOf<Byte>()
+    var position = firstPosition
+    for (token in tokens) {
+        if (payload.isNotEmpty() && payload.size + token.size > FRAME_MAX_PAYLOAD) {
+            payloads.add(payload.toByteArray())
+            payload = mutableListOf()
+        }
+        if (payload.isEmpty()) {
+            payload.add(position.toByte())
+            payload.add(codec.toByte())
+        }
+        payload.addAll(token.toList())
+        position += tokenPixels(token, codec)
+    }
+    if (payload.isNotEmpty()) {
+        payloads.add(payload.toByteArray())
+    }
+    return payloads
+}
+
+/**
+ * tokenPixels is a function that returns the number of pixels a single codec token decodes to.
+ *
+ * **Parameters:**
+ *
+ * - `token`: A `ByteArray` holding one token, as returned by `encodeRle` or `encodeLz`.
+ * - `codec`: An `Int` holding the codec of the token, `CODEC_RLE` or `CODEC_LZ`.
+ *
+ * **Returns:**
+ *
+ * - `Int`: Returns the number of pixels.
+ */
+fun tokenPixels(token: ByteArray, codec: Int): Int {
+    val control = token[0].toInt() and 0xFF
+    return when {
+        codec == CODEC_RLE -> control
+        control < LZ_LITERAL_FLAG -> control + 1
+        else -> control - (LZ_LITERAL_FLAG - 1)
+    }
+}
+
+/** `colorBytes(color: Int)`: Returns the R, G, B bytes of a packed `0xRRGGBB` color. */
+fun colorBytes(color: Int): ByteArray {
+    return byteArrayOf((color shr 16).toByte(), (color shr 8).toByte(), color.toByte())
+}
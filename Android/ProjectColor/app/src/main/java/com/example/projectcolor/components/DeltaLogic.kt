@@ -0,0 +1,124 @@
+package com.example.projectcolor.components
+
+import androidx.compose.runtime.MutableState
+import com.example.projectcolor.RGBMatrix
+
+const val GENERATION_UNKNOWN = 0
+const val DELTA_SPAN_HEADER_SIZE = 2
+
+/**
+ * CommittedFrame is an object that remembers the last frame the firmware confirmed with "fin-ack", so the next Send only has to
+ * transmit the pixels that changed since then.
+ *
+ * - `generation`: The generation ID (1..255) the frame was committed with, or `GENERATION_UNKNOWN` if no frame is known.
+ * - `colors`: The packed RGB colors of the committed frame, as returned by `matrixColors`, or `null`.
+ */
+object CommittedFrame {
+    var generation = GENERATION_UNKNOWN
+    var colors: IntArray? = null
+
+    /** `nextGeneration()`: Returns the generation ID for the next committed frame, skipping `GENERATION_UNKNOWN`. */
+    fun nextGeneration(): Int {
+        return if (generation in 1 until 255) generation + 1 else 1
+    }
+
+    /** `commit(generation: Int, colors: IntArray)`: Records the frame confirmed by the firmware. */
+    fun commit(generation: Int, colors: IntArray) {
+        this.generation = generation
+        this.colors = colors
+    }
+
+    /** `forget()`: Drops the committed frame, so the next Send transmits a full frame. */
+    fun forget() {
+        generation = GENERATION_UNKNOWN
+        colors = null
+    }
+}
+
+/**
+ * matrixColors is a function that packs the colors of a pixel grid into one `Int` per pixel, for cheap comparison of two frames.
+ *
+ * **Parameters:**
+ *
+ * - `matrix`: A `MutableState<RGBMatrix>` representing the pixel grid data.
+ *
+ * **Returns:**
+ *
+ * - `IntArray`: Returns `0xRRGGBB` per pixel, indexed by `row * width + column`, with the same byte values `quarterRowBytes` sends.
+ */
+fun matrixColors(matrix: MutableState<RGBMatrix>): IntArray {
+    val width = matrix.value.width
+    val colors = IntArray(width * matrix.value.height)
+    for (row in 0 until matrix.value.height) {
+        for (column in 0 until width) {
+            val pixel = matrix.value.getPixel(row, column)
+            colors[row * width + column] = ((pixel.red * 255f).toInt() shl 16) or
+                    ((pixel.green * 255f).toInt() shl 8) or
+                    (pixel.blue * 255f).toInt()
+        }
+    }
+    return colors
+}
+
+/**
+ * buildDeltaFrames is a function that describes the difference between two frames as a list of `FRAME_TYPE_PIXELS_DELTA` frames.
+ *
+ * **Parameters:**
+ *
+ * - `current`: An `IntArray` holding the colors of the frame to be shown, as returned by `matrixColors`.
+ * - `base`: An `IntArray` holding the colors of the committed frame the firmware holds.
+ * - `baseGeneration`: An `Int` holding the generation ID of `base`. The firmware rejects the delta if it holds another generation.
+ * - `width`: An `Int` holding the number of columns of the grid.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the complete frames, as built by `buildFrame`. The list is empty if nothing changed.
+ *
+ * **Functionality:**
+ *
+ * - Changed pixels are grouped into spans of neighbouring pixels within a row. A span is written as the position of its first pixel
+ *   (`(row shl 4) + column`), the number of pixels, and the R, G, B bytes of each pixel.
+ * - Every frame starts with `baseGeneration` and is filled with spans up to `FRAME_MAX_PAYLOAD` bytes; a span that does not fit is
+ *   split across frames.
+ */
+fun buildDeltaFrames(current: IntArray, base: IntArray, baseGeneration: Int, width: Int): List<ByteArray> {
+    val frames = mutableListOf<ByteArray>()
+    val payload = ArrayList<Byte>(FRAME_MAX_PAYLOAD)
+    var spanCountIndex = -1
+    var previousIndex = -2
+
+    fun flush() {
+        if (payload.size > 1) {
+            frames.add(buildFrame(FRAME_TYPE_PIXELS_DELTA, payload.toByteArray()))
+        }
+        payload.clear()
+        payload.add(baseGeneration.toByte())
+        spanCountIndex = -1
+    }
+
+    flush()
+    for (index in current.indices) {
+        if (current[index] == base[index]) {
+            continue
+        }
+        val row = index / width
+        val column = index % width
+        val continuesSpan = spanCountIndex >= 0 && index == previousIndex + 1 && column != 0
+
+        if (payload.size + 3 + (if (continuesSpan) 0 else DELTA_SPAN_HEADER_SIZE) > FRAME_MAX_PAYLOAD) {
+            flush()
+        }
+        if (!continuesSpan || spanCountIndex < 0) {
+            payload.add(((row shl 4) + column).toByte())
+            spanCountIndex = payload.size
+            payload.add(0)
+        }
+        payload[spanCountIndex] = (payload[spanCountIndex] + 1).toByte()
+        payload.add((current[index] shr 16).toByte())
+        payload.add((current[index] shr 8).toByte())
+        payload.add(current[index].toByte())
+        previousIndex = index
+    }
+    flush()
+    return frames
+}
@@ -0,0 +1,123 @@
+package com.example.projectcolor.components
+
+import android.content.Context
+import android.widget.Toast
+import androidx.compose.foundation.layout.Column
+import androidx.compose.foundation.layout.Row
+import androidx.compose.foundation.layout.padding
+import androidx.compose.material3.Button
+import androidx.compose.material3.Slider
+import androidx.compose.material3.Text
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableFloatStateOf
+import androidx.compose.runtime.mutableIntStateOf
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.setValue
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.platform.LocalContext
+import androidx.compose.ui.unit.dp
+import com.example.projectcolor.bluetooth.BluetoothManager
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+
+/**
+ * EffectButtons is a Composable function that starts, tunes and stops the procedural effects rendered by the device itself. Only a
+ * command of a few bytes is sent per change, instead of the pixels of every frame.
+ *
+ * **Parameters:**
+ *
+ * - `modifier`: A `Modifier` applied to the column of controls. The default value is `Modifier`.
+ * - `bluetoothManager`: A `BluetoothManager` instance used to send the effect commands.
+ *
+ * **UI Structure:**
+ *
+ * - A row of buttons for the rainbow, plasma, fire, noise and scroll effects, each starting its effect with a fitting palette, and
+ *   a "Stop" button that keeps the last frame on the panel.
+ * - A speed slider. Releasing it sends the new speed to the running effect, which keeps its time so the picture does not jump.
+ *
+ * - All controls are enabled only while a Bluetooth device is connected. The commands are sent with `sendEffectCommand` on the IO
+ *   dispatcher; a failure is reported with a Toast.
+ */
+@Composable
+fun EffectButtons(
+    modifier: Modifier = Modifier,
+    bluetoothManager: BluetoothManager,
+) {
+    val isBluetoothConnected = bluetoothManager.isConnected()
+    val context = LocalContext.current
+    var runningEffect by remember { mutableIntStateOf(0) }
+    var runningPalette by remember { mutableIntStateOf(EFFECT_PALETTE_RAINBOW) }
+    var speed by remember { mutableFloatStateOf(16f) }
+    val effects = listOf(
+        Triple("Rainbow", EFFECT_RAINBOW, EFFECT_PALETTE_RAINBOW),
+        Triple("Plasma", EFFECT_PLASMA, EFFECT_PALETTE_PARTY),
+        Triple("Fire", EFFECT_FIRE, EFFECT_PALETTE_HEAT),
+        Triple("Noise", EFFECT_NOISE, EFFECT_PALETTE_OCEAN),
+        Triple("Scroll", EFFECT_SCROLL, EFFECT_PALETTE_RAINBOW),
+    )
+
+    Column(modifier = modifier.padding(horizontal = 16.dp)) {
+        Row {
+            for ((label, effect, palette) in effects) {
+                Button(
+                    modifier = Modifier
+                        .weight(1f)
+                        .padding(horizontal = 2.dp),
+                    onClick = {
+                        runningEffect = effect
+                        runningPalette = palette
+                        sendEffect(effectCommand(effect, speed.toInt(), palette, 0), bluetoothManager, context)
+                    },
+                    enabled = isBluetoothConnected
+                ) {
+                    Text(text = label, maxLines = 1)
+                }
+            }
+            Button(
+                modifier = Modifier
+                    .weight(1f)
+                    .padding(horizontal = 2.dp),
+                onClick = {
+                    runningEffect = 0
+                    sendEffect(FX_STOP, bluetoothManager, context)
+                },
+                enabled = isBluetoothConnected
+            ) {
+                Text(text = "Stop", maxLines = 1)
+            }
+        }
+        Slider(
+            value = speed,
+            onValueChange = { speed = it },
+            onValueChangeFinished = {
+                if (runningEffect != 0) {
+                    sendEffect(effectCommand(runningEffect, speed.toInt(), runningPalette, 0), bluetoothManager, context)
+                }
+            },
+            valueRange = 0f..255f,
+            enabled = isBluetoothConnected
+        )
+    }
+}
+
+/**
+ * sendEffect is a function that sends an effect command off the main thread and reports a failure with a Toast.
+ *
+ * **Parameters:**
+ *
+ * - `command`: A `String` holding the command, see `sendEffectCommand`.
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `context`: A `Context` used to display the Toast.
+ */
+private fun sendEffect(command: String, bluetoothManager: BluetoothManager, context: Context) {
+    CoroutineScope(Dispatchers.IO).launch {
+        if (!sendEffectCommand(command, bluetoothManager)) {
+            withContext(Dispatchers.Main) {
+                Toast.makeText(context, "The device did not accept the effect.", Toast.LENGTH_SHORT).show()
+            }
+        }
+    }
+}
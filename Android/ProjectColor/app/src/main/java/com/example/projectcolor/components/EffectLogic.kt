@@ -0,0 +1,120 @@
+package com.example.projectcolor.components
+
+import android.util.Log
+import com.example.projectcolor.bluetooth.BluetoothManager
+import kotlinx.coroutines.delay
+
+const val EFFECT_GRADIENT = 0x01
+const val EFFECT_RAINBOW = 0x02
+const val EFFECT_PLASMA = 0x03
+const val EFFECT_FIRE = 0x04
+const val EFFECT_NOISE = 0x05
+const val EFFECT_SCROLL = 0x06
+
+const val EFFECT_PALETTE_RAINBOW = 0x00
+const val EFFECT_PALETTE_PARTY = 0x01
+const val EFFECT_PALETTE_OCEAN = 0x02
+const val EFFECT_PALETTE_FOREST = 0x03
+const val EFFECT_PALETTE_LAVA = 0x04
+const val EFFECT_PALETTE_HEAT = 0x05
+const val EFFECT_PALETTE_CLOUD = 0x06
+
+const val FX_PREFIX = "fx:"
+const val FX_STOP = "fx-stop"
+const val FX_ACK = "fx-ack"
+const val PLAYBACK_WAKE_NEWLINES = 16
+const val PLAYBACK_WAKE_PAUSE_MILLIS = 30L
+
+/**
+ * effectCommand is a function that builds the "fx:" command that starts or tunes a procedural effect on the device.
+ *
+ * **Parameters:**
+ *
+ * - `effect`: An `Int` holding one of the `EFFECT_*` values.
+ * - `speed`: An `Int` 0..255; the time advance per frame, 0 freezes the effect.
+ * - `palette`: An `Int` holding one of the `EFFECT_PALETTE_*` values.
+ * - `seed`: An `Int` 0..255 that offsets the pattern.
+ *
+ * **Returns:**
+ *
+ * - `String`: Returns "fx:<effect>:<speed>:<palette>:<seed>" with two hex digits per field, 14 bytes on the wire.
+ */
+fun effectCommand(effect: Int, speed: Int, palette: Int, seed: Int): String {
+    return FX_PREFIX + "%02x:%02x:%02x:%02x".format(effect, speed and 0xFF, palette, seed and 0xFF)
+}
+
+/**
+ * wakePlayback is a function that makes a device that plays an animation or effect listen before a command is sent.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used to send the newlines.
+ * - `pauseMillis`: A `Long` holding how long to wait afterwards. The default value is `PLAYBACK_WAKE_PAUSE_MILLIS`.
+ *
+ * **Functionality:**
+ *
+ * - Sends the newlines with `sendWakeNewlines`, then waits `pauseMillis` for a refresh in progress to finish, suspending rather
+ *   than blocking the thread.
+ * - Harmless for a device that plays nothing.
+ */
+suspend fun wakePlayback(bluetoothManager: BluetoothManager, pauseMillis: Long = PLAYBACK_WAKE_PAUSE_MILLIS) {
+    sendWakeNewlines(bluetoothManager)
+    if (pauseMillis > 0) {
+        delay(pauseMillis)
+    }
+}
+
+/**
+ * sendWakeNewlines is a function that sends the newlines of `wakePlayback` without waiting afterwards, for a command that follows
+ * right away and gets no reply.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used to send the newlines.
+ *
+ * **Functionality:**
+ *
+ * - The device drops every byte that arrives during a display refresh (about 8 ms). `PLAYBACK_WAKE_NEWLINES` empty lines span
+ *   more than one refresh at 9600 baud, so some of them arrive; the device ignores empty lines but pauses playback once the line is
+ *   busy. A command sent right after them still arrives as long as the newlines outlast the refresh.
+ */
+fun sendWakeNewlines(bluetoothManager: BluetoothManager) {
+    bluetoothManager.sendBytes(ByteArray(PLAYBACK_WAKE_NEWLINES) { '\n'.code.toByte() })
+}
+
+/**
+ * sendEffectCommand is a function that sends an effect command to the device and waits for its acknowledgment.
+ *
+ * **Parameters:**
+ *
+ * - `command`: A `String` holding the command, as built by `effectCommand`, or `FX_STOP`.
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `timeoutMillis`: A `Long` holding how long to wait for each reply. The default value is `2000L`.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` once "fx-ack" arrives. "fx-fail" (unknown effect or palette) and "Unknown message" from firmware without
+ *   effects end the attempts right away.
+ *
+ * **Functionality:**
+ *
+ * - Every attempt wakes the device with `wakePlayback` first, since a running effect may be refreshing the panel. Up to three
+ *   attempts are made.
+ */
+suspend fun sendEffectCommand(command: String, bluetoothManager: BluetoothManager, timeoutMillis: Long = 2000L): Boolean {
+    for (attempt in 0 until 3) {
+        wakePlayback(bluetoothManager)
+        bluetoothManager.sendData(command)
+        val response = bluetoothManager.receiveData(timeoutMillis)
+        when {
+            response == FX_ACK -> return true
+            response != null && response.startsWith("Unknown message") -> {
+                Log.d("EffectLogic", "The device has no effect engine")
+                return false
+            }
+            response != null && response.startsWith("fx-fail") -> return false
+        }
+        Log.d("EffectLogic", "No acknowledgment for $command, received: $response")
+    }
+    return false
+}
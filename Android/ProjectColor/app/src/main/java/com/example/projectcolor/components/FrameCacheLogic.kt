@@ -0,0 +1,150 @@
+package com.example.projectcolor.components
+
+import android.util.Log
+import com.example.projectcolor.bluetooth.BluetoothManager
+
+const val CACHE_SHOW_PREFIX = "cache-show:"
+const val CACHE_PUT_PREFIX = "cache-put:"
+const val CACHE_LIST = "cache-list"
+const val CACHE_REPORT_PREFIX = "cache:"
+const val CACHE_HIT = "cache-hit"
+const val CACHE_MISS = "cache-miss"
+const val CACHE_FAIL = "cache-fail"
+
+/**
+ * FrameCache is an object that mirrors the frame cache of the device (`PROTO_CAP_CACHE`): the hashes of the frames it holds, most
+ * recently used first, as its last "cache:" report listed them.
+ *
+ * - `hashes`: The hashes, or `null` while the device was not asked yet. The mirror may be stale, e.g. after another phone stored
+ *   frames; a "cache-miss" then corrects it, so it never costs more than the transfer that follows.
+ */
+object FrameCache {
+    var hashes: List<Int>? = null
+
+    /** `holds(hash: Int)`: Returns `true` if the device holds the frame according to the mirror. */
+    fun holds(hash: Int): Boolean {
+        return hashes?.contains(hash) == true
+    }
+
+    /** `forget(hash: Int)`: Drops a frame the device answered "cache-miss" for. */
+    fun forget(hash: Int) {
+        hashes = hashes?.minus(hash)
+    }
+}
+
+/**
+ * frameHash is a function that computes the key of a frame in the device's cache: the CRC-16/CCITT-FALSE over R, G, B of every
+ * pixel in position order, like `frameCacheHash` in the firmware.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding `0xRRGGBB` per pixel, as returned by `matrixColors`; for the 16x16 panel its index is the position.
+ *
+ * **Returns:**
+ *
+ * - `Int`: Returns the hash, 0..0xFFFF.
+ */
+fun frameHash(colors: IntArray): Int {
+    var crc = 0xFFFF
+    for (color in colors) {
+        crc = crc16Update(crc, colorBytes(color))
+    }
+    return crc
+}
+
+/**
+ * parseCacheReport is a function that reads a "cache:<free bytes>:<hash>:<hash>..." report, all fields in hex.
+ *
+ * **Parameters:**
+ *
+ * - `response`: A `String?` holding what `receiveData` returned.
+ *
+ * **Returns:**
+ *
+ * - `List<Int>?`: Returns the hashes, most recently used first, or `null` if the response is no report.
+ */
+fun parseCacheReport(response: String?): List<Int>? {
+    val fields = response?.lines()?.map { it.trim() }?.firstOrNull { it.startsWith(CACHE_REPORT_PREFIX) }
+        ?.removePrefix(CACHE_REPORT_PREFIX)?.split(":")?.map { it.toIntOrNull(16) } ?: return null
+    if (fields.any { it == null }) {
+        return null
+    }
+    return fields.drop(1).map { it!! }
+}
+
+/**
+ * syncFrameCache is a function that fills the mirror with "cache-list" the first time a device with `PROTO_CAP_CACHE` is met.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `timeoutMillis`: A `Long` holding how long to wait for the report.
+ */
+suspend fun syncFrameCache(bluetoothManager: BluetoothManager, timeoutMillis: Long) {
+    if (FrameCache.hashes != null) {
+        return
+    }
+    bluetoothManager.sendData(CACHE_LIST)
+    FrameCache.hashes = parseCacheReport(bluetoothManager.receiveData(timeoutMillis))
+}
+
+/**
+ * showCachedFrame is a function that asks the device to show a frame from its cache instead of receiving it.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `hash`: An `Int` holding the `frameHash` of the frame.
+ * - `generation`: An `Int` holding the generation ID the frame is committed with, or `GENERATION_UNKNOWN` without `PROTO_CAP_DELTA`.
+ * - `timeoutMillis`: A `Long` holding how long to wait for the answer.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` if the device showed the frame ("cache-hit"). The frame is then committed like after "fin-ack".
+ *
+ * **Functionality:**
+ *
+ * - Only frames the mirror lists are asked for. On "cache-miss" the hash is dropped from the mirror and the caller sends the frame.
+ */
+suspend fun showCachedFrame(bluetoothManager: BluetoothManager, hash: Int, generation: Int, timeoutMillis: Long): Boolean {
+    if (!FrameCache.holds(hash)) {
+        return false
+    }
+    bluetoothManager.sendData(
+        if (generation != GENERATION_UNKNOWN) CACHE_SHOW_PREFIX + "%04x:%02x".format(hash, generation)
+        else CACHE_SHOW_PREFIX + "%04x".format(hash)
+    )
+    val response = bluetoothManager.receiveData(timeoutMillis)
+    if (response?.trim() == CACHE_HIT) {
+        return true
+    }
+    Log.d("FrameCacheLogic", "Frame ${"%04x".format(hash)} not shown from the cache, received: $response")
+    FrameCache.forget(hash)
+    return false
+}
+
+/**
+ * storeCachedFrame is a function that asks the device to keep the frame it just showed in its cache, for the next time the canvas
+ * shows it.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `hash`: An `Int` holding the `frameHash` of the frame; the device stores nothing if it does not match what it shows.
+ * - `timeoutMillis`: A `Long` holding how long to wait for the answer.
+ *
+ * **Functionality:**
+ *
+ * - The device evicts its least recently used frames to make room and answers with its whole list, which replaces the mirror, so
+ *   evicted frames leave it as well. On "cache-fail" the mirror is kept.
+ */
+suspend fun storeCachedFrame(bluetoothManager: BluetoothManager, hash: Int, timeoutMillis: Long) {
+    bluetoothManager.sendData(CACHE_PUT_PREFIX + "%04x".format(hash))
+    val response = bluetoothManager.receiveData(timeoutMillis)
+    val hashes = parseCacheReport(response)
+    if (hashes != null) {
+        FrameCache.hashes = hashes
+    } else {
+        Log.d("FrameCacheLogic", "Frame ${"%04x".format(hash)} not cached, received: $response")
+    }
+}
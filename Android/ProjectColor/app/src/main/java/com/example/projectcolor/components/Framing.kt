@@ -0,0 +1,240 @@
+package com.example.projectcolor.components
+
+const val FRAME_DELIMITER: Byte = 0x00
+const val FRAME_TYPE_PIXELS = 0x01
+const val FRAME_TYPE_PIXELS_SEQ = 0x02
+const val FRAME_TYPE_PIXELS_DELTA = 0x03
+const val FRAME_TYPE_PALETTE = 0x04
+const val FRAME_TYPE_PIXELS_INDEXED = 0x05
+const val FRAME_TYPE_PIXELS_COMPRESSED = 0x06
+const val FRAME_TYPE_PIXELS_PACKED = 0x07
+const val FRAME_TYPE_ANIMATION_DATA = 0x08
+const val FRAME_TYPE_STREAM = 0x09
+const val FRAME_TYPE_LAST = FRAME_TYPE_STREAM
+const val FRAME_MAX_PAYLOAD = 65
+const val FRAME_FEC_SIZE = 2
+
+const val PROTO_CAP_BINARY_FRAMES = 0x01
+const val PROTO_CAP_WINDOW = 0x02
+const val PROTO_CAP_DELTA = 0x04
+const val PROTO_CAP_PALETTE = 0x08
+const val PROTO_CAP_COMPRESSED = 0x10
+const val PROTO_CAP_COLOR_DEPTH = 0x20
+const val PROTO_CAP_LINK_SPEED = 0x40
+const val PROTO_CAP_FLOW_CONTROL = 0x80
+const val PROTO_CAP_FEC = 0x100
+const val PROTO_CAP_STREAM = 0x200
+const val PROTO_CAP_CACHE = 0x400
+const val PROTO_CAP_TAGGED_REPLIES = 0x800
+
+const val FEC_POLYNOMIAL = 0x1D
+
+val LINK_BAUD_RATES = intArrayOf(9600, 19200, 38400, 57600, 115200)
+const val LINK_BAUD_DEFAULT_CODE = 0
+const val LINK_SPEED_TIMEOUT_MILLIS = 2000L
+const val LINK_RENEGOTIATE_IDLE_MILLIS = 30000L
+
+/**
+ * LinkSpeed is an object that remembers the rate negotiated with `PROTO_CAP_LINK_SPEED`, so a Send shortly after another one skips
+ * the "baud:" round trip. The firmware keeps a confirmed rate until it is asked again; after `LINK_RENEGOTIATE_IDLE_MILLIS` without
+ * a transfer the app asks again, which confirms the rate in one round trip, or raises it again on a device that was reset since.
+ *
+ * - `code`: The index into `LINK_BAUD_RATES` the firmware answered, or `null` while no rate was negotiated.
+ * - `usedAtMillis`: `SystemClock.elapsedRealtime()` at the end of the last transfer at that rate.
+ */
+object LinkSpeed {
+    var code: Int? = null
+    var usedAtMillis = 0L
+
+    /** `isCurrent(nowMillis: Long)`: Returns `true` if a rate was negotiated and the link has been used within `LINK_RENEGOTIATE_IDLE_MILLIS`. */
+    fun isCurrent(nowMillis: Long): Boolean {
+        return code != null && nowMillis - usedAtMillis < LINK_RENEGOTIATE_IDLE_MILLIS
+    }
+
+    /** `confirm(code: Int, nowMillis: Long)`: Records the rate the firmware runs at after a negotiation. */
+    fun confirm(code: Int, nowMillis: Long) {
+        this.code = code
+        usedAtMillis = nowMillis
+    }
+
+    /** `touch(nowMillis: Long)`: Records a transfer at the negotiated rate, which keeps it current. */
+    fun touch(nowMillis: Long) {
+        if (code != null) {
+            usedAtMillis = nowMillis
+        }
+    }
+
+    /** `forget()`: Drops the rate, so the next Send negotiates again. */
+    fun forget() {
+        code = null
+    }
+}
+
+/**
+ * cobsEncode is a function that applies Consistent Overhead Byte Stuffing to a byte array, removing every zero byte so that
+ * `FRAME_DELIMITER` can mark the frame boundaries on the wire.
+ *
+ * **Parameters:**
+ *
+ * - `data`: A `ByteArray` holding the bytes to be encoded.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns the encoded bytes. The result is at most one byte longer than the input for every 254 input bytes, plus one.
+ *
+ * **Functionality:**
+ *
+ * - Every block of non-zero bytes is prefixed with a code byte holding its length plus one; the zero that ends the block is dropped.
+ * - Blocks are split after 254 non-zero bytes, which is signalled by the code `0xFF`.
+ */
+fun cobsEncode(data: ByteArray): ByteArray {
+    val output = ByteArray(data.size + data.size / 254 + 1)
+    var codeIndex = 0
+    var writeIndex = 1
+    var code = 1
+
+    for (byte in data) {
+        if (byte == 0.toByte()) {
+            output[codeIndex] = code.toByte()
+            codeIndex = writeIndex++
+            code = 1
+        } else {
+            output[writeIndex++] = byte
+            code++
+            if (code == 0xFF) {
+                output[codeIndex] = code.toByte()
+                codeIndex = writeIndex++
+                code = 1
+            }
+        }
+    }
+    output[codeIndex] = code.toByte()
+    return output.copyOf(writeIndex)
+}
+
+/**
+ * buildFrame is a function that wraps a payload into a binary frame ready to be written to the Bluetooth socket.
+ *
+ * **Parameters:**
+ *
+ * - `type`: An `Int` holding the frame type, for example `FRAME_TYPE_PIXELS`.
+ * - `payload`: A `ByteArray` holding the frame payload. It must not be longer than 255 bytes.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns `FRAME_DELIMITER`, the COBS-encoded type, length, payload and CRC-8, and a closing `FRAME_DELIMITER`.
+ *
+ * **Functionality:**
+ *
+ * - The leading delimiter switches the firmware from its text command parser to the binary frame parser.
+ * - The CRC-8 covers the type, length and payload bytes and is checked by the firmware before the payload is used.
+ */
+fun buildFrame(type: Int, payload: ByteArray): ByteArray {
+    val body = ByteArray(payload.size + 3)
+    body[0] = type.toByte()
+    body[1] = payload.size.toByte()
+    payload.copyInto(body, 2)
+    body[body.size - 1] = crc8(body, body.size - 1).toByte()
+
+    val encoded = cobsEncode(body)
+    val frame = ByteArray(encoded.size + 2)
+    frame[0] = FRAME_DELIMITER
+    encoded.copyInto(frame, 1)
+    frame[frame.size - 1] = FRAME_DELIMITER
+    return frame
+}
+
+/**
+ * frameCrc is a function that reads the CRC-8 a frame built by `buildFrame` carries, which the firmware names in its confirmation with
+ * `PROTO_CAP_TAGGED_REPLIES`.
+ *
+ * **Parameters:**
+ *
+ * - `frame`: A `ByteArray` holding the frame as returned by `buildFrame`, without the check bytes of `protectFrame`.
+ *
+ * **Returns:**
+ *
+ * - `Int`: Returns the CRC-8, or `-1` if the frame cannot be decoded.
+ */
+fun frameCrc(frame: ByteArray): Int {
+    val body = cobsDecode(frame.copyOfRange(1, frame.size - 1)) ?: return -1
+    return if (body.isEmpty()) -1 else body[body.size - 1].toInt() and 0xFF
+}
+
+/**
+ * cobsDecode is a function that reverses `cobsEncode`.
+ *
+ * **Parameters:**
+ *
+ * - `encoded`: A `ByteArray` holding the encoded bytes, without delimiters.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray?`: Returns the decoded bytes, or `null` if the input is not a valid COBS sequence.
+ */
+fun cobsDecode(encoded: ByteArray): ByteArray? {
+    val output = ByteArray(encoded.size)
+    var readIndex = 0
+    var writeIndex = 0
+    while (readIndex < encoded.size) {
+        val code = encoded[readIndex].toInt() and 0xFF
+        if (code == 0 || readIndex + code > encoded.size) {
+            return null
+        }
+        readIndex++
+        for (i in 1 until code) {
+            output[writeIndex++] = encoded[readIndex++]
+        }
+        if (code != 0xFF && readIndex < encoded.size) {
+            output[writeIndex++] = 0
+        }
+    }
+    return output.copyOf(writeIndex)
+}
+
+/**
+ * fecCheckBytes is a function that computes the two check bytes appended to a frame with `PROTO_CAP_FEC`, like the firmware's
+ * `fecCheckBytes`.
+ *
+ * **Parameters:**
+ *
+ * - `body`: A `ByteArray` holding the decoded frame: type, length, payload and CRC-8.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns P, the XOR of all bytes, and Q, the sum of `body[i] * x^i` in GF(256) reduced by `FEC_POLYNOMIAL`. The
+ *   firmware uses them to locate and repair one corrupted byte without asking for a resend.
+ */
+fun fecCheckBytes(body: ByteArray): ByteArray {
+    var p = 0
+    var q = 0
+    for (i in body.indices.reversed()) {
+        val byte = body[i].toInt() and 0xFF
+        p = p xor byte
+        q = ((q shl 1) xor (if ((q and 0x80) != 0) FEC_POLYNOMIAL else 0) xor byte) and 0xFF
+    }
+    return byteArrayOf(p.toByte(), q.toByte())
+}
+
+/**
+ * protectFrame is a function that adds the `PROTO_CAP_FEC` check bytes to a frame built by `buildFrame` or one of the builders
+ * using it.
+ *
+ * **Parameters:**
+ *
+ * - `frame`: A `ByteArray` holding the complete frame, delimiters included.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns the frame with `fecCheckBytes` after its CRC, encoded again. It is two bytes longer on the wire.
+ *   A frame that cannot be decoded is returned unchanged.
+ */
+fun protectFrame(frame: ByteArray): ByteArray {
+    val body = cobsDecode(frame.copyOfRange(1, frame.size - 1)) ?: return frame
+    val encoded = cobsEncode(body + fecCheckBytes(body))
+    val wire = ByteArray(encoded.size + 2)
+    wire[0] = FRAME_DELIMITER
+    encoded.copyInto(wire, 1)
+    wire[wire.size - 1] = FRAME_DELIMITER
+    return wire
+}
@@ -40,6 +40,9 @@ import com.example.projectcolor.bluetooth.BluetoothManager
  * - A `ColorPickerButtons` composable that provides color selection buttons to update the selected color state.
  * - A `PixelGrid` composable that displays a grid of pixels, allowing interaction based on the selected color.
  * - A `SendButton` composable that sends the current state of the pixel grid via Bluetooth when clicked.
+ * - An `EffectButtons` composable that starts, tunes and stops the effects the device renders on its own.
+ * - A `StreamButton` composable that mirrors the pixel grid on the panel while it is being drawn.
+ * - A `TileButtons` composable that connects further panels and shows the grid across all of them. The grid grows to cover them.
  *
  * The function ensures that all user actions, such as connecting to Bluetooth, selecting colors, and sending
  * the pixel grid data, are handled efficiently while maintaining the correct states within the user interface.
@@ -92,7 +95,7 @@ fun MainScreen() {
             PixelGrid(
                 modifier = Modifier.fillMaxWidth(),
                 selectedColor = selectedColor, // Pass the state
-                size = 16,
+                size = pixelGridMatrix.value.width,
                 matrix = pixelGridMatrix
             )
 
@@ -101,6 +104,22 @@ fun MainScreen() {
                 modifier = Modifier.align(Alignment.CenterHorizontally),
                 matrix = pixelGridMatrix
             )
+
+            EffectButtons(
+                bluetoothManager = bluetoothManager,
+                modifier = Modifier.align(Alignment.CenterHorizontally)
+            )
+
+            StreamButton(
+                bluetoothManager = bluetoothManager,
+                modifier = Modifier.align(Alignment.CenterHorizontally),
+                matrix = pixelGridMatrix
+            )
+
+            TileButtons(
+                modifier = Modifier.align(Alignment.CenterHorizontally),
+                matrix = pixelGridMatrix
+            )
         }
     }
 }
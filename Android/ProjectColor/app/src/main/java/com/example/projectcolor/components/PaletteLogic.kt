@@ -0,0 +1,99 @@
+package com.example.projectcolor.components
+
+const val PALETTE_MAX_SIZE = 32
+const val INDEXED_HEADER_SIZE = 3
+
+/**
+ * buildPalette is a function that collects the distinct colors of a frame for the palette-indexed frame mode.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the frame, as returned by `matrixColors`.
+ *
+ * **Returns:**
+ *
+ * - `IntArray?`: Returns the distinct colors in the order they first appear, or `null` if there are more than `PALETTE_MAX_SIZE`
+ *   of them and the frame has to be sent with full RGB values.
+ */
+fun buildPalette(colors: IntArray): IntArray? {
+    val palette = LinkedHashSet<Int>()
+    for (color in colors) {
+        palette.add(color)
+        if (palette.size > PALETTE_MAX_SIZE) {
+            return null
+        }
+    }
+    return palette.toIntArray()
+}
+
+/**
+ * buildPaletteFrames is a function that wraps a palette into `FRAME_TYPE_PALETTE` frames for the upload to the firmware.
+ *
+ * **Parameters:**
+ *
+ * - `palette`: An `IntArray` holding the packed colors of the palette, at most `PALETTE_MAX_SIZE` of them.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the complete frames, as built by `buildFrame`. Each one holds the index of its first entry followed by
+ *   the R, G, B bytes of as many entries as fit into `FRAME_MAX_PAYLOAD`.
+ */
+fun buildPaletteFrames(palette: IntArray): List<ByteArray> {
+    val entriesPerFrame = (FRAME_MAX_PAYLOAD - 1) / 3
+    return (palette.indices step entriesPerFrame).map { first ->
+        val last = minOf(first + entriesPerFrame, palette.size)
+        val payload = ByteArray(1 + (last - first) * 3)
+        payload[0] = first.toByte()
+        for (index in first until last) {
+            val offset = 1 + (index - first) * 3
+            payload[offset] = (palette[index] shr 16).toByte()
+            payload[offset + 1] = (palette[index] shr 8).toByte()
+            payload[offset + 2] = palette[index].toByte()
+        }
+        buildFrame(FRAME_TYPE_PALETTE, payload)
+    }
+}
+
+/**
+ * buildIndexedFrames is a function that encodes a frame as palette indices in `FRAME_TYPE_PIXELS_INDEXED` frames.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding the packed colors of the frame, as returned by `matrixColors` for a grid with 16 columns, so that
+ *   the array index of a pixel equals its position `(row shl 4) + column`.
+ * - `palette`: An `IntArray` holding the palette returned by `buildPalette` for the same frame.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns the complete frames, as built by `buildFrame`.
+ *
+ * **Functionality:**
+ *
+ * - Palettes of up to 16 colors use 4-bit indices, two pixels per byte with the first pixel in the upper nibble; larger palettes use
+ *   8-bit indices. A 16x16 frame with 4-bit indices takes 128 bytes of indices instead of 1024 bytes of position and RGB values.
+ * - Every frame starts with the position of its first pixel, the index width and the pixel count, and is filled up to `FRAME_MAX_PAYLOAD`.
+ */
+fun buildIndexedFrames(colors: IntArray, palette: IntArray): List<ByteArray> {
+    val bits = if (palette.size <= 16) 4 else 8
+    val pixelsPerFrame = (FRAME_MAX_PAYLOAD - INDEXED_HEADER_SIZE) * (8 / bits)
+    val paletteIndex = palette.withIndex().associate { (index, color) -> color to index }
+
+    return (colors.indices step pixelsPerFrame).map { first ->
+        val count = minOf(pixelsPerFrame, colors.size - first)
+        val payload = ByteArray(INDEXED_HEADER_SIZE + if (bits == 8) count else (count + 1) / 2)
+        payload[0] = first.toByte()
+        payload[1] = bits.toByte()
+        payload[2] = count.toByte()
+        for (i in 0 until count) {
+            val index = paletteIndex.getValue(colors[first + i])
+            if (bits == 8) {
+                payload[INDEXED_HEADER_SIZE + i] = index.toByte()
+            } else {
+                val offset = INDEXED_HEADER_SIZE + i / 2
+                val shift = if (i % 2 == 0) 4 else 0
+                payload[offset] = (payload[offset].toInt() or (index shl shift)).toByte()
+            }
+        }
+        buildFrame(FRAME_TYPE_PIXELS_INDEXED, payload)
+    }
+}
@@ -0,0 +1,89 @@
+package com.example.projectcolor.components
+
+const val PERF_STATS_RESET = "stats-reset"
+const val PERF_STATS_END = "stats-end"
+const val PERF_MSG_CONTROL = 0
+const val PERF_MSG_DATA = FRAME_TYPE_LAST + 1
+
+/**
+ * PERF_STAGE_NAMES holds the names of the processing stages the firmware times, indexed by its `PERF_STAGE_*` values.
+ */
+val PERF_STAGE_NAMES = listOf("receive", "decode", "checksum", "pixels", "show")
+
+/**
+ * PERF_COUNTER_NAMES holds the names of the values of the firmware's "counters:" line, in the order it sends them.
+ */
+val PERF_COUNTER_NAMES = listOf(
+    "bytes received", "bytes dropped", "messages truncated", "frame overflows", "checksum failures", "CRC failures", "ring full",
+    "FEC repairs", "staging spills"
+)
+
+/**
+ * perfMessageName is a function that names a message type of the firmware's "msg:" lines.
+ *
+ * **Parameters:**
+ *
+ * - `type`: An `Int` holding `PERF_MSG_CONTROL`, `PERF_MSG_DATA` or the `FRAME_TYPE_*` of a binary frame.
+ *
+ * **Returns:**
+ *
+ * - `String`: Returns a readable name of the message type.
+ */
+fun perfMessageName(type: Int): String = when (type) {
+    PERF_MSG_CONTROL -> "text command"
+    FRAME_TYPE_PIXELS -> "pixels frame"
+    FRAME_TYPE_PIXELS_SEQ -> "sequenced frame"
+    FRAME_TYPE_PIXELS_DELTA -> "delta frame"
+    FRAME_TYPE_PALETTE -> "palette frame"
+    FRAME_TYPE_PIXELS_INDEXED -> "indexed frame"
+    FRAME_TYPE_PIXELS_COMPRESSED -> "compressed frame"
+    FRAME_TYPE_PIXELS_PACKED -> "packed frame"
+    FRAME_TYPE_ANIMATION_DATA -> "animation frame"
+    FRAME_TYPE_STREAM -> "stream frame"
+    PERF_MSG_DATA -> "data line"
+    else -> "type $type"
+}
+
+/**
+ * formatPerfStats is a function that turns the lines of a firmware "stats" report into readable log lines.
+ *
+ * **Parameters:**
+ *
+ * - `lines`: A `List<String>` holding the received lines, from "stats:<millis>" to "stats-end".
+ *
+ * **Returns:**
+ *
+ * - `List<String>`: Returns one log line per report line; lines that are not part of a report are skipped.
+ *
+ * **Functionality:**
+ *
+ * - "stage:<stage>:<count>:<total us>:<max us>" becomes the stage name with its count, average and maximum.
+ * - "msg:<type>:<count>:<total us>:<max us>" becomes the message type with its count, average and maximum.
+ * - "counters:..." becomes one line listing every counter by name.
+ */
+fun formatPerfStats(lines: List<String>): List<String> {
+    val output = mutableListOf<String>()
+    for (line in lines.map { it.trim() }) {
+        val fields = line.split(":")
+        val values = fields.drop(1).map { it.toLongOrNull() ?: 0L }
+        when (fields[0]) {
+            "stats" -> output.add("Device statistics over ${values.getOrElse(0) { 0L }} ms")
+            "stage" -> if (values.size >= 4) {
+                val (stage, count, total, max) = values
+                val name = PERF_STAGE_NAMES.getOrElse(stage.toInt()) { "stage $stage" }
+                val average = if (count > 0) total / count else 0L
+                output.add("  $name: $count x, avg $average us, max $max us, total $total us")
+            }
+            "msg" -> if (values.size >= 4) {
+                val (type, count, total, max) = values
+                val average = if (count > 0) total / count else 0L
+                output.add("  ${perfMessageName(type.toInt())}: $count x, avg $average us, max $max us")
+            }
+            "counters" -> output.add(
+                "  " + values.mapIndexed { index, value -> "${PERF_COUNTER_NAMES.getOrElse(index) { "counter $index" }} $value" }
+                    .joinToString(", ")
+            )
+        }
+    }
+    return output
+}
@@ -0,0 +1,106 @@
+package com.example.projectcolor.components
+
+import android.os.SystemClock
+import com.example.projectcolor.bluetooth.BluetoothManager
+
+const val RTO_INITIAL_MILLIS = 1000L
+const val RTO_MIN_MILLIS = 200L
+const val RTO_MAX_MILLIS = 5000L
+
+/**
+ * RetransmitTimer is a class that derives the retransmission timeout of one connection from the round trips measured on it, the way
+ * TCP does (RFC 6298), instead of waiting a fixed 5 s for every lost reply.
+ *
+ * - `srttMillis`, `rttVarMillis`: The smoothed round-trip time and its mean deviation, or `null` before the first sample.
+ * - `backoffs`: How often the timeout was doubled since the last sample.
+ *
+ * The timeout is `srtt + 4 * rttvar`, at least `RTO_MIN_MILLIS` (a Bluetooth link stalls for a hundred milliseconds and more while
+ * its baseband retransmits, so shorter timeouts routinely resend frames that are still on their way), `RTO_INITIAL_MILLIS` before
+ * the first sample, doubled after every timeout and never above `RTO_MAX_MILLIS`, the fixed timeout it replaces.
+ */
+class RetransmitTimer {
+    var srttMillis: Double? = null
+        private set
+    var rttVarMillis = 0.0
+        private set
+    var backoffs = 0
+        private set
+
+    /** `timeoutMillis()`: Returns how long to wait for the reply to the next message. */
+    fun timeoutMillis(): Long {
+        val srtt = srttMillis
+        val base = if (srtt == null) RTO_INITIAL_MILLIS else maxOf(RTO_MIN_MILLIS, (srtt + 4 * rttVarMillis).toLong())
+        return minOf(RTO_MAX_MILLIS, base shl minOf(backoffs, 16))
+    }
+
+    /** `sample(rttMillis: Long)`: Adds the round trip of a message that was sent once, and ends the backoff. */
+    fun sample(rttMillis: Long) {
+        val srtt = srttMillis
+        if (srtt == null) {
+            srttMillis = rttMillis.toDouble()
+            rttVarMillis = rttMillis / 2.0
+        } else {
+            rttVarMillis = 0.75 * rttVarMillis + 0.25 * Math.abs(srtt - rttMillis)
+            srttMillis = 0.875 * srtt + 0.125 * rttMillis
+        }
+        backoffs = 0
+    }
+
+    /** `backoff()`: Doubles the timeout after a message went unanswered. */
+    fun backoff() {
+        backoffs++
+    }
+}
+
+/**
+ * rowConfirmation is a function that returns the reply confirming a frame: "ROW-SUCCESS", or "ROW-SUCCESS:<crc>" naming the
+ * `frameCrc` of the frame once the firmware confirmed `PROTO_CAP_TAGGED_REPLIES`.
+ *
+ * **Parameters:**
+ *
+ * - `frame`: A `ByteArray?` holding the frame as returned by `buildFrame`, or `null` for a text "data:" line, which is never tagged.
+ * - `tagged`: A `Boolean` telling whether the firmware confirmed `PROTO_CAP_TAGGED_REPLIES`.
+ *
+ * **Returns:**
+ *
+ * - `String`: Returns the confirmation to wait for.
+ */
+fun rowConfirmation(frame: ByteArray?, tagged: Boolean): String {
+    return if (frame != null && tagged) "ROW-SUCCESS:%02x".format(frameCrc(frame)) else "ROW-SUCCESS"
+}
+
+/**
+ * awaitReply is a function that waits for the reply to a message for as long as the `RetransmitTimer` of the connection allows.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `timer`: The `RetransmitTimer` of the connection; it learns from the reply or backs off.
+ * - `sentAt`: A `Long` holding `SystemClock.elapsedRealtime()` right after the message was sent.
+ * - `firstTransmission`: A `Boolean` telling whether the message was sent for the first time. The reply to a resent message may
+ *   answer either copy, so only replies to first transmissions are measured (Karn's algorithm).
+ * - `confirmation`: A `String?` holding the reply that confirms this message, as returned by `rowConfirmation`, or `null` if any
+ *   reply answers it. Confirmations naming another frame answer an earlier message whose reply came after its timeout; they are
+ *   dropped, so they neither confirm this message nor are measured as its round trip. "ROW-FAIL" carries no tag and is returned.
+ *
+ * **Returns:**
+ *
+ * - `String?`: Returns what `receiveData` returned, or `null` after the timeout.
+ */
+suspend fun awaitReply(
+    bluetoothManager: BluetoothManager,
+    timer: RetransmitTimer,
+    sentAt: Long,
+    firstTransmission: Boolean,
+    confirmation: String? = null
+): String? {
+    val response = bluetoothManager.receiveData(timer.timeoutMillis()) { line ->
+        confirmation == null || line == confirmation || !line.startsWith("ROW-SUCCESS")
+    }
+    if (response == null) {
+        timer.backoff()
+    } else if (firstTransmission && (confirmation == null || response == confirmation)) {
+        timer.sample(SystemClock.elapsedRealtime() - sentAt)
+    }
+    return response
+}
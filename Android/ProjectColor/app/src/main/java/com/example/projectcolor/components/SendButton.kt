@@ -1,6 +1,7 @@
 package com.example.projectcolor.components
 
 import android.content.Context
+import android.os.SystemClock
 import android.util.Log
 import android.widget.Toast
 import androidx.compose.foundation.layout.Row
@@ -17,6 +18,7 @@ import com.example.projectcolor.RGBMatrix
 import com.example.projectcolor.bluetooth.BluetoothManager
 import kotlinx.coroutines.CoroutineScope
 import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
 
 /**
@@ -33,11 +35,13 @@ import kotlinx.coroutines.launch
  *
  * - The function creates a `Row` composable that contains multiple buttons, each with specific functionality:
  *     - The "Send" button, which occupies more space (`weight` of 2), initiates the process of sending the pixel grid data via Bluetooth when clicked.
+ *     - The "Animate" button, of the same size, stores the pixel grid on the device as a scrolling animation with `uploadScrollAnimation`.
  *     - Color buttons (Red, Green, Blue, Black, and White), each sending a corresponding color command to the Bluetooth device when clicked.
  *
  * - Each button's `enabled` state depends on whether a Bluetooth device is connected, as indicated by the `bluetoothManager`.
  *
  * - The `Send` button triggers a coroutine to execute the `handshakeSendPixelQuarterRows` function, which handles the actual data transmission.
+ *   It runs on `Dispatchers.IO`, like the "Animate" upload, so waiting for replies never blocks the main thread.
  *
  * - The color buttons use `sendColor` to transmit a specific color command to the Bluetooth device.
  *
@@ -63,7 +67,7 @@ fun SendButton(
                 .padding(horizontal = 4.dp)
             ,
             onClick = {
-                CoroutineScope(Dispatchers.Main).launch {
+                CoroutineScope(Dispatchers.IO).launch {
                     handshakeSendPixelQaurterRows(matrix, bluetoothManager, context)
                 }
             },
@@ -72,6 +76,21 @@ fun SendButton(
             Text(text = "Send")
         }
 
+        Button(
+            modifier = Modifier
+                .weight(2f)
+                .padding(horizontal = 4.dp)
+            ,
+            onClick = {
+                CoroutineScope(Dispatchers.IO).launch {
+                    uploadScrollAnimation(matrix, bluetoothManager, context)
+                }
+            },
+            enabled = isBluetoothConnected
+        ) {
+            Text(text = "Animate")
+        }
+
         Button(
             modifier = Modifier
                 .weight(1f)
@@ -134,6 +153,22 @@ fun SendButton(
     }
 }
 
+/**
+ * showToast is a function that shows a Toast from any thread. The transfers run on `Dispatchers.IO`, where a Toast cannot be shown,
+ * so it is posted to the main thread.
+ *
+ * **Parameters:**
+ *
+ * - `context`: A `Context` used to display the Toast.
+ * - `text`: A `String` holding the message.
+ * - `duration`: An `Int` holding `Toast.LENGTH_SHORT` or `Toast.LENGTH_LONG`.
+ */
+private fun showToast(context: Context, text: String, duration: Int) {
+    CoroutineScope(Dispatchers.Main).launch {
+        Toast.makeText(context, text, duration).show()
+    }
+}
+
 /**
  * handshakeSendPixelQaurterRows is a function that manages the process of transmitting pixel data in a grid to a Bluetooth-connected device.
  * It handles the handshake protocol, sends the grid data row by row, and then terminates the connection gracefully. This function also provides
@@ -148,19 +183,46 @@ fun SendButton(
  * **Functionality:**
  *
  * - The function first attempts to establish a connection by performing a handshake with the Bluetooth device. It sends a "syn" message and expects a "syn-ack" response.
- *   If successful, it sends an "ack" message to complete the handshake.
+ *   If successful, it sends an "ack" message to complete the handshake. The "syn" carries the protocol capabilities of the app, and the capabilities
+ *   confirmed by the firmware decide whether rows are sent as binary frames or as "data:" text messages.
  *
  * - If the handshake is successful, the function proceeds to send the pixel grid data row by row. Each row is divided into four parts and sent sequentially.
- *   The function retries sending each part up to 20 times until a "ROW-SUCCESS" acknowledgment is received.
+ *   The function retries sending each part up to 20 times until a "ROW-SUCCESS" acknowledgment is received. Firmware that confirms
+ *   `PROTO_CAP_WINDOW` receives the parts through `sendMatrixRowsWindowed` instead, with several frames in flight at once.
+ *
+ * - When the firmware confirms `PROTO_CAP_DELTA` and a frame was committed by an earlier Send, only the changed pixels are sent with
+ *   `sendMatrixDelta`; if the firmware rejects the delta, the full frame is sent as above. A full frame is sent with `sendMatrixEncoded`
+ *   as a palette with 4- or 8-bit indices, as RLE/LZ compressed pixels or with a reduced color depth, whichever is smaller,
+ *   when the firmware confirms `PROTO_CAP_PALETTE`, `PROTO_CAP_COMPRESSED` or `PROTO_CAP_COLOR_DEPTH`.
+ *
+ * - Firmware that confirms `PROTO_CAP_LINK_SPEED` is asked for a faster baud rate with `negotiateLinkSpeed` before the data is sent,
+ *   unless `LinkSpeed` holds a rate negotiated for a transfer within `LINK_RENEGOTIATE_IDLE_MILLIS`. Firmware behind a module that
+ *   cannot follow a rate change does not offer the capability, so no Send pays for the round trip there.
+ *
+ * - Firmware that confirms `PROTO_CAP_FEC` gets every binary frame with the check bytes of `protectFrame`. It repairs a frame with one
+ *   corrupted byte in place and answers "ROW-SUCCESS", so a noisy link costs two bytes per frame instead of a "ROW-FAIL" round trip.
+ *
+ * - Lost messages are resent after the timeout of a `RetransmitTimer`, which follows the round trips measured on the connection and
+ *   backs off exponentially, instead of after a fixed 5 s; there are no fixed pauses between retries.
+ *
+ * - Firmware that confirms `PROTO_CAP_TAGGED_REPLIES` answers every binary frame with "ROW-SUCCESS:<crc>", naming the CRC-8 of the
+ *   frame it applied. A confirmation that arrives after its timeout then cannot be taken for the confirmation of the next part.
  *
  * - After successfully sending all rows, the function terminates the connection by sending a "fin" message and waiting for a "fin-ack" response.
- *   If the termination is unsuccessful, it retries the process up to three times.
+ *   If the termination is unsuccessful, it retries the process up to three times. With `PROTO_CAP_DELTA` the message is "fin:<generation>",
+ *   and the frame is remembered in `CommittedFrame` once "fin-ack" arrives.
+ *
+ * - Firmware that confirms `PROTO_CAP_CACHE` keeps recurring frames in a cache keyed by `frameHash`. A 16x16 frame the `FrameCache`
+ *   mirror lists is shown with `showCachedFrame` in one short message instead of a transfer; every frame sent in full is stored with
+ *   `storeCachedFrame` after "fin-ack". A cache miss falls back to the transfer.
+ *
+ * - After the transfer the device's performance statistics are fetched with "stats-reset" and logged by `fetchPerfStats`.
  *
  * - Throughout the process, the function logs each step and can optionally display Toast messages to inform the user of the current status.
  *
  * - If the handshake or data transmission fails, the function displays an appropriate error message to the user.
  */
-fun handshakeSendPixelQaurterRows(
+suspend fun handshakeSendPixelQaurterRows(
     matrix: MutableState<RGBMatrix>,
     bluetoothManager: BluetoothManager,
     context: Context // Add context to show Toast messages
@@ -168,6 +230,15 @@ fun handshakeSendPixelQaurterRows(
     val retryLimit = 3
     val timeoutMillis = 5000L
     var retryCount = 0
+    val appCaps = PROTO_CAP_BINARY_FRAMES or PROTO_CAP_WINDOW or PROTO_CAP_DELTA or PROTO_CAP_PALETTE or PROTO_CAP_COMPRESSED or
+            PROTO_CAP_COLOR_DEPTH or PROTO_CAP_LINK_SPEED or PROTO_CAP_FLOW_CONTROL or PROTO_CAP_FEC or PROTO_CAP_CACHE or
+            PROTO_CAP_TAGGED_REPLIES
+    val colors = matrixColors(matrix)
+    val hash = frameHash(colors)
+    val generation = CommittedFrame.nextGeneration()
+    var protocolCaps = 0
+    var windowSize = 1
+    val retransmitTimer = RetransmitTimer()
 
     /**
      * performHandshake is a function that attempts to establish a connection with a Bluetooth device using a handshake protocol.
@@ -180,35 +251,94 @@ fun handshakeSendPixelQaurterRows(
      *
      * **Functionality:**
      *
-     * - The function sends a "syn" message and waits for a "syn-ack" response from the Bluetooth device.
+     * - The function sends a "syn:<caps>" message carrying the app capabilities as a hex bit mask and waits for a "syn-ack:<caps>" response,
+     *   whose capabilities are stored in `protocolCaps`. When `PROTO_CAP_WINDOW` is confirmed, the reply is "syn-ack:<caps>:<window>" and
+     *   the window is stored in `windowSize`.
+     * - Firmware that does not know the capability handshake answers with "Unknown message"; the function then falls back to a plain "syn",
+     *   expects a plain "syn-ack", and leaves `protocolCaps` empty so the text protocol is used.
      * - If the "syn-ack" response is received, the function sends an "ack" message and logs the successful handshake.
-     * - If the handshake fails (i.e., "syn-ack" is not received), the function retries up to a predefined limit (`retryLimit`).
+     * - If the handshake fails (i.e., "syn-ack" is not received), the function retries up to a predefined limit (`retryLimit`). Each
+     *   "syn" waits as long as `retransmitTimer` allows: 1 s for the first, twice as long for every retry, and its round trip seeds
+     *   the timeouts of the transfer that follows.
      * - The function provides feedback via log messages and can optionally show Toast messages for user information.
+     * - A device that plays an animation or effect is woken with `wakePlayback` first, so the "syn" is not lost to a display refresh.
      */
-    fun performHandshake(): Boolean {
+    suspend fun performHandshake(): Boolean {
+        var offerCaps = true
+        var firstTransmission = true
+        wakePlayback(bluetoothManager)
         while (retryCount < retryLimit && bluetoothManager.isConnected()) {
-            bluetoothManager.sendData("syn")
+            bluetoothManager.sendData(if (offerCaps) "syn:%02x".format(appCaps) else "syn")
             Log.d("SendButton", "SYN sent, waiting for SYN-ACK...")
 //            Toast.makeText(context, "SYN sent, waiting for SYN-ACK...", Toast.LENGTH_SHORT).show()
 
-            val response = bluetoothManager.receiveData(timeoutMillis)
-            if (response == "syn-ack") {
+            val response = awaitReply(bluetoothManager, retransmitTimer, SystemClock.elapsedRealtime(), firstTransmission)
+            firstTransmission = false
+            if (response != null && (response == "syn-ack" || response.startsWith("syn-ack:"))) {
+                val fields = response.split(":")
+                protocolCaps = fields.getOrNull(1)?.toIntOrNull(16) ?: 0
+                windowSize = if ((protocolCaps and PROTO_CAP_WINDOW) != 0) fields.getOrNull(2)?.toIntOrNull(16) ?: 1 else 1
                 bluetoothManager.sendData("ack")
-                Log.d("SendButton", "ACK sent. Handshake successful.")
-                Toast.makeText(context, "ACK sent. Handshake successful.", Toast.LENGTH_SHORT).show()
+                Log.d("SendButton", "ACK sent. Handshake successful, capabilities: $protocolCaps, window: $windowSize")
+                showToast(context, "ACK sent. Handshake successful.", Toast.LENGTH_SHORT)
                 return true
+            } else if (offerCaps && response != null && response.startsWith("Unknown message")) {
+                offerCaps = false
+                firstTransmission = true
+                Log.d("SendButton", "Capability handshake not supported, falling back to plain SYN")
             } else {
                 retryCount++
                 Log.d("SendButton", "SYN-ACK not received, retrying... ($retryCount/$retryLimit)")
 //                Toast.makeText(context, "SYN-ACK not received, retrying... ($retryCount/$retryLimit)", Toast.LENGTH_SHORT).show()
-                Thread.sleep(1000)
             }
         }
         Log.d("SendButton", "Failed to establish connection after $retryLimit attempts.")
-        Toast.makeText(context, "Failed to establish connection after $retryLimit attempts.", Toast.LENGTH_LONG).show()
+        showToast(context, "Failed to establish connection after $retryLimit attempts.", Toast.LENGTH_LONG)
         return false
     }
 
+    /**
+     * negotiateLinkSpeed is a function that raises the baud rate between the firmware and its serial peer, negotiated with
+     * `PROTO_CAP_LINK_SPEED`. The phone side of the Bluetooth link has no baud rate, so the app offers every rate in `LINK_BAUD_RATES`
+     * and the firmware picks the fastest one its transport and peer support; behind an HC-05/HC-06 module, which cannot change its
+     * rate while connected, that is always 9600.
+     *
+     * **Functionality:**
+     *
+     * - Sends "baud:<rates>" and waits for "baud-ack:<code>"; other lines are dropped. A code of `LINK_BAUD_DEFAULT_CODE` means the link stays at 9600.
+     * - Otherwise the firmware switches; after a short pause the function sends "baud-check" and expects "baud-ok" over the new rate.
+     * - Without "baud-ok" the firmware falls back to 9600 after `LINK_SPEED_TIMEOUT_MILLIS`; the function waits that long, so the
+     *   transfer continues at 9600.
+     * - The rate the firmware runs at afterwards is stored in `LinkSpeed`; without an answer it is forgotten. The firmware keeps a
+     *   confirmed rate until the next "baud:", so negotiating again after an idle period answers the current rate without switching.
+     */
+    suspend fun negotiateLinkSpeed() {
+        bluetoothManager.sendData("baud:%02x".format((1 shl LINK_BAUD_RATES.size) - 1))
+        val response = bluetoothManager.receiveData(timeoutMillis) { it.startsWith("baud-ack:") || it.startsWith("Unknown message") }
+        val code = response?.lines()?.firstOrNull { it.startsWith("baud-ack:") }?.substringAfter("baud-ack:")?.toIntOrNull(16)
+        if (code == null || code !in LINK_BAUD_RATES.indices) {
+            Log.d("SendButton", "Link speed not negotiated, received: $response")
+            LinkSpeed.forget()
+            return
+        }
+        if (code == LINK_BAUD_DEFAULT_CODE) {
+            Log.d("SendButton", "Link speed stays at ${LINK_BAUD_RATES[LINK_BAUD_DEFAULT_CODE]} baud")
+            LinkSpeed.confirm(code, SystemClock.elapsedRealtime())
+            return
+        }
+
+        delay(50)
+        bluetoothManager.sendData("baud-check")
+        if (bluetoothManager.receiveData(LINK_SPEED_TIMEOUT_MILLIS / 2) == "baud-ok") {
+            Log.d("SendButton", "Link speed raised to ${LINK_BAUD_RATES[code]} baud")
+            LinkSpeed.confirm(code, SystemClock.elapsedRealtime())
+        } else {
+            Log.d("SendButton", "Link speed ${LINK_BAUD_RATES[code]} baud not confirmed, waiting for the fallback to 9600")
+            delay(LINK_SPEED_TIMEOUT_MILLIS)
+            LinkSpeed.confirm(LINK_BAUD_DEFAULT_CODE, SystemClock.elapsedRealtime())
+        }
+    }
+
     /**
      * sendMatrixRows is a function responsible for transmitting the pixel grid data row by row to the Bluetooth device.
      * Each row is divided into four parts, and the function sends these parts sequentially, waiting for an acknowledgment
@@ -221,11 +351,15 @@ fun handshakeSendPixelQaurterRows(
      * **Functionality:**
      *
      * - The function iterates over each row of the matrix and divides it into four parts.
-     * - For each part, the function sends the data and waits for a "ROW-SUCCESS" acknowledgment.
-     * - If the acknowledgment is not received, the function retries sending the part up to 20 times.
+     * - For each part, the function sends the data and waits for a "ROW-SUCCESS" acknowledgment, tagged with the CRC-8 of the
+     *   frame by `rowConfirmation` when `PROTO_CAP_TAGGED_REPLIES` is confirmed.
+     * - If the acknowledgment is not received, the function retries sending the part up to 20 times. How long it waits for the
+     *   acknowledgment is set by `retransmitTimer` from the round trips measured so far, so a lost part is resent after a few
+     *   hundred milliseconds instead of seconds. A resent part keeps the replies already queued, since a late confirmation of the
+     *   earlier copy confirms it as well.
      * - The function logs the progress and status of each row and part, providing detailed feedback on the transmission process.
      */
-    fun sendMatrixRows(): Boolean {
+    suspend fun sendMatrixRows(): Boolean {
         for (row in 0 until matrix.value.height) {
             Log.d("SendButton", "Sending row: $row ")
 //            Toast.makeText(context, "Sending row: $row", Toast.LENGTH_SHORT).show()
@@ -233,15 +367,19 @@ fun handshakeSendPixelQaurterRows(
             for (part in 0 until 4) {
                 var tryCount = 0
                 var rowAck = "ROW-FAIL"
+                val framed = (protocolCaps and PROTO_CAP_BINARY_FRAMES) != 0
+                val confirmation = rowConfirmation(if (framed) serializeQuarterRowFrame(matrix, row, part) else null,
+                    (protocolCaps and PROTO_CAP_TAGGED_REPLIES) != 0)
 
-                while (rowAck != "ROW-SUCCESS" && tryCount < 20) {
-                    sendQuarterRow(matrix, row, part, bluetoothManager, "data:")
-                    rowAck = bluetoothManager.receiveData(timeoutMillis).toString()
+                while (rowAck != confirmation && tryCount < 20) {
+                    sendQuarterRow(matrix, row, part, bluetoothManager, "data:",
+                        framed = framed, fec = (protocolCaps and PROTO_CAP_FEC) != 0, keepReplies = tryCount > 0)
+                    rowAck = awaitReply(bluetoothManager, retransmitTimer, SystemClock.elapsedRealtime(), tryCount == 0,
+                        confirmation).toString()
                     tryCount++
-                    Thread.sleep(5) // for testing
                 }
 
-                if(rowAck != "ROW-SUCCESS") {
+                if(rowAck != confirmation) {
                     Log.d("SendButton", "Failed to send row $row, part: $part, received: $rowAck")
                     return false
                 }
@@ -250,6 +388,186 @@ fun handshakeSendPixelQaurterRows(
         return true
     }
 
+    /**
+     * sendMatrixDelta is a function that transmits only the pixels that changed since the frame committed by the previous Send,
+     * negotiated with `PROTO_CAP_DELTA`.
+     *
+     * **Returns:**
+     *
+     * - `Boolean`: Returns `true` if the delta was applied, `false` if the firmware rejected it or the transfer failed.
+     *
+     * **Functionality:**
+     *
+     * - The delta is built by `buildDeltaFrames` against `CommittedFrame`; each frame is retried up to 20 times until "ROW-SUCCESS".
+     * - A "DELTA-REJECT" reply means the firmware does not hold the base generation (for example after a reset). Then, as after any
+     *   frame `sendFrameAcknowledged` could not confirm, the committed frame is forgotten and `false` is returned, so the caller sends
+     *   a full frame instead.
+     */
+    suspend fun sendMatrixDelta(): Boolean {
+        val base = CommittedFrame.colors ?: return false
+        if (base.size != colors.size) {
+            return false
+        }
+        val frames = buildDeltaFrames(colors, base, CommittedFrame.generation, matrix.value.width)
+        Log.d("SendButton", "Sending delta: ${frames.size} frames")
+
+        for (frame in frames) {
+            if (!sendFrameAcknowledged(frame)) {
+                Log.d("SendButton", "Delta not applied, sending full frame")
+                CommittedFrame.forget()
+                return false
+            }
+        }
+        return true
+    }
+
+    /**
+     * sendMatrixEncoded is a function that transmits the pixel grid in the smallest encoding the firmware confirmed: the palette-indexed
+     * frame mode (`PROTO_CAP_PALETTE`), compressed frames (`PROTO_CAP_COMPRESSED`) or a reduced color depth (`PROTO_CAP_COLOR_DEPTH`).
+     *
+     * **Returns:**
+     *
+     * - `Boolean`: Returns `true` if the frame was sent, `false` if no encoding applies or the transfer failed.
+     *
+     * **Functionality:**
+     *
+     * - Palette mode uploads the distinct colors of the frame with `buildPaletteFrames`, then the pixels follow as 4- or 8-bit indices
+     *   built by `buildIndexedFrames`. It is skipped for frames with more than `PALETTE_MAX_SIZE` colors.
+     * - Compressed mode uses `buildCompressedFrames`, which already picks the smaller of RLE and LZ.
+     * - Color depth mode sends the pixels with `buildPackedFrames` in the smallest depth returned by `losslessColorDepth`, so the
+     *   colors shown are exactly the colors drawn.
+     * - The candidate with the fewest bytes on the wire is sent; each frame is retried up to 20 times until "ROW-SUCCESS".
+     * - Grids that are not 16 columns wide are left to the RGB transfer.
+     */
+    suspend fun sendMatrixEncoded(): Boolean {
+        if (matrix.value.width != 16) {
+            return false
+        }
+        val candidates = mutableListOf<List<ByteArray>>()
+        if ((protocolCaps and PROTO_CAP_PALETTE) != 0) {
+            buildPalette(colors)?.let { palette -> candidates.add(buildPaletteFrames(palette) + buildIndexedFrames(colors, palette)) }
+        }
+        if ((protocolCaps and PROTO_CAP_COMPRESSED) != 0) {
+            candidates.add(buildCompressedFrames(colors))
+        }
+        if ((protocolCaps and PROTO_CAP_COLOR_DEPTH) != 0) {
+            candidates.add(buildPackedFrames(colors, losslessColorDepth(colors)))
+        }
+        val frames = candidates.minByOrNull { frames -> frames.sumOf { it.size } } ?: return false
+        Log.d("SendButton", "Sending encoded frame: ${frames.size} frames, ${frames.sumOf { it.size }} bytes")
+
+        for (frame in frames) {
+            if (!sendFrameAcknowledged(frame)) {
+                Log.d("SendButton", "Failed to send encoded frame")
+                return false
+            }
+        }
+        return true
+    }
+
+    /**
+     * sendFrameAcknowledged is a function that sends a single binary frame and waits for its reply, retrying up to 20 times until
+     * "ROW-SUCCESS" is received, each time after the timeout of `retransmitTimer`. With `PROTO_CAP_FEC` the frame is sent with the
+     * check bytes of `protectFrame`. With `PROTO_CAP_TAGGED_REPLIES` only the confirmation naming this frame counts, see
+     * `rowConfirmation`, and retries keep the replies already queued, so a late confirmation of an earlier copy still counts.
+     *
+     * **Parameters:**
+     *
+     * - `frame`: A `ByteArray` holding the complete frame, as built by `buildFrame`.
+     *
+     * **Returns:**
+     *
+     * - `Boolean`: Returns `true` once the frame is confirmed, `false` after 20 tries or right after a "DELTA-REJECT" reply.
+     */
+    suspend fun sendFrameAcknowledged(frame: ByteArray): Boolean {
+        var tryCount = 0
+        var rowAck = "ROW-FAIL"
+        val wireFrame = if ((protocolCaps and PROTO_CAP_FEC) != 0) protectFrame(frame) else frame
+        val confirmation = rowConfirmation(frame, (protocolCaps and PROTO_CAP_TAGGED_REPLIES) != 0)
+
+        while (rowAck != confirmation && rowAck != "DELTA-REJECT" && tryCount < 20) {
+            bluetoothManager.sendBytes(wireFrame, keepReplies = tryCount > 0)
+            rowAck = awaitReply(bluetoothManager, retransmitTimer, SystemClock.elapsedRealtime(), tryCount == 0,
+                confirmation).toString()
+            tryCount++
+        }
+        if (rowAck != confirmation) {
+            Log.d("SendButton", "Frame not confirmed after $tryCount tries, received: $rowAck")
+            return false
+        }
+        return true
+    }
+
+    /**
+     * sendMatrixRowsWindowed is a function that transmits the pixel grid with a sliding window of sequenced binary frames, negotiated
+     * with `PROTO_CAP_WINDOW`. Instead of waiting for a reply after every quarter row, up to `windowSize` frames are kept in flight.
+     *
+     * **Returns:**
+     *
+     * - `Boolean`: Returns `true` if all rows are successfully sent, otherwise returns `false`.
+     *
+     * **Functionality:**
+     *
+     * - Every quarter row gets a sequence number (its index modulo 256) and is sent as a `FRAME_TYPE_PIXELS_SEQ` frame.
+     * - The firmware applies frames strictly in order and answers with a cumulative "ROW-ACK:<next seq>"; everything before that
+     *   sequence number is confirmed and the window slides forward.
+     * - The frames are sent with `keepReplies`: a cumulative acknowledgment that arrives late still confirms the frames before it.
+     * - A "ROW-FAIL:<next seq>" reply, or a timeout without any reply, makes the function go back and resend every frame from the
+     *   first unconfirmed one (go-back-N). The timeout is that of `retransmitTimer`, measured from the last frame sent; rounds that
+     *   resend frames do not update it.
+     * - The transfer fails after 20 rounds in a row that confirm nothing, the same limit the stop-and-wait `sendMatrixRows` uses per part.
+     */
+    suspend fun sendMatrixRowsWindowed(): Boolean {
+        val parts = (0 until matrix.value.height).flatMap { row -> (0 until 4).map { part -> row to part } }
+        var base = 0
+        var next = 0
+        var firstUnsent = 0
+        var stalledRounds = 0
+
+        while (base < parts.size) {
+            val resending = next < firstUnsent
+            while (next < parts.size && next - base < windowSize) {
+                val (row, part) = parts[next]
+                val frame = serializeQuarterRowFrame(matrix, row, part, sequence = next)
+                bluetoothManager.sendBytes(if ((protocolCaps and PROTO_CAP_FEC) != 0) protectFrame(frame) else frame, keepReplies = true)
+                next++
+            }
+            firstUnsent = maxOf(firstUnsent, next)
+
+            val previousBase = base
+            val response = awaitReply(bluetoothManager, retransmitTimer, SystemClock.elapsedRealtime(), !resending)
+            if (response == null) {
+                next = base
+            } else {
+                for (line in response.lines().map { it.trim() }) {
+                    val isAck = line.startsWith("ROW-ACK:")
+                    if (!isAck && !line.startsWith("ROW-FAIL:")) {
+                        continue
+                    }
+                    val sequence = line.substringAfter(":").toIntOrNull(16) ?: continue
+                    val confirmed = base + ((sequence - base) and 0xFF)
+                    if (confirmed <= next) {
+                        base = confirmed
+                    }
+                    if (!isAck) {
+                        next = base
+                    }
+                }
+            }
+
+            if (base == previousBase) {
+                stalledRounds++
+                Log.d("SendButton", "No progress at frame $base, received: $response ($stalledRounds/20)")
+                if (stalledRounds >= 20) {
+                    return false
+                }
+            } else {
+                stalledRounds = 0
+            }
+        }
+        return true
+    }
+
     /**
      * terminateConnection is a function that gracefully terminates the connection with the Bluetooth device by following a termination protocol.
      * It sends a "fin" message and expects a "fin-ack" response from the device. If the termination is unsuccessful, the function retries
@@ -257,40 +575,211 @@ fun handshakeSendPixelQaurterRows(
      *
      * **Functionality:**
      *
-     * - The function sends a "fin" message to the Bluetooth device and waits for a "fin-ack" response.
-     * - If the "fin-ack" response is received, the function logs the successful termination of the connection.
+     * - The function sends a "fin" message to the Bluetooth device and waits for a "fin-ack" response. With `PROTO_CAP_DELTA` the message
+     *   is "fin:<generation>" and tells the firmware which generation the frame it shows belongs to.
+     * - If the "fin-ack" response is received, the function logs the successful termination of the connection and, with `PROTO_CAP_DELTA`,
+     *   stores the frame in `CommittedFrame` as the base for the next delta. Without "fin-ack" no base is kept.
      * - If the termination fails (i.e., "fin-ack" is not received), the function retries the termination process up to a predefined limit (`retryLimit`).
      * - The function provides feedback via log messages and can optionally show Toast messages to inform the user about the connection status.
+     *
+     * **Returns:**
+     *
+     * - `Boolean`: Returns `true` if "fin-ack" was received, i.e. the device confirmed that it shows the frame.
      */
-    fun terminateConnection() {
+    suspend fun terminateConnection(): Boolean {
         retryCount = 0
-        val response = ""
-        while (retryCount < retryLimit && bluetoothManager.isConnected() && response != "fin-ack") {
-            bluetoothManager.sendData("fin")
+        val deltaEnabled = (protocolCaps and PROTO_CAP_DELTA) != 0
+        CommittedFrame.forget()
+        while (retryCount < retryLimit && bluetoothManager.isConnected()) {
+            bluetoothManager.sendData(if (deltaEnabled) "fin:%02x".format(generation) else "fin")
             Log.d("SendButton", "FIN sent, waiting for FIN-ACK...")
 //        Toast.makeText(context, "FIN sent, waiting for FIN-ACK...", Toast.LENGTH_SHORT).show()
 
             val response = bluetoothManager.receiveData(timeoutMillis)
             if (response == "fin-ack") {
+                if (deltaEnabled) {
+                    CommittedFrame.commit(generation, colors)
+                }
                 Log.d("SendButton", "FIN-ACK received, connection terminated.")
-                Toast.makeText(context, "Data sent successfully and connection terminated.", Toast.LENGTH_SHORT).show()
-                break
+                showToast(context, "Data sent successfully and connection terminated.", Toast.LENGTH_SHORT)
+                return true
             } else {
                 Log.d("SendButton", "Failed to terminate connection: FIN-ACK not received.")
             }
             retryCount++
-            Thread.sleep(100)
         }
-        if (retryCount == retryLimit) {
-            Log.d("SendButton", "Failed to terminate connection after $retryLimit attempts.")
-            Toast.makeText(context, "Failed to terminate connection after $retryLimit attempts.", Toast.LENGTH_SHORT).show()
+        Log.d("SendButton", "Failed to terminate connection after $retryCount attempts.")
+        showToast(context, "Failed to terminate connection after $retryCount attempts.", Toast.LENGTH_SHORT)
+        return false
+    }
+
+    /**
+     * fetchPerfStats is a function that asks the firmware for its performance statistics after a transfer and logs them.
+     *
+     * **Functionality:**
+     *
+     * - Sends "stats-reset", which returns the statistics collected since the previous request and clears them, so every log covers
+     *   one Send.
+     * - Collects reply lines until "stats-end" and logs them through `formatPerfStats`. Firmware without the command answers
+     *   "Unknown message: ...", which ends the request without a log.
+     */
+    suspend fun fetchPerfStats() {
+        bluetoothManager.sendData(PERF_STATS_RESET)
+        val lines = mutableListOf<String>()
+        while (bluetoothManager.isConnected()) {
+            val response = bluetoothManager.receiveData(timeoutMillis) ?: break
+            lines.addAll(response.lines())
+            if (lines.any { it.trim() == PERF_STATS_END || it.startsWith("Unknown message") }) {
+                break
+            }
+        }
+        if (lines.none { it.trim() == PERF_STATS_END }) {
+            Log.d("SendButton", "No device statistics received: $lines")
+            return
+        }
+        for (line in formatPerfStats(lines)) {
+            Log.d("SendButton", line)
+        }
+    }
+
+    suspend fun sendMatrix(): Boolean {
+        if ((protocolCaps and PROTO_CAP_LINK_SPEED) == 0) {
+            LinkSpeed.forget()
+        } else if (!LinkSpeed.isCurrent(SystemClock.elapsedRealtime())) {
+            negotiateLinkSpeed()
+        }
+        if ((protocolCaps and PROTO_CAP_DELTA) != 0 && CommittedFrame.generation != GENERATION_UNKNOWN && sendMatrixDelta()) {
+            return true
         }
+        if ((protocolCaps and (PROTO_CAP_PALETTE or PROTO_CAP_COMPRESSED or PROTO_CAP_COLOR_DEPTH)) != 0 && sendMatrixEncoded()) {
+            return true
+        }
+        return if ((protocolCaps and PROTO_CAP_WINDOW) != 0) sendMatrixRowsWindowed() else sendMatrixRows()
+    }
+
+    /**
+     * showFromCache is a function that shows the frame from the device's cache with `PROTO_CAP_CACHE`, if the device holds it.
+     *
+     * **Returns:**
+     *
+     * - `Boolean`: Returns `true` if the frame is shown; with `PROTO_CAP_DELTA` it is committed in `CommittedFrame` like after "fin-ack".
+     */
+    suspend fun showFromCache(): Boolean {
+        if ((protocolCaps and PROTO_CAP_CACHE) == 0 || matrix.value.width != 16 || matrix.value.height != 16) {
+            return false
+        }
+        syncFrameCache(bluetoothManager, timeoutMillis)
+        val deltaEnabled = (protocolCaps and PROTO_CAP_DELTA) != 0
+        if (!showCachedFrame(bluetoothManager, hash, if (deltaEnabled) generation else GENERATION_UNKNOWN, timeoutMillis)) {
+            return false
+        }
+        if (deltaEnabled) {
+            CommittedFrame.commit(generation, colors)
+        } else {
+            CommittedFrame.forget()
+        }
+        Log.d("SendButton", "Frame shown from the device's cache.")
+        showToast(context, "Frame shown from the device's cache.", Toast.LENGTH_SHORT)
+        return true
+    }
+
+    val connected = performHandshake()
+    if (connected && showFromCache()) {
+        fetchPerfStats()
+        LinkSpeed.touch(SystemClock.elapsedRealtime())
+    } else if (connected && sendMatrix()) {
+        if (terminateConnection() && (protocolCaps and PROTO_CAP_CACHE) != 0 && matrix.value.width == 16 && matrix.value.height == 16) {
+            storeCachedFrame(bluetoothManager, hash, timeoutMillis)  // only after "fin-ack": the device stores what it shows
+        }
+        fetchPerfStats()
+        LinkSpeed.touch(SystemClock.elapsedRealtime())
+    } else {
+        LinkSpeed.forget()  // the next Send asks for the rate again
+        showToast(context, "Failed to send matrix data.", Toast.LENGTH_LONG)
+    }
+}
+
+/**
+ * uploadScrollAnimation is a function that stores the pixel grid on the device as an animation scrolling to the left, which the
+ * firmware then plays on its own at a fixed frame rate, looping and again after every reset, without further Bluetooth traffic.
+ *
+ * **Parameters:**
+ *
+ * - `matrix`: A `MutableState<RGBMatrix>` representing the pixel grid to be animated.
+ * - `bluetoothManager`: A `BluetoothManager` instance responsible for managing the Bluetooth connection and data transmission.
+ * - `context`: A `Context` used to display Toast messages.
+ *
+ * **Functionality:**
+ *
+ * - Wakes a device that plays an animation or effect with `wakePlayback`, then shakes hands with `PROTO_CAP_BINARY_FRAMES` only,
+ *   so every frame is answered right away with "ROW-SUCCESS" or "ROW-FAIL".
+ * - Asks for the storage size with "anim-info"; firmware without stored animations answers "Unknown message: ..." and the upload
+ *   is abandoned.
+ * - Builds the animation with `scrollAnimation` and `buildAnimation`, moving 1, 2, 4 or 8 columns per frame, whichever is the
+ *   smoothest that fits into the storage.
+ * - Sends the `buildAnimationUploadFrames` one by one, each retried up to 20 times, then starts playback with "anim-play", which
+ *   the firmware answers with "anim-ack" once the stored animation passed its CRC check.
+ */
+suspend fun uploadScrollAnimation(
+    matrix: MutableState<RGBMatrix>,
+    bluetoothManager: BluetoothManager,
+    context: Context
+) {
+    val timeoutMillis = 5000L
+    val width = matrix.value.width
+    val colors = matrixColors(matrix)
+
+    fun fail(message: String) {
+        Log.d("SendButton", message)
+        showToast(context, message, Toast.LENGTH_LONG)
     }
 
-    if (performHandshake() && sendMatrixRows()) {
-        terminateConnection()
+    wakePlayback(bluetoothManager)
+    bluetoothManager.sendData("syn:%02x".format(PROTO_CAP_BINARY_FRAMES))
+    val synAck = bluetoothManager.receiveData(timeoutMillis)
+    if (synAck == null || !synAck.startsWith("syn-ack:") ||
+        ((synAck.substringAfter("syn-ack:").toIntOrNull(16) ?: 0) and PROTO_CAP_BINARY_FRAMES) == 0) {
+        fail("Animations need binary frames, received: $synAck")
+        return
+    }
+    bluetoothManager.sendData("ack")
+
+    bluetoothManager.sendData(ANIM_INFO)
+    val storageSize = bluetoothManager.receiveData(timeoutMillis)?.lines()?.map { it.trim() }
+        ?.firstOrNull { it.startsWith("$ANIM_INFO:") }?.substringAfter("$ANIM_INFO:")?.toIntOrNull(16)
+    if (storageSize == null) {
+        fail("The device cannot store animations.")
+        return
+    }
+
+    val animation = listOf(1, 2, 4, 8).map { step ->
+        buildAnimation(scrollAnimation(colors, width, step), fps = 8, loop = true, autoplay = true)
+    }.firstOrNull { it.size <= storageSize }
+    if (animation == null) {
+        fail("The animation does not fit into the $storageSize bytes of the device.")
+        return
+    }
+    Log.d("SendButton", "Uploading animation: ${animation[1].toInt() and 0xFF} frames, ${animation.size} of $storageSize bytes")
+
+    for (frame in buildAnimationUploadFrames(animation)) {
+        var tryCount = 0
+        var reply: String? = "ROW-FAIL"
+        while (reply != "ROW-SUCCESS" && tryCount < 20) {
+            bluetoothManager.sendBytes(frame)
+            reply = bluetoothManager.receiveData(timeoutMillis)
+            tryCount++
+        }
+        if (reply != "ROW-SUCCESS") {
+            fail("Failed to upload the animation.")
+            return
+        }
+    }
+
+    bluetoothManager.sendData(ANIM_PLAY)
+    if (bluetoothManager.receiveData(timeoutMillis) == ANIM_ACK) {
+        showToast(context, "Animation stored and playing.", Toast.LENGTH_SHORT)
     } else {
-        Toast.makeText(context, "Failed to send matrix data.", Toast.LENGTH_LONG).show()
+        fail("The device rejected the uploaded animation.")
     }
 }
 
@@ -313,8 +802,11 @@ fun handshakeSendPixelQaurterRows(
  *   - For "black", it sends "set-leds-black".
  *
  * - This function is typically used to control the color of an LED display or similar device via Bluetooth.
+ *
+ * - The command is preceded by the newlines of `sendWakeNewlines`, which stop a running animation or effect from refreshing over it.
  */
 fun sendColor(color: String, bluetoothManager: BluetoothManager) {
+    sendWakeNewlines(bluetoothManager)
     if (color == "red") {
         bluetoothManager.sendData("set-leds-red")
     }
@@ -7,30 +7,29 @@ import com.example.projectcolor.bluetooth.BluetoothManager
 import java.io.IOException
 
 /**
- * addChecksumToRow is a function that appends a checksum to a given hexadecimal string. The checksum is calculated from the binary
- * representation of the input data to ensure data integrity during transmission.
+ * addChecksumToRow is a function that converts pixel bytes to a hexadecimal string and appends their checksum. The checksum is
+ * calculated directly from the bytes to ensure data integrity during transmission.
  *
  * **Parameters:**
  *
- * - `data`: A `String` representing the hexadecimal data to which the checksum will be added.
+ * - `data`: A `ByteArray` holding the pixel bytes to which the checksum will be added.
  *
  * **Returns:**
  *
- * - `String`: Returns the original hexadecimal string with the checksum appended to the end.
+ * - `String`: Returns the hexadecimal string of the bytes with the checksum appended to the end.
  *
  * **Functionality:**
  *
- * - The function converts the input hexadecimal string to its binary representation using `hexStringToBinaryString`.
- * - It calculates an 8-bit checksum from the binary data using the `checkSum` function.
- * - The checksum is then converted from binary to a 2-character hexadecimal string, ensuring it is padded with leading zeros if necessary.
- * - The original data string is concatenated with the checksum, and the combined string is returned.
+ * - It calculates an 8-bit one's complement checksum from the bytes using the `onesComplementChecksum` function.
+ * - The checksum is then converted to a 2-character hexadecimal string, ensuring it is padded with leading zeros if necessary.
+ * - The hexadecimal data string is concatenated with the checksum, and the combined string is returned.
  *
  * - This function is typically used to add a checksum to data being prepared for transmission, allowing the receiver to verify the integrity of the received data.
  */
-fun addChecksumToRow(data: String): String{
-    var checksum = checkSum(hexStringToBinaryString(data), 8)
-    checksum = checksum.toInt(2).toString(16).padStart(2, '0')
-    return (data + checksum)
+@OptIn(ExperimentalStdlibApi::class)
+fun addChecksumToRow(data: ByteArray): String{
+    val checksum = onesComplementChecksum(data).toString(16).padStart(2, '0')
+    return (data.toHexString() + checksum)
 }
 
 /**
@@ -44,12 +43,19 @@ fun addChecksumToRow(data: String): String{
  * - `part`: An `Int` indicating which quarter of the row to send. The value should be between 0 and 3, where each value corresponds to a specific quarter of the row.
  * - `bluetoothManager`: A `BluetoothManager` instance responsible for managing the Bluetooth connection and transmitting the serialized data.
  * - `addition`: A `String` that can be prepended to the serialized quarter-row message before transmission. This parameter is optional and defaults to an empty string.
+ * - `framed`: A `Boolean` selecting the binary frame format negotiated with `PROTO_CAP_BINARY_FRAMES`. When `false` (the default),
+ *   the hexadecimal text format is used and `addition` is prepended; when `true`, `addition` is ignored.
+ * - `fec`: A `Boolean` adding the check bytes negotiated with `PROTO_CAP_FEC` to the frame. The default value is `false`.
+ * - `keepReplies`: A `Boolean` passed on to `sendData` or `sendBytes`; set it when the quarter row is resent, so a late reply to
+ *   the earlier copy is not dropped. The default value is `false`.
  *
  * **Functionality:**
  *
  * - The function serializes the specified quarter of the row using the `serializeQuarterRow` function.
  * - It concatenates the `addition` string with the serialized quarter-row data to form the full message.
  * - The full message is then sent to the Bluetooth device using the `bluetoothManager.sendData` function.
+ * - In framed mode the quarter row is wrapped by `serializeQuarterRowFrame` and written with `bluetoothManager.sendBytes` instead,
+ *   which takes 22 bytes on the wire compared to 40 for the text message. With `fec` the frame gets its check bytes from `protectFrame`.
  * - The function logs the row number, the quarter number, and the full message for debugging purposes.
  */
 fun sendQuarterRow(
@@ -57,14 +63,24 @@ fun sendQuarterRow(
     row: Int,
     part: Int, // 0(first half) or 1(second half)
     bluetoothManager: BluetoothManager,
-    addition: String = ""
+    addition: String = "",
+    framed: Boolean = false,
+    fec: Boolean = false,
+    keepReplies: Boolean = false
 ) {
+    if (framed) {
+        val frame = serializeQuarterRowFrame(matrix, row, part).let { if (fec) protectFrame(it) else it }
+        bluetoothManager.sendBytes(frame, keepReplies)
+        Log.d("SendButton", "Row $row, part $part frame: ${frame.size} bytes")
+        return
+    }
+
     val serializedQuarterRow = serializeQuarterRow(matrix, row, part)
 //    Log.d("SendButton", "serializedRow: \n$serializedHalfRow")
 
     // Send the entire row as one message
     val fullMessage = addition + serializedQuarterRow
-    bluetoothManager.sendData(fullMessage)
+    bluetoothManager.sendData(fullMessage, keepReplies)
     Log.d("SendButton", "Row $row, part $part message:\n$fullMessage")
 }
 
@@ -84,21 +100,72 @@ fun sendQuarterRow(
  *
  * **Functionality:**
  *
- * - The function creates a `ByteArray` of size 16, where each set of four bytes represents one pixel in the quarter of the row being serialized.
- * - For each pixel in the specified quarter, the function calculates the pixel's position in the grid, and converts the red, green, and blue color values into bytes, storing them in the `ByteArray`.
- * - The function catches any `IOException` that may occur during serialization and logs an error message.
- * - The `ByteArray` is then converted to a hexadecimal string using the `toHexString` extension function.
- * - A checksum is added to the serialized string using the `addChecksumToRow` function to ensure data integrity.
+ * - The pixel bytes of the quarter row are produced by `quarterRowBytes`.
+ * - The bytes are converted to a hexadecimal string with a checksum appended using the `addChecksumToRow` function to ensure data integrity.
  *
  * - The resulting string, which includes the pixel data and checksum, is returned for further use, typically for transmission to an external device.
  */
-@OptIn(ExperimentalStdlibApi::class)
 fun serializeQuarterRow(
     matrix: MutableState<RGBMatrix>,
     row: Int = 0,
     part: Int = 0,
 ): String {
 
+    return addChecksumToRow(quarterRowBytes(matrix, row, part))
+}
+
+/**
+ * serializeQuarterRowFrame is a function that serializes a specific quarter of a row from a pixel grid into a binary `FRAME_TYPE_PIXELS` frame.
+ *
+ * **Parameters:**
+ *
+ * - `matrix`: A `MutableState<RGBMatrix>` representing the pixel grid data to be serialized.
+ * - `row`: An `Int` representing the index of the row to be serialized. The default value is `0`.
+ * - `part`: An `Int` indicating which quarter of the row to serialize, between 0 and 3. The default value is `0`.
+ * - `sequence`: An `Int?` holding the sequence number for the sliding-window mode (`PROTO_CAP_WINDOW`). When set, a
+ *   `FRAME_TYPE_PIXELS_SEQ` frame is built with the low byte of the number in front of the pixels. The default value is `null`.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns the complete frame, including delimiters and CRC, as built by `buildFrame`.
+ */
+fun serializeQuarterRowFrame(
+    matrix: MutableState<RGBMatrix>,
+    row: Int = 0,
+    part: Int = 0,
+    sequence: Int? = null,
+): ByteArray {
+    if (sequence == null) {
+        return buildFrame(FRAME_TYPE_PIXELS, quarterRowBytes(matrix, row, part))
+    }
+    return buildFrame(FRAME_TYPE_PIXELS_SEQ, byteArrayOf(sequence.toByte()) + quarterRowBytes(matrix, row, part))
+}
+
+/**
+ * quarterRowBytes is a function that collects the raw pixel bytes of a specific quarter of a row from a pixel grid.
+ *
+ * **Parameters:**
+ *
+ * - `matrix`: A `MutableState<RGBMatrix>` representing the pixel grid data to be serialized.
+ * - `row`: An `Int` representing the index of the row to be serialized.
+ * - `part`: An `Int` indicating which quarter of the row to serialize, between 0 and 3.
+ *
+ * **Returns:**
+ *
+ * - `ByteArray`: Returns 16 bytes, four per pixel: the position (`(row shl 4) + column`) followed by the red, green, and blue values.
+ *
+ * **Functionality:**
+ *
+ * - The function creates a `ByteArray` of size 16, where each set of four bytes represents one pixel in the quarter of the row being serialized.
+ * - For each pixel in the specified quarter, the function calculates the pixel's position in the grid, and converts the red, green, and blue color values into bytes, storing them in the `ByteArray`.
+ * - The function catches any `IOException` that may occur during serialization and logs an error message.
+ */
+fun quarterRowBytes(
+    matrix: MutableState<RGBMatrix>,
+    row: Int,
+    part: Int,
+): ByteArray {
+
     val byteArray = ByteArray(4*4)
     var index = 0
     try {
@@ -114,10 +181,7 @@ fun serializeQuarterRow(
         Log.e("MainActivity", "Error serializing matrix", e)
     }
 
-    var byteArrayString = byteArray.toHexString()
-    byteArrayString = addChecksumToRow(byteArrayString) //+ "\n"
-
-    return byteArrayString
+    return byteArray
 }
 
 // Adds checksum to a row of pixel data
@@ -0,0 +1,100 @@
+package com.example.projectcolor.components
+
+import android.widget.Toast
+import androidx.compose.foundation.layout.Row
+import androidx.compose.foundation.layout.padding
+import androidx.compose.material3.Button
+import androidx.compose.material3.Text
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.MutableState
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableStateOf
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.rememberCoroutineScope
+import androidx.compose.runtime.setValue
+import androidx.compose.ui.Alignment
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.platform.LocalContext
+import androidx.compose.ui.unit.dp
+import com.example.projectcolor.RGBMatrix
+import com.example.projectcolor.bluetooth.BluetoothManager
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * StreamButton is a Composable function that mirrors the pixel grid on the panel live, while it is being drawn, with the real-time
+ * streaming mode (`PROTO_CAP_STREAM`).
+ *
+ * **Parameters:**
+ *
+ * - `modifier`: A `Modifier` applied to the row. The default value is `Modifier`.
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the stream.
+ * - `matrix`: A `MutableState<RGBMatrix>` holding the canvas; it is read anew for every frame.
+ *
+ * **UI Structure:**
+ *
+ * - A "Stream" button, enabled while a device is connected and the canvas has the panel's 16x16 pixels, starts the stream with
+ *   `startStream` and `streamFrames` on the IO dispatcher. While streaming it reads "Stop" and ends the stream. The stream runs in
+ *   the scope of the composition, so leaving the screen cancels it, and it ends by itself when the connection drops.
+ * - A text next to it shows the frames shown and dropped according to the device's latest report.
+ */
+@Composable
+fun StreamButton(
+    modifier: Modifier = Modifier,
+    bluetoothManager: BluetoothManager,
+    matrix: MutableState<RGBMatrix>,
+) {
+    val context = LocalContext.current
+    val scope = rememberCoroutineScope()
+    val running = remember { AtomicBoolean(false) }
+    var streaming by remember { mutableStateOf(false) }
+    var status by remember { mutableStateOf("") }
+
+    Row(
+        modifier = modifier.padding(top = 8.dp, bottom = 8.dp, start = 16.dp, end = 16.dp),
+        verticalAlignment = Alignment.CenterVertically
+    ) {
+        Button(
+            modifier = Modifier.padding(horizontal = 4.dp),
+            onClick = {
+                if (streaming) {
+                    running.set(false)
+                    return@Button
+                }
+                streaming = true
+                running.set(true)
+                status = ""
+                scope.launch(Dispatchers.IO) {
+                    val caps = startStream(bluetoothManager)
+                    if (caps != null) {
+                        var shown = 0
+                        var dropped = 0
+                        streamFrames(
+                            bluetoothManager,
+                            caps,
+                            nextFrame = { if (running.get() && bluetoothManager.isConnected()) matrixColors(matrix) else null },
+                            onReport = { report ->
+                                shown += report.shown
+                                dropped += report.dropped
+                                val text = "$shown shown, $dropped dropped"
+                                withContext(Dispatchers.Main) { status = text }
+                            }
+                        )
+                    }
+                    withContext(Dispatchers.Main) {
+                        streaming = false
+                        if (caps == null) {
+                            Toast.makeText(context, "The device cannot stream.", Toast.LENGTH_SHORT).show()
+                        }
+                    }
+                }
+            },
+            enabled = bluetoothManager.isConnected() && matrix.value.width == 16 && matrix.value.height == 16
+        ) {
+            Text(text = if (streaming) "Stop" else "Stream", maxLines = 1)
+        }
+        Text(modifier = Modifier.padding(horizontal = 4.dp), text = status, maxLines = 1)
+    }
+}
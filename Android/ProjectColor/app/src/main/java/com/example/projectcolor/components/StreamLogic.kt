@@ -0,0 +1,175 @@
+package com.example.projectcolor.components
+
+import android.util.Log
+import com.example.projectcolor.bluetooth.BluetoothManager
+import kotlinx.coroutines.CancellationException
+import kotlinx.coroutines.delay
+
+const val STREAM_HEADER_SIZE = 2
+const val STREAM_CHUNK_PIXELS = 16
+const val STREAM_REPORT_INTERVAL = 16
+const val STREAM_STOP = "stream-stop"
+const val STREAM_REPORT_PREFIX = "stream:"
+const val STREAM_SHOW_PAUSE_MILLIS = 10L
+const val STREAM_IDLE_POLL_MILLIS = 20L
+const val STREAM_REPORT_TIMEOUT_MILLIS = 500L
+
+/**
+ * StreamReport holds one "stream:" report of the device.
+ *
+ * - `lastShown`: The sequence number of the last frame shown, 0..255.
+ * - `shown`, `dropped`: Frames shown and frames given up since the previous report. A frame lost without any of its chunks
+ *   arriving is in neither.
+ */
+data class StreamReport(val lastShown: Int, val shown: Int, val dropped: Int)
+
+/**
+ * buildStreamFrames is a function that splits one frame into the `FRAME_TYPE_STREAM` chunks of the real-time streaming mode.
+ *
+ * **Parameters:**
+ *
+ * - `colors`: An `IntArray` holding `0xRRGGBB` per pixel, indexed by `row * width + column`, as returned by `matrixColors`.
+ * - `sequence`: An `Int` holding the frame sequence number; only its low byte is sent.
+ *
+ * **Returns:**
+ *
+ * - `List<ByteArray>`: Returns one frame per `STREAM_CHUNK_PIXELS` pixels: the sequence, the chunk index and the colors, 3 bytes
+ *   each. A chunk carries no positions, so a 16x16 frame takes 16 frames of 50 payload bytes.
+ */
+fun buildStreamFrames(colors: IntArray, sequence: Int): List<ByteArray> {
+    return (0 until colors.size / STREAM_CHUNK_PIXELS).map { chunk ->
+        val payload = ByteArray(STREAM_HEADER_SIZE + STREAM_CHUNK_PIXELS * 3)
+        payload[0] = sequence.toByte()
+        payload[1] = chunk.toByte()
+        for (i in 0 until STREAM_CHUNK_PIXELS) {
+            colorBytes(colors[chunk * STREAM_CHUNK_PIXELS + i]).copyInto(payload, STREAM_HEADER_SIZE + i * 3)
+        }
+        buildFrame(FRAME_TYPE_STREAM, payload)
+    }
+}
+
+/**
+ * parseStreamReport is a function that reads a "stream:<last shown>:<shown>:<dropped>" report, all fields in hex.
+ *
+ * **Parameters:**
+ *
+ * - `response`: A `String?` holding what `receiveData` returned; the report may share it with other lines.
+ *
+ * **Returns:**
+ *
+ * - `StreamReport?`: Returns the report, or `null` if there is none.
+ */
+fun parseStreamReport(response: String?): StreamReport? {
+    val fields = response?.lines()?.map { it.trim() }?.firstOrNull { it.startsWith(STREAM_REPORT_PREFIX) }
+        ?.substringAfter(STREAM_REPORT_PREFIX)?.split(":")?.map { it.toIntOrNull(16) } ?: return null
+    if (fields.size != 3 || fields.any { it == null }) {
+        return null
+    }
+    return StreamReport(fields[0]!!, fields[1]!!, fields[2]!!)
+}
+
+/**
+ * isStreamReport is a function that tells whether a reply line is a stream report; `receiveData` drops all other lines with it.
+ *
+ * **Parameters:**
+ *
+ * - `line`: A `String` holding one reply line.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` if the line starts with `STREAM_REPORT_PREFIX`.
+ */
+fun isStreamReport(line: String): Boolean = line.startsWith(STREAM_REPORT_PREFIX)
+
+/**
+ * startStream is a function that opens a streaming session with the capability handshake.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used for the exchange.
+ * - `timeoutMillis`: A `Long` holding how long to wait for "syn-ack". The default value is `2000L`.
+ *
+ * **Returns:**
+ *
+ * - `Int?`: Returns the capabilities the device accepted, `PROTO_CAP_STREAM` among them, or `null` if it cannot stream.
+ *
+ * **Functionality:**
+ *
+ * - Offers `PROTO_CAP_STREAM` and `PROTO_CAP_FEC` on top of binary frames; with FEC the device repairs single corrupted bytes, so
+ *   fewer frames are dropped on a noisy link.
+ * - A device that plays an animation or effect is woken with `wakePlayback` first.
+ */
+suspend fun startStream(bluetoothManager: BluetoothManager, timeoutMillis: Long = 2000L): Int? {
+    val offered = PROTO_CAP_BINARY_FRAMES or PROTO_CAP_STREAM or PROTO_CAP_FEC
+    for (attempt in 0 until 3) {
+        wakePlayback(bluetoothManager)
+        bluetoothManager.sendData("syn:%02x".format(offered))
+        val response = bluetoothManager.receiveData(timeoutMillis)
+        if (response != null && response.startsWith("syn-ack:")) {
+            bluetoothManager.sendData("ack")
+            val caps = response.substringAfter("syn-ack:").substringBefore(":").trim().toIntOrNull(16) ?: 0
+            if (caps and PROTO_CAP_STREAM == 0) {
+                Log.d("StreamLogic", "The device cannot stream, received: $response")
+                return null
+            }
+            return caps
+        }
+        if (response != null && response.startsWith("Unknown message")) {
+            return null
+        }
+    }
+    return null
+}
+
+/**
+ * streamFrames is a function that streams frames to the device without acknowledgments until `nextFrame` returns `null`, then
+ * ends the stream with `STREAM_STOP`.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance used to send the frames.
+ * - `caps`: An `Int` holding the capabilities returned by `startStream`.
+ * - `nextFrame`: A function returning the newest frame as `0xRRGGBB` per pixel, or `null` to stop.
+ * - `onReport`: A suspending function called with every report of the device, on the caller's dispatcher.
+ *
+ * **Functionality:**
+ *
+ * - Always the newest frame is sent; frames the canvas went through in the meantime are skipped, and an unchanged canvas is not
+ *   sent again. Nothing is resent: a frame the device could not complete is dropped there and counted in the next report.
+ * - After every frame the function pauses `STREAM_SHOW_PAUSE_MILLIS`, as the device drops bytes during the display refresh.
+ * - After the last frame of every group of `STREAM_REPORT_INTERVAL` frames it waits up to `STREAM_REPORT_TIMEOUT_MILLIS` for the
+ *   report, since the device cannot receive while it sends one. A missing report only costs that wait.
+ * - A cancelled stream still sends `STREAM_STOP`, without waiting for the last report.
+ */
+suspend fun streamFrames(
+    bluetoothManager: BluetoothManager,
+    caps: Int,
+    nextFrame: () -> IntArray?,
+    onReport: suspend (StreamReport) -> Unit
+) {
+    var sequence = 0
+    var previous: IntArray? = null
+    try {
+        while (true) {
+            val colors = nextFrame() ?: break
+            if (previous != null && colors.contentEquals(previous)) {
+                delay(STREAM_IDLE_POLL_MILLIS)
+                continue
+            }
+            previous = colors
+            for (frame in buildStreamFrames(colors, sequence)) {
+                bluetoothManager.sendBytes(if (caps and PROTO_CAP_FEC != 0) protectFrame(frame) else frame)
+            }
+            delay(STREAM_SHOW_PAUSE_MILLIS)
+            if (sequence % STREAM_REPORT_INTERVAL == STREAM_REPORT_INTERVAL - 1) {
+                parseStreamReport(bluetoothManager.receiveData(STREAM_REPORT_TIMEOUT_MILLIS, ::isStreamReport))?.let { onReport(it) }
+            }
+            sequence = (sequence + 1) and 0xFF
+        }
+    } catch (e: CancellationException) {
+        bluetoothManager.sendData(STREAM_STOP)
+        throw e
+    }
+    bluetoothManager.sendData(STREAM_STOP)
+    parseStreamReport(bluetoothManager.receiveData(STREAM_REPORT_TIMEOUT_MILLIS, ::isStreamReport))?.let { onReport(it) }
+}
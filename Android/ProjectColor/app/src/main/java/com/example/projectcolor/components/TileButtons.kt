@@ -0,0 +1,183 @@
+package com.example.projectcolor.components
+
+import android.content.Context
+import android.widget.Toast
+import androidx.compose.foundation.layout.Row
+import androidx.compose.foundation.layout.padding
+import androidx.compose.material3.Button
+import androidx.compose.material3.Text
+import androidx.compose.runtime.Composable
+import androidx.compose.runtime.MutableState
+import androidx.compose.runtime.getValue
+import androidx.compose.runtime.mutableStateListOf
+import androidx.compose.runtime.mutableStateOf
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.setValue
+import androidx.compose.ui.Alignment
+import androidx.compose.ui.Modifier
+import androidx.compose.ui.platform.LocalContext
+import androidx.compose.ui.unit.dp
+import com.example.projectcolor.RGBMatrix
+import com.example.projectcolor.bluetooth.BluetoothManager
+import kotlinx.coroutines.CoroutineScope
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.launch
+import kotlinx.coroutines.withContext
+
+/**
+ * TileButtons is a Composable function that builds a wall of several panels, each with its own firmware and Bluetooth link, and
+ * shows the pixel grid across all of them.
+ *
+ * **Parameters:**
+ *
+ * - `modifier`: A `Modifier` applied to the row of buttons. The default value is `Modifier`.
+ * - `matrix`: A `MutableState<RGBMatrix>` holding the canvas. It is replaced by a larger, empty grid when a panel extends the wall.
+ *
+ * **UI Structure:**
+ *
+ * - An "Add panel" button opens the `DevicesDialog`. The chosen device gets its own `BluetoothManager`; its tile is read with
+ *   `queryTile`. A panel whose tile overlaps another panel is moved to the offset from `nextTileOffset` with `storeTile`.
+ * - A "Send tiles" button, enabled once a panel was added, shows the canvas on all panels with `sendTiledFrame` and reports the
+ *   result with a Toast.
+ * - A "Clear" button disconnects all panels of the wall.
+ *
+ * - The Bluetooth exchanges run on the IO dispatcher; `sendTiledFrame` serves the panels concurrently.
+ */
+@Composable
+fun TileButtons(
+    modifier: Modifier = Modifier,
+    matrix: MutableState<RGBMatrix>,
+) {
+    val context = LocalContext.current
+    val panels = remember { mutableStateListOf<TilePanel>() }
+    var pendingManager by remember { mutableStateOf<BluetoothManager?>(null) }
+
+    Row(
+        modifier = modifier.padding(top = 8.dp, bottom = 8.dp, start = 16.dp, end = 16.dp),
+        verticalAlignment = Alignment.CenterVertically
+    ) {
+        Button(
+            modifier = Modifier
+                .weight(1f)
+                .padding(horizontal = 4.dp),
+            onClick = { pendingManager = BluetoothManager(context) }
+        ) {
+            Text(text = "Add panel", maxLines = 1)
+        }
+
+        Button(
+            modifier = Modifier
+                .weight(1f)
+                .padding(horizontal = 4.dp),
+            onClick = {
+                sendTiles(panels.toList(), matrixColors(matrix), matrix.value.width, matrix.value.height, context)
+            },
+            enabled = panels.isNotEmpty() && matrix.value.width >= canvasSize(panels).first
+        ) {
+            Text(text = "Send tiles (${panels.size})", maxLines = 1)
+        }
+
+        Button(
+            modifier = Modifier
+                .weight(1f)
+                .padding(horizontal = 4.dp),
+            onClick = {
+                panels.forEach { it.bluetoothManager.cancelConnection() }
+                panels.clear()
+            },
+            enabled = panels.isNotEmpty()
+        ) {
+            Text(text = "Clear", maxLines = 1)
+        }
+    }
+
+    pendingManager?.let { bluetoothManager ->
+        DevicesDialog(
+            pairedDevices = bluetoothManager.getPairedDevices(),
+            discoveredDevices = emptySet(),
+            onDismissRequest = {
+                pendingManager = null
+                bluetoothManager.cancelConnection()
+            },
+            onConnectClick = { device ->
+                bluetoothManager.connectToDevice(device) { success ->
+                    pendingManager = null
+                    if (success) {
+                        addPanel(bluetoothManager, panels, matrix, context)
+                    } else {
+                        Toast.makeText(context, "Connection failed. Try again.", Toast.LENGTH_SHORT).show()
+                    }
+                }
+            }
+        )
+    }
+}
+
+/**
+ * addPanel is a function that reads the tile of a newly connected panel and adds it to the wall.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` connected to the new panel.
+ * - `panels`: A `MutableList<TilePanel>` holding the panels of the wall; the new panel is added on the main thread.
+ * - `matrix`: A `MutableState<RGBMatrix>` holding the canvas. It becomes a square grid covering the whole wall.
+ * - `context`: A `Context` used to display Toast messages.
+ */
+private fun addPanel(
+    bluetoothManager: BluetoothManager,
+    panels: MutableList<TilePanel>,
+    matrix: MutableState<RGBMatrix>,
+    context: Context
+) {
+    CoroutineScope(Dispatchers.IO).launch {
+        var panel = queryTile(bluetoothManager)
+        if (panel != null) {
+            val wall = withContext(Dispatchers.Main) { panels.toList() }
+            val current = panel
+            if (wall.any { current.x < it.x + it.size && it.x < current.x + current.size &&
+                        current.y < it.y + it.size && it.y < current.y + current.size }) {
+                val (x, y) = nextTileOffset(wall, current.size)
+                panel = current.copy(x = x, y = y)
+                if (!storeTile(panel)) {
+                    panel = null
+                }
+            }
+        }
+
+        val added = panel
+        withContext(Dispatchers.Main) {
+            if (added == null) {
+                bluetoothManager.cancelConnection()
+                Toast.makeText(context, "The panel did not report its tile.", Toast.LENGTH_SHORT).show()
+                return@withContext
+            }
+            panels.add(added)
+            val (width, height) = canvasSize(panels)
+            val side = maxOf(width, height)
+            if (matrix.value.width != side) {
+                matrix.value = RGBMatrix(side, side)
+            }
+            Toast.makeText(context, "Panel added at (${added.x}, ${added.y}).", Toast.LENGTH_SHORT).show()
+        }
+    }
+}
+
+/**
+ * sendTiles is a function that shows the canvas on the wall off the main thread and reports the result with a Toast.
+ *
+ * **Parameters:**
+ *
+ * - `panels`: A `List<TilePanel>` holding the panels of the wall.
+ * - `canvas`: An `IntArray` holding the colors of the canvas, as returned by `matrixColors`.
+ * - `canvasWidth`, `canvasHeight`: `Int` dimensions of the canvas.
+ * - `context`: A `Context` used to display the Toast.
+ */
+private fun sendTiles(panels: List<TilePanel>, canvas: IntArray, canvasWidth: Int, canvasHeight: Int, context: Context) {
+    CoroutineScope(Dispatchers.IO).launch {
+        val success = sendTiledFrame(panels, canvas, canvasWidth, canvasHeight)
+        withContext(Dispatchers.Main) {
+            val message = if (success) "Tiles shown on ${panels.size} panels." else "Not every panel showed its tile."
+            Toast.makeText(context, message, Toast.LENGTH_SHORT).show()
+        }
+    }
+}
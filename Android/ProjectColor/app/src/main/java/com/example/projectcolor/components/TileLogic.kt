@@ -0,0 +1,289 @@
+package com.example.projectcolor.components
+
+import android.util.Log
+import com.example.projectcolor.bluetooth.BluetoothManager
+import kotlinx.coroutines.Dispatchers
+import kotlinx.coroutines.async
+import kotlinx.coroutines.awaitAll
+import kotlinx.coroutines.coroutineScope
+
+const val TILE_QUERY = "tile"
+const val TILE_PREFIX = "tile:"
+const val TILE_SET_PREFIX = "tile-set:"
+const val FIN_SYNC = "fin-sync"
+const val FIN_READY = "fin-ready"
+const val SHOW_STAGED = "show"
+const val FIN_ACK = "fin-ack"
+
+/**
+ * TilePanel is a data class describing one panel of a tiled wall: its own Bluetooth link and the part of the canvas it shows.
+ *
+ * - `bluetoothManager`: The `BluetoothManager` connected to the panel. Every panel needs its own, so the panels can be served at once.
+ * - `x`, `y`: The offset of the panel's top left pixel in the canvas, as stored on the device.
+ * - `size`: The number of rows and columns of the panel. The default value is `16`.
+ */
+data class TilePanel(
+    val bluetoothManager: BluetoothManager,
+    val x: Int,
+    val y: Int,
+    val size: Int = 16,
+)
+
+/**
+ * queryTile is a function that asks a device for the tile it shows in a wall of several panels.
+ *
+ * **Parameters:**
+ *
+ * - `bluetoothManager`: A `BluetoothManager` instance connected to the device.
+ * - `timeoutMillis`: A `Long` holding how long to wait for each reply. The default value is `2000L`.
+ *
+ * **Returns:**
+ *
+ * - `TilePanel?`: Returns the panel with the offset and size from the "tile:<x>:<y>:<width>:<height>" reply, or `null` when no reply
+ *   arrives after three attempts. Firmware without tiling answers "Unknown message" and is treated as a single panel at (0, 0).
+ */
+suspend fun queryTile(bluetoothManager: BluetoothManager, timeoutMillis: Long = 2000L): TilePanel? {
+    for (attempt in 0 until 3) {
+        wakePlayback(bluetoothManager)
+        bluetoothManager.sendData(TILE_QUERY)
+        val response = bluetoothManager.receiveData(timeoutMillis)
+        if (response != null && response.startsWith(TILE_PREFIX)) {
+            val fields = response.removePrefix(TILE_PREFIX).split(":").map { it.trim().toIntOrNull(16) }
+            val x = fields.getOrNull(0)
+            val y = fields.getOrNull(1)
+            val width = fields.getOrNull(2)
+            if (x != null && y != null && width != null) {
+                return TilePanel(bluetoothManager, x, y, width)
+            }
+        }
+        if (response != null && response.startsWith("Unknown message")) {
+            Log.d("TileLogic", "The device has no tile offset, using (0, 0)")
+            return TilePanel(bluetoothManager, 0, 0)
+        }
+        Log.d("TileLogic", "No tile reply, received: $response")
+    }
+    return null
+}
+
+/**
+ * storeTile is a function that stores a new tile offset on a device, which keeps it in its EEPROM across resets.
+ *
+ * **Parameters:**
+ *
+ * - `panel`: The `TilePanel` to move, with the new offset.
+ * - `timeoutMillis`: A `Long` holding how long to wait for each reply. The default value is `2000L`.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` when the device confirms the offset with its "tile:" reply.
+ */
+suspend fun storeTile(panel: TilePanel, timeoutMillis: Long = 2000L): Boolean {
+    val expected = TILE_PREFIX + "%02x:%02x:".format(panel.x, panel.y)
+    for (attempt in 0 until 3) {
+        wakePlayback(panel.bluetoothManager)
+        panel.bluetoothManager.sendData(TILE_SET_PREFIX + "%02x:%02x".format(panel.x, panel.y))
+        if (panel.bluetoothManager.receiveData(timeoutMillis)?.startsWith(expected) == true) {
+            return true
+        }
+    }
+    return false
+}
+
+/**
+ * nextTileOffset is a function that finds a place for a new panel that overlaps no panel of the wall.
+ *
+ * **Parameters:**
+ *
+ * - `panels`: A `List<TilePanel>` holding the panels of the wall.
+ * - `size`: An `Int` holding the number of rows and columns of the new panel.
+ *
+ * **Returns:**
+ *
+ * - `Pair<Int, Int>`: Returns the first free offset in row-major order on a grid of `size`, keeping the wall close to square.
+ */
+fun nextTileOffset(panels: List<TilePanel>, size: Int): Pair<Int, Int> {
+    var slots = 1
+    while (slots * slots < panels.size + 1) {
+        slots++
+    }
+    for (slot in 0 until slots * slots) {
+        val x = (slot % slots) * size
+        val y = (slot / slots) * size
+        val overlaps = panels.any { x < it.x + it.size && it.x < x + size && y < it.y + it.size && it.y < y + size }
+        if (!overlaps) {
+            return Pair(x, y)
+        }
+    }
+    return Pair(slots * size, 0)
+}
+
+/**
+ * canvasSize is a function that returns the size of the canvas covered by a set of panels.
+ *
+ * **Parameters:**
+ *
+ * - `panels`: A `List<TilePanel>` holding the panels of the wall.
+ *
+ * **Returns:**
+ *
+ * - `Pair<Int, Int>`: Returns the width and height in pixels, from (0, 0) to the right and bottom edge of the farthest panels.
+ */
+fun canvasSize(panels: List<TilePanel>): Pair<Int, Int> {
+    val width = panels.maxOfOrNull { it.x + it.size } ?: 0
+    val height = panels.maxOfOrNull { it.y + it.size } ?: 0
+    return Pair(width, height)
+}
+
+/**
+ * tileColors is a function that cuts the pixels of one panel out of the canvas.
+ *
+ * **Parameters:**
+ *
+ * - `canvas`: An `IntArray` holding the packed colors of the canvas row by row, as returned by `matrixColors`.
+ * - `canvasWidth`, `canvasHeight`: `Int` dimensions of the canvas.
+ * - `panel`: The `TilePanel` whose pixels are cut out.
+ *
+ * **Returns:**
+ *
+ * - `IntArray`: Returns the `size * size` colors of the panel row by row, so the array index of a pixel equals its position on the
+ *   panel. Pixels outside the canvas are black.
+ */
+fun tileColors(canvas: IntArray, canvasWidth: Int, canvasHeight: Int, panel: TilePanel): IntArray {
+    val colors = IntArray(panel.size * panel.size)
+    for (row in 0 until panel.size) {
+        val canvasRow = panel.y + row
+        if (canvasRow >= canvasHeight) {
+            break
+        }
+        for (column in 0 until panel.size) {
+            val canvasColumn = panel.x + column
+            if (canvasColumn < canvasWidth) {
+                colors[row * panel.size + column] = canvas[canvasRow * canvasWidth + canvasColumn]
+            }
+        }
+    }
+    return colors
+}
+
+/**
+ * stageTile is a function that transfers the tile of one panel and leaves it staged, not shown.
+ *
+ * **Parameters:**
+ *
+ * - `panel`: The `TilePanel` to send to.
+ * - `colors`: An `IntArray` holding the colors of the tile, as returned by `tileColors`.
+ * - `timeoutMillis`: A `Long` holding how long to wait for each reply. The default value is `2000L`.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` once the device answered "fin-ready".
+ *
+ * **Functionality:**
+ *
+ * - Wakes the device with `wakePlayback` and performs the "syn:<caps>" handshake offering binary compressed frames; a tile only
+ *   needs a few frames, so the other transfer modes are not negotiated.
+ * - The tile is sent with `buildCompressedFrames`, each frame retried up to 20 times until "ROW-SUCCESS". Without
+ *   `PROTO_CAP_COMPRESSED` the transfer fails, since firmware without compression has no `FIN_SYNC` either.
+ * - `FIN_SYNC` ends the transfer; the device keeps showing its old frame until `SHOW_STAGED`.
+ */
+suspend fun stageTile(panel: TilePanel, colors: IntArray, timeoutMillis: Long = 2000L): Boolean {
+    val bluetoothManager = panel.bluetoothManager
+    val appCaps = PROTO_CAP_BINARY_FRAMES or PROTO_CAP_COMPRESSED
+    var protocolCaps = 0
+
+    wakePlayback(bluetoothManager)
+    for (attempt in 0 until 3) {
+        bluetoothManager.sendData("syn:%02x".format(appCaps))
+        val response = bluetoothManager.receiveData(timeoutMillis)
+        if (response != null && response.startsWith("syn-ack:")) {
+            protocolCaps = response.split(":").getOrNull(1)?.toIntOrNull(16) ?: 0
+            bluetoothManager.sendData("ack")
+            break
+        }
+    }
+    if ((protocolCaps and PROTO_CAP_COMPRESSED) == 0) {
+        Log.d("TileLogic", "Tile (${panel.x}, ${panel.y}): no compressed frames, capabilities: $protocolCaps")
+        return false
+    }
+
+    for (frame in buildCompressedFrames(colors)) {
+        var tryCount = 0
+        var rowAck = "ROW-FAIL"
+        while (rowAck != "ROW-SUCCESS" && tryCount < 20) {
+            bluetoothManager.sendBytes(frame)
+            rowAck = bluetoothManager.receiveData(timeoutMillis).toString()
+            tryCount++
+        }
+        if (rowAck != "ROW-SUCCESS") {
+            Log.d("TileLogic", "Tile (${panel.x}, ${panel.y}): frame not acknowledged, received: $rowAck")
+            return false
+        }
+    }
+
+    for (attempt in 0 until 3) {
+        bluetoothManager.sendData(FIN_SYNC)
+        if (bluetoothManager.receiveData(timeoutMillis) == FIN_READY) {
+            return true
+        }
+    }
+    return false
+}
+
+/**
+ * showStagedTile is a function that makes one panel show its staged tile.
+ *
+ * **Parameters:**
+ *
+ * - `panel`: The `TilePanel` to commit.
+ * - `timeoutMillis`: A `Long` holding how long to wait for each reply. The default value is `2000L`.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` once "fin-ack" arrives. A lost reply is retried; showing the staged frame again does no harm.
+ */
+suspend fun showStagedTile(panel: TilePanel, timeoutMillis: Long = 2000L): Boolean {
+    for (attempt in 0 until 3) {
+        panel.bluetoothManager.sendData(SHOW_STAGED)
+        if (panel.bluetoothManager.receiveData(timeoutMillis) == FIN_ACK) {
+            return true
+        }
+    }
+    return false
+}
+
+/**
+ * sendTiledFrame is a function that shows a canvas on a wall of panels, each connected over its own Bluetooth link.
+ *
+ * **Parameters:**
+ *
+ * - `panels`: A `List<TilePanel>` holding the panels of the wall.
+ * - `canvas`: An `IntArray` holding the packed colors of the canvas row by row, as returned by `matrixColors`.
+ * - `canvasWidth`, `canvasHeight`: `Int` dimensions of the canvas.
+ *
+ * **Returns:**
+ *
+ * - `Boolean`: Returns `true` if every panel showed its tile.
+ *
+ * **Functionality:**
+ *
+ * - The links are independent, so every panel is served by its own coroutine on the IO dispatcher; the whole wall takes about as
+ *   long as its slowest panel instead of the sum of all panels.
+ * - Two phases keep the panels in step: `stageTile` transfers every tile and ends with `FIN_SYNC`, then, only if all panels are
+ *   ready, `SHOW_STAGED` goes to all panels at once. The tiles change within a few milliseconds of each other instead of one
+ *   transfer time apart. If a panel fails to stage, no panel changes.
+ */
+suspend fun sendTiledFrame(panels: List<TilePanel>, canvas: IntArray, canvasWidth: Int, canvasHeight: Int): Boolean = coroutineScope {
+    val staged = panels.map { panel ->
+        async(Dispatchers.IO) { stageTile(panel, tileColors(canvas, canvasWidth, canvasHeight, panel)) }
+    }.awaitAll()
+    if (!staged.all { it }) {
+        Log.d("TileLogic", "Not every tile was staged: $staged")
+        return@coroutineScope false
+    }
+
+    val shown = panels.map { panel ->
+        async(Dispatchers.IO) { showStagedTile(panel) }
+    }.awaitAll()
+    Log.d("TileLogic", "Tiles shown: $shown")
+    shown.all { it }
+}
@@ -2,31 +2,154 @@
 #include <AltSoftSerial.h>
 #include <FastLED.h>
 #include "checksumbin.h"
+#include "framing.h"
+#include "colordepth.h"
+#include "transport.h"
+#include "rxring.h"
+#include "perfstats.h"
+#include "trace.h"
+#include "layout.h"
+#include "frame.h"
+#include "tile.h"
+#include "framecache.h"
+#include "animation.h"
+#include "effects.h"
+#include "stream.h"
 
-#define MATRIX_SIZE 16
 #define LEDS_DATA_PIN 11
-#define NUM_LEDS 256
-#define BLOCK_SIZE 8
-
-#define SYN "syn"
-#define SYN_ACK "syn-ack"
-#define ACK "ack"
-#define ROW_SUCCESS "ROW-SUCCESS"
-#define ROW_FAIL "ROW-FAIL"
-#define FIN "fin"
-#define FIN_ACK "fin-ack"
-#define LEDS_BLACK "set-leds-black"
-#define LEDS_WHITE "set-leds-white"
-#define LEDS_RED "set-leds-red"
-#define LEDS_GREEN "set-leds-green"
-#define LEDS_BLUE "set-leds-blue"
+#define NUM_LEDS (MATRIX_WIDTH * MATRIX_HEIGHT)
+#define MESSAGE_MAX_LENGTH 24     // longest text command ("set-leds-black", "fx:..", "tile-set:.."); "data:" lines are decoded while they arrive
+#define DATA_MAX_BYTES ROW_BYTE_SIZE  // a "data:" line carries up to one row of pixels and the checksum
+#define PLAYBACK_IDLE_MILLIS 100  // line idle time before animations and effects resume; FastLED.show would drop incoming bytes
 
+// Commands and fixed replies are kept in flash; as plain literals they would be copied into SRAM at startup. Commands are matched
+// with strcmp_P / strncmp_P and replies are sent with sendReply_P.
+const char SYN[] PROGMEM = "syn";
+const char SYN_ACK[] PROGMEM = "syn-ack";
+const char SYN_CAPS_PREFIX[] PROGMEM = "syn:";
+const char ACK[] PROGMEM = "ack";
+const char DATA_PREFIX[] PROGMEM = "data:";
+const char ROW_SUCCESS[] PROGMEM = "ROW-SUCCESS";
+const char ROW_FAIL[] PROGMEM = "ROW-FAIL";
+const char FIN[] PROGMEM = "fin";
+const char FIN_GENERATION_PREFIX[] PROGMEM = "fin:";
+const char FIN_ACK[] PROGMEM = "fin-ack";
+const char FIN_SYNC[] PROGMEM = "fin-sync";
+const char FIN_SYNC_GENERATION_PREFIX[] PROGMEM = "fin-sync:";
+const char FIN_READY[] PROGMEM = "fin-ready";
+const char SHOW_STAGED[] PROGMEM = "show";
+const char TILE[] PROGMEM = "tile";
+const char TILE_SET_PREFIX[] PROGMEM = "tile-set:";
+const char DELTA_REJECT[] PROGMEM = "DELTA-REJECT";
+const char BAUD_PREFIX[] PROGMEM = "baud:";
+const char BAUD_CHECK[] PROGMEM = "baud-check";
+const char BAUD_OK[] PROGMEM = "baud-ok";
+const char STATS[] PROGMEM = "stats";
+const char STATS_RESET[] PROGMEM = "stats-reset";
+const char TRACE[] PROGMEM = "trace";
+const char ANIM_INFO[] PROGMEM = "anim-info";
+const char ANIM_PLAY[] PROGMEM = "anim-play";
+const char ANIM_STOP[] PROGMEM = "anim-stop";
+const char ANIM_ACK[] PROGMEM = "anim-ack";
+const char ANIM_FAIL[] PROGMEM = "anim-fail";
+const char FX_PREFIX[] PROGMEM = "fx:";
+const char FX_STOP[] PROGMEM = "fx-stop";
+const char FX_ACK[] PROGMEM = "fx-ack";
+const char FX_FAIL[] PROGMEM = "fx-fail";
+const char STREAM_STOP[] PROGMEM = "stream-stop";
+const char CACHE_SHOW_PREFIX[] PROGMEM = "cache-show:";
+const char CACHE_PUT_PREFIX[] PROGMEM = "cache-put:";
+const char CACHE_LIST[] PROGMEM = "cache-list";
+const char CACHE_HIT[] PROGMEM = "cache-hit";
+const char CACHE_MISS[] PROGMEM = "cache-miss";
+const char CACHE_FAIL[] PROGMEM = "cache-fail";
+const char LEDS_BLACK[] PROGMEM = "set-leds-black";
+const char LEDS_WHITE[] PROGMEM = "set-leds-white";
+const char LEDS_RED[] PROGMEM = "set-leds-red";
+const char LEDS_GREEN[] PROGMEM = "set-leds-green";
+const char LEDS_BLUE[] PROGMEM = "set-leds-blue";
+
+// Prefixes of replies with fields, joined with their format in a PSTR, and the flow control lines sent with F()
+#define SYN_ACK_CAPS_PREFIX "syn-ack:"
+#define ROW_ACK_SEQ "ROW-ACK:"
+#define ROW_SUCCESS_TAG "ROW-SUCCESS:"
+#define ROW_FAIL_SEQ "ROW-FAIL:"
+#define TILE_PREFIX "tile:"
+#define BAUD_ACK_PREFIX "baud-ack:"
+#define LINK_BUSY_LINE "\nbusy\n"
+#define LINK_READY_LINE "\nready\n"
+#define ANIM_INFO_PREFIX "anim-info:"
+#define STREAM_REPORT_PREFIX "stream:"
+
+#if BT_TRANSPORT == BT_TRANSPORT_ALTSOFTSERIAL
+AltSoftSerial bluetoothManager;  // RX 8 | TX 9
+#elif BT_TRANSPORT == BT_TRANSPORT_HARDWARE_SERIAL
+HardwareSerial& bluetoothManager = Serial;  // RX 0 | TX 1
+#else
 SoftwareSerial bluetoothManager(9, 10);  // RX | TX
+#endif
 CRGB leds[NUM_LEDS];
+typedef PanelLayout<MATRIX_WIDTH, MATRIX_HEIGHT, MATRIX_WIRING, MATRIX_ROTATION, MATRIX_ORIGIN> Panel;
+static_assert(Panel::count <= 256, "pixel positions are single bytes on the wire, and 256 LEDs already take 768 bytes of SRAM");
+PanelView<Panel> panelLeds(leds);  // leds[] by pixel position; checks leds[] against FRAME_SRAM_BUDGET
+StagedFrame<Panel::width, Panel::height> stagedFrame;  // back buffer of the frame being received, see stagePixelColor
+bool stagingSpilled = false;       // the frame being received outgrew stagedFrame and is written to leds[] directly
 
-char incomingMessage[QUARTER_ROW_HEX_CHAR_SIZE + 8];
+#define STREAM_CHUNK_COUNT (NUM_LEDS / STREAM_CHUNK_PIXELS)
+#define STREAM_ALL_CHUNKS ((uint16_t)((1UL << STREAM_CHUNK_COUNT) - 1))
+static_assert(NUM_LEDS % STREAM_CHUNK_PIXELS == 0 && STREAM_CHUNK_COUNT <= 16, "a streamed frame is at most 16 whole chunks");
+
+char incomingMessage[MESSAGE_MAX_LENGTH];
 uint8_t messageIndex = 0;
 
+uint8_t frameBuffer[FRAME_MAX_ENCODED_SIZE];
+uint8_t frameIndex = 0;
+bool receivingFrame = false;
+bool frameOverflow = false;
+
+// A "data:" line is decoded into frameBuffer while it arrives; text lines and binary frames never overlap.
+static_assert(DATA_MAX_BYTES <= FRAME_MAX_ENCODED_SIZE, "frameBuffer stages the bytes of a data: line");
+uint8_t* const dataStaging = frameBuffer;
+bool receivingData = false;
+uint8_t dataLength = 0;       // bytes staged, checksum included
+uint8_t dataSum = 0x00;       // running one's complement sum over the staged bytes
+int8_t dataHighNibble = -1;   // first hex digit of the byte being received
+bool dataInvalid = false;     // non-hex character or more than DATA_MAX_BYTES
+
+bool windowActive = false;
+uint8_t expectedSeq = 0;
+bool seqReplyPending = false;
+bool seqReplyFail = false;
+bool seqGapReported = false;
+unsigned long lastByteMillis = 0;
+
+uint8_t committedGeneration = GENERATION_UNKNOWN;
+bool framePending = false;
+uint8_t stagedGeneration = GENERATION_UNKNOWN;
+
+CRGB palette[PALETTE_MAX_SIZE];
+
+uint8_t linkBaudCode = LINK_BAUD_DEFAULT_CODE;
+bool linkSpeedPending = false;
+unsigned long linkSpeedStartMillis = 0;
+
+bool flowControlActive = false;
+bool fecActive = false;       // binary frames end with FRAME_FEC_SIZE check bytes (PROTO_CAP_FEC)
+bool taggedReplies = false;   // ROW_SUCCESS names the frame it confirms (PROTO_CAP_TAGGED_REPLIES)
+uint8_t replyTag = 0;         // CRC-8 of the binary frame being processed, named by sendRowSuccess
+
+bool animationPlaying = false;
+AnimationHeader animation;
+uint16_t animationOffset = 0;
+uint8_t animationFrame = 0;
+unsigned long animationFrameMillis = 0;
+
+bool effectRunning = false;
+EffectState effect = {EFFECT_NONE, 16, EFFECT_PALETTE_RAINBOW, 0, 0};
+
+StreamState stream = {false, false, false, false, 0, 0, 0, 0, 0};
+unsigned long effectFrameMillis = 0;
+
 
 /**
  * setup is a function that initializes the serial communication, Bluetooth module, and the LED strip. It configures the necessary settings
@@ -34,16 +157,25 @@ uint8_t messageIndex = 0;
  *
  * **Functionality:**
  *
- * - Initializes the serial communication at a baud rate of 9600 for debugging and monitoring.
- * - Initializes the Bluetooth communication using `SoftwareSerial` on pins 9 (RX) and 10 (TX) at a baud rate of 9600.
+ * - Initializes the Bluetooth communication at a baud rate of 9600 on the transport selected with `BT_TRANSPORT`: `SoftwareSerial` on
+ *   pins 9 (RX) and 10 (TX) by default, `AltSoftSerial`, or the hardware UART. A faster rate can be negotiated later with `baud:`.
  * - Sets up the LED strip using the FastLED library, specifying the LED type, data pin, and color order.
  * - Initializes the `incomingMessage` buffer to an empty string.
+ * - Starts the stored animation if it is valid and was uploaded with `ANIM_FLAG_AUTOPLAY`.
  */
 void setup() {
-  Serial.begin(9600);
-  bluetoothManager.begin(9600);
+  bluetoothManager.begin(linkBaudRate(LINK_BAUD_DEFAULT_CODE));
   incomingMessage[0] = '\0';
   FastLED.addLeds<WS2812B, LEDS_DATA_PIN, GRB >(leds, NUM_LEDS);
+  perfStatsReset();
+#if FRAME_CACHE_SIZE > 0
+  frameCacheBegin();
+#endif
+
+  AnimationHeader header;
+  if (animReadHeader(header) && (header.flags & ANIM_FLAG_AUTOPLAY)) {
+    startAnimation();
+  }
 }
 
 /**
@@ -52,28 +184,145 @@ void setup() {
  *
  * **Functionality:**
  *
- * - Continuously checks if data is available from the Bluetooth module.
- * - Reads each character from the Bluetooth input, building a message until a newline or carriage return is encountered.
+ * - Continuously moves the data available from the Bluetooth module into the receive ring buffer with `pumpReceive` and processes it from there.
+ * - A `FRAME_DELIMITER` byte switches the receiver into binary mode; the bytes up to the next delimiter are collected in `frameBuffer`
+ *   and handed to `processFrame`. Consecutive delimiters are treated as idle sync bytes.
+ * - Outside of a binary frame, reads each character from the Bluetooth input, building a text message until a newline or carriage return is encountered.
+ * - Once a line starts with `DATA_PREFIX`, the rest is not stored as text: `receiveDataChar` decodes each hex digit as it arrives and
+ *   `processDataLine` checks and applies the pixels at the end of the line.
+ * - A `FRAME_DELIMITER` also discards a partially received text message, so a lost delimiter cannot glue frame bytes to the next command.
  * - Once a complete message is received, it is passed to the `processMessage` function for further processing.
  * - Resets the `incomingMessage` buffer and index after each message is processed to prepare for the next incoming message.
+ * - When the input has been idle for `SEQ_ACK_IDLE_MILLIS`, a pending windowed acknowledgment is sent with `sendSeqReply`, and a
+ *   due stream report with `sendStreamReport`. A streamed frame still incomplete after `STREAM_STALE_MILLIS` is dropped.
+ * - A new link speed that the app has not confirmed with `BAUD_CHECK` within `LINK_SPEED_TIMEOUT_MILLIS` falls back to 9600. A
+ *   confirmed one is kept until the app negotiates again; a silent fallback would leave an idle app at the raised rate.
+ * - While a stored animation plays, shows its next frame every `1000 / fps` ms with `playAnimationFrame`; a running effect is rendered
+ *   every `1000 / EFFECT_FPS` ms with `renderEffectFrame`. Both only run while the line is idle, see `playbackDue`.
+ * - Times the reception and processing of every message and counts text bytes dropped because `incomingMessage` is full, see `perfstats.h`.
  */
 void loop() {
 
-  while (bluetoothManager.available()) {
-    char c = bluetoothManager.read();
-    if (c == '\n' || c == '\r') {
-      if (messageIndex > 0) {
+  pumpReceive();
+  while (rxRingAvailable()) {
+    char c = rxRingGet();
+    pumpReceive();
+    if (receivingFrame) {
+      receiveFrameByte((uint8_t)c);
+    } else if ((uint8_t)c == FRAME_DELIMITER) {
+      receivingFrame = true;
+      frameIndex = 0;
+      frameOverflow = false;
+      messageIndex = 0;
+      receivingData = false;
+      PERF_MESSAGE_BEGIN();
+    } else if (c == '\n' || c == '\r') {
+      if (receivingData) {
+        PERF_STAGE(PERF_STAGE_RECEIVE, perfMessageStartMicros);
+        PERF_START(messageStart);
+        processDataLine();
+        PERF_MESSAGE(PERF_MSG_DATA, messageStart);
+        receivingData = false;
+        messageIndex = 0;
+      } else if (messageIndex > 0) {
         incomingMessage[messageIndex] = '\0';
+        PERF_STAGE(PERF_STAGE_RECEIVE, perfMessageStartMicros);
+        if (messageIndex == sizeof(incomingMessage) - 1) {
+          PERF_COUNT(messagesTruncated);
+        }
+        PERF_START(messageStart);
         processMessage(incomingMessage);
+        PERF_MESSAGE(PERF_MSG_CONTROL, messageStart);
         memset(incomingMessage, 0, sizeof(incomingMessage));  // Clear the buffer
         messageIndex = 0;                                     // Reset the index
       }
+    } else if (receivingData) {
+      receiveDataChar(c);
     } else {
+      if (messageIndex == 0) {
+        PERF_MESSAGE_BEGIN();
+      }
       if (messageIndex < sizeof(incomingMessage) - 1) {  // Ensure we don't overflow the buffer
         incomingMessage[messageIndex++] = c;
+        if (messageIndex == strlen_P(DATA_PREFIX) && strncmp_P(incomingMessage, DATA_PREFIX, messageIndex) == 0) {
+          beginDataLine();
+        }
+      } else {
+        PERF_COUNT(bytesDropped);
       }
     }
   }
+
+  if (seqReplyPending && !receivingFrame && millis() - lastByteMillis >= SEQ_ACK_IDLE_MILLIS) {
+    sendSeqReply();
+  }
+
+  if (stream.active && !receivingFrame && millis() - lastByteMillis >= SEQ_ACK_IDLE_MILLIS) {
+    if (stream.assembling && millis() - lastByteMillis >= STREAM_STALE_MILLIS) {
+      dropStreamFrame();
+    }
+    if (stream.reportPending) {
+      sendStreamReport();
+    }
+  }
+
+  if (animationPlaying && playbackDue(animationFrameMillis, 1000 / animation.fps)) {
+    playAnimationFrame();
+  }
+
+  if (effectRunning && playbackDue(effectFrameMillis, 1000 / EFFECT_FPS)) {
+    renderEffectFrame();
+  }
+
+  if (linkSpeedPending && millis() - linkSpeedStartMillis >= LINK_SPEED_TIMEOUT_MILLIS) {
+    TRACE_ERROR(TRACE_EVENT_LINK_FALLBACK, linkBaudCode, 0);
+    setLinkBaud(LINK_BAUD_DEFAULT_CODE);
+  }
+}
+
+/**
+ * sendReply is a function that sends a reply to the app and ends it with a newline, so the app's reader can tell replies apart that
+ * arrive together or in pieces, without waiting for the line to go quiet.
+ *
+ * **Parameters:**
+ *
+ * - `reply`: A `const char*` holding the reply in SRAM, e.g. one formatted with `snprintf_P`.
+ */
+void sendReply(const char* reply) {
+  bluetoothManager.write(reply);
+  bluetoothManager.write('\n');
+}
+
+/**
+ * sendReply_P is a function that sends a fixed reply kept in flash, e.g. `ROW_SUCCESS`, framed like `sendReply`.
+ *
+ * **Parameters:**
+ *
+ * - `reply`: A `PGM_P` pointing to the reply in program memory.
+ */
+void sendReply_P(PGM_P reply) {
+  bluetoothManager.print(reinterpret_cast<const __FlashStringHelper*>(reply));
+  bluetoothManager.write('\n');
+}
+
+/**
+ * sendRowSuccess is a function that confirms an applied binary frame with `ROW_SUCCESS`.
+ *
+ * **Functionality:**
+ *
+ * - With `PROTO_CAP_TAGGED_REPLIES` the reply is `ROW-SUCCESS:<crc>`, naming the CRC-8 of the frame in `replyTag`. The app resends a
+ *   frame whose reply is late, and the reply to the earlier copy may then arrive while it waits for the next frame; the tag lets
+ *   it drop that reply instead of taking it for the next frame's. Two frames in a row with the same CRC-8 cannot be told apart.
+ * - `ROW_FAIL` stays untagged: the CRC of a corrupt frame is not trustworthy, and a stale failure only costs a resend.
+ */
+void sendRowSuccess() {
+  if (!taggedReplies) {
+    sendReply_P(ROW_SUCCESS);
+    return;
+  }
+  char reply[sizeof(ROW_SUCCESS_TAG) + 2];
+  snprintf_P(reply, sizeof(reply), PSTR(ROW_SUCCESS_TAG "%02x"), replyTag);
+  sendReply(reply);
 }
 
 /**
@@ -87,229 +336,1480 @@ void loop() {
  * **Functionality:**
  *
  * - Interprets and handles different predefined messages such as `SYN`, `SYN_ACK`, `ACK`, `FIN`, and various LED control commands.
- * - Sends appropriate responses back via Bluetooth, such as `SYN-ACK`, `ACK`, `ROW_SUCCESS`, `ROW_FAIL`, and `FIN_ACK`.
- * - Processes pixel data prefixed with "data:" and verifies it using a checksum. If valid, it updates the LED display.
+ * - Answers a capability handshake `syn:<caps>` with `syn-ack:<caps>`, keeping only the capabilities (hex bit mask of `PROTO_CAP_*`)
+ *   this firmware supports. Older apps keep using the plain `syn`/`syn-ack` exchange. When `PROTO_CAP_WINDOW` is accepted the reply
+ *   is `syn-ack:<caps>:<window>` and the sequence numbers restart at 0. `PROTO_CAP_FEC` (0x100) is the first capability beyond the
+ *   low byte; firmware that parses only two hex digits never confirms it.
+ * - Sends appropriate responses back via Bluetooth, such as `SYN-ACK`, `ACK`, `ROW_SUCCESS`, `ROW_FAIL`, and `FIN_ACK`, each on its own
+ *   line (`sendReply`).
+ * - Pixel data prefixed with "data:" never reaches this function; `loop` decodes it while it arrives, see `processDataLine`.
+ * - Received pixels wait in the back buffer (`stagePixelColor`) while `leds[]` keeps the shown frame. `FIN`, `fin:<generation>`
+ *   and `SHOW_STAGED` copy them into `leds[]` with `flipStagedFrame` right before the refresh; a new `syn` discards them.
+ * - `fin:<generation>` shows the frame like `FIN` and records the hex generation ID the app gave it, so later delta frames can be
+ *   checked against it. A plain `FIN` leaves the generation unknown.
+ * - `FIN_SYNC` (or `fin-sync:<generation>`) ends a transfer like `FIN` but only stages the frame: it answers `FIN_READY` and keeps
+ *   showing the old frame. `SHOW_STAGED` then shows and commits it and answers `FIN_ACK`. The app sends `SHOW_STAGED` to every panel of
+ *   a tiled wall at once, so all tiles change together. A repeated `SHOW_STAGED` shows the same frame again.
+ * - `TILE` answers with the tile of this panel as `tile:<x>:<y>:<width>:<height>` in hex pixels; `tile-set:<x>:<y>` stores a new
+ *   offset with `tileStore` and answers the same way.
+ * - `baud:<rates>` offers a hex bit mask over `LINK_BAUD_RATES`; the fastest common rate is answered with `baud-ack:<code>` at the old
+ *   rate and then switched to with `setLinkBaud`. The app confirms it with `BAUD_CHECK`, answered by `BAUD_OK` at the new rate. The
+ *   rate is kept for later transfers, so a repeated `baud:` answers the current rate without switching again. Only offered with
+ *   `BT_MODULE_FOLLOWS_BAUD`, see `LINK_SPEED_CAPS`.
+ * - `ANIM_INFO` answers with the size of the animation storage as `anim-info:<hex bytes>`; the animation itself is uploaded with
+ *   `FRAME_TYPE_ANIMATION_DATA` frames. `ANIM_PLAY` starts the stored animation and answers `ANIM_ACK`, or `ANIM_FAIL` if the storage
+ *   holds no valid animation; `ANIM_STOP` stops it. A handshake or an LED color command stops a running animation as well.
+ * - `fx:<effect>[:<speed>[:<palette>[:<seed>]]]` starts or tunes a procedural effect and answers `FX_ACK`, or `FX_FAIL` for an
+ *   unknown effect or palette, see `startEffect`; `FX_STOP` stops it, keeping its last frame. A handshake or an LED color command stops
+ *   a running effect as well.
+ * - With `PROTO_CAP_TAGGED_REPLIES` applied binary frames are confirmed with `ROW-SUCCESS:<crc>` instead of `ROW_SUCCESS`, see
+ *   `sendRowSuccess`.
+ * - With `PROTO_CAP_STREAM` the app streams frames without acknowledgments, see `processStreamChunk`. `STREAM_STOP` ends the stream
+ *   with a last report (`sendStreamReport`).
+ * - With `PROTO_CAP_CACHE` the app shows a frame the device already holds with `cache-show:<hash>[:<generation>]` instead of sending
+ *   it: the frame is loaded from the cache (`frameCacheLoad`), shown and committed like `fin:<generation>`, and answered with
+ *   `CACHE_HIT`, or `CACHE_MISS` if the cache does not hold it. `cache-put:<hash>` stores the shown frame under its hash
+ *   (`frameCacheStore`) and `CACHE_LIST` lists the cache (`frameCacheReport`); both answer with the list, or `CACHE_FAIL`.
+ * - `TRACE` dumps the events recorded in the trace ring, see `traceDump`.
+ * - `STATS` answers with the performance statistics collected since the last reset, see `perfStatsReport`; `STATS_RESET` answers
+ *   the same way and then clears them, so each report covers one transfer.
  * - Controls the LED colors based on specific commands, setting the LEDs to black, white, red, green, or blue.
  * - Outputs unknown messages via Bluetooth for debugging purposes.
+ * - Records handshakes, fins, rate changes and rejected input in the trace ring (`trace.h`); every message is traced only with
+ *   `TRACE_LEVEL_DEBUG`. Nothing is echoed on `Serial`, which blocked the hot path for longer than the message work itself.
  */
 void processMessage(char* message) { 
-  Serial.println("entered processMessage()");
-  Serial.println("message:");
-  Serial.println(message);
+  TRACE_DEBUG(TRACE_EVENT_MESSAGE, message[0], strlen(message));
+
+  if (strcmp_P(message, SYN) == 0) {
+    stopPlayback();
+    abandonPendingFrame();
+    resetWindow(false);
+    resetStream(false);
+    flowControlActive = false;
+    fecActive = false;
+    taggedReplies = false;
+    sendReply_P(SYN_ACK);  // Send SYN-ACK with newline for better recognition
+  }
+
+  else if (strncmp_P(message, SYN_CAPS_PREFIX, strlen_P(SYN_CAPS_PREFIX)) == 0) {
+    uint16_t requestedCaps = (uint16_t)strtoul(message + strlen_P(SYN_CAPS_PREFIX), NULL, 16);
+    uint16_t acceptedCaps = requestedCaps & PROTO_CAPS_SUPPORTED;
+    if (!(acceptedCaps & PROTO_CAP_BINARY_FRAMES)) {
+      acceptedCaps &= ~PROTO_CAPS_BINARY_ONLY;  // sequenced and delta frames only exist in the binary format
+    }
+    stopPlayback();
+    abandonPendingFrame();
+    resetWindow(acceptedCaps & PROTO_CAP_WINDOW);
+    resetStream(acceptedCaps & PROTO_CAP_STREAM);
+    flowControlActive = acceptedCaps & PROTO_CAP_FLOW_CONTROL;
+    fecActive = acceptedCaps & PROTO_CAP_FEC;
+    taggedReplies = acceptedCaps & PROTO_CAP_TAGGED_REPLIES;
+
+    char reply[sizeof(SYN_ACK_CAPS_PREFIX) + 6];
+    if (windowActive) {
+      snprintf_P(reply, sizeof(reply), PSTR(SYN_ACK_CAPS_PREFIX "%02x:%02x"), acceptedCaps, SEQ_WINDOW_SIZE);
+    } else {
+      snprintf_P(reply, sizeof(reply), PSTR(SYN_ACK_CAPS_PREFIX "%02x"), acceptedCaps);
+    }
+    sendReply(reply);
+    TRACE_INFO(TRACE_EVENT_SYN, acceptedCaps & 0xFF, acceptedCaps >> 8);
+  }
+
+  else if (strcmp_P(message, SYN_ACK) == 0) {
+    sendReply_P(ACK);  // Send ACK with newline for better recognition
+  }
+
+  else if (strcmp_P(message, ACK) == 0) {
+    // Handshake completed by the app, nothing to answer
+  }
+
+  else if (strcmp_P(message, FIN) == 0) {
+    flipStagedFrame();
+    showLeds();
+    sendReply_P(FIN_ACK);
+    TRACE_INFO(TRACE_EVENT_FIN, GENERATION_UNKNOWN, 0);
+    commitFrame(GENERATION_UNKNOWN);
+  }
+
+  else if (strncmp_P(message, FIN_GENERATION_PREFIX, strlen_P(FIN_GENERATION_PREFIX)) == 0) {
+    flipStagedFrame();
+    showLeds();
+    sendReply_P(FIN_ACK);
+    commitFrame((uint8_t)strtoul(message + strlen_P(FIN_GENERATION_PREFIX), NULL, 16));
+    TRACE_INFO(TRACE_EVENT_FIN, committedGeneration, 0);
+  }
+
+  else if (strcmp_P(message, FIN_SYNC) == 0) {
+    stagedGeneration = GENERATION_UNKNOWN;
+    sendReply_P(FIN_READY);
+  }
+
+  else if (strncmp_P(message, FIN_SYNC_GENERATION_PREFIX, strlen_P(FIN_SYNC_GENERATION_PREFIX)) == 0) {
+    stagedGeneration = (uint8_t)strtoul(message + strlen_P(FIN_SYNC_GENERATION_PREFIX), NULL, 16);
+    sendReply_P(FIN_READY);
+  }
+
+  else if (strcmp_P(message, SHOW_STAGED) == 0) {
+    flipStagedFrame();
+    showLeds();
+    sendReply_P(FIN_ACK);
+    commitFrame(stagedGeneration);
+    TRACE_INFO(TRACE_EVENT_FIN, committedGeneration, 0);
+  }
+
+  else if (strcmp_P(message, TILE) == 0) {
+    sendTile();
+  }
+
+  else if (strncmp_P(message, TILE_SET_PREFIX, strlen_P(TILE_SET_PREFIX)) == 0) {
+    char* field;
+    uint8_t x = (uint8_t)strtoul(message + strlen_P(TILE_SET_PREFIX), &field, 16);
+    uint8_t y = *field == ':' ? (uint8_t)strtoul(field + 1, NULL, 16) : 0;
+    tileStore(x, y);
+    sendTile();
+  }
+
+  else if (strncmp_P(message, BAUD_PREFIX, strlen_P(BAUD_PREFIX)) == 0) {
+    uint8_t code = linkBaudChoose((uint8_t)strtoul(message + strlen_P(BAUD_PREFIX), NULL, 16));
+    char reply[sizeof(BAUD_ACK_PREFIX) + 2];
+    snprintf_P(reply, sizeof(reply), PSTR(BAUD_ACK_PREFIX "%02x"), code);
+    sendReply(reply);
+    if (code != linkBaudCode) {
+      setLinkBaud(code);
+      linkSpeedPending = code != LINK_BAUD_DEFAULT_CODE;
+      linkSpeedStartMillis = millis();
+    }
+    TRACE_INFO(TRACE_EVENT_BAUD, code, linkSpeedPending);
+  }
 
-  const char* dataPrefix = "data:";
+  else if (strcmp_P(message, BAUD_CHECK) == 0) {
+    linkSpeedPending = false;
+    sendReply_P(BAUD_OK);
+  }
+
+  else if (strcmp_P(message, ANIM_INFO) == 0) {
+    char reply[sizeof(ANIM_INFO_PREFIX) + 4];
+    snprintf_P(reply, sizeof(reply), PSTR(ANIM_INFO_PREFIX "%04x"), ANIM_STORAGE_SIZE);
+    sendReply(reply);
+  }
+
+  else if (strcmp_P(message, ANIM_PLAY) == 0) {
+    sendReply_P(startAnimation() ? ANIM_ACK : ANIM_FAIL);
+  }
+
+  else if (strcmp_P(message, ANIM_STOP) == 0) {
+    stopAnimation();
+    sendReply_P(ANIM_ACK);
+  }
 
-  if (strcmp(message, SYN) == 0) {
-    bluetoothManager.write(SYN_ACK);  // Send SYN-ACK with newline for better recognition
+  else if (strncmp_P(message, FX_PREFIX, strlen_P(FX_PREFIX)) == 0) {
+    sendReply_P(startEffect(message + strlen_P(FX_PREFIX)) ? FX_ACK : FX_FAIL);
   }
 
-  else if (strcmp(message, SYN_ACK) == 0) {
-    bluetoothManager.write(ACK);  // Send ACK with newline for better recognition
+  else if (strcmp_P(message, FX_STOP) == 0) {
+    stopEffect();
+    sendReply_P(FX_ACK);
   }
 
-  else if (strncmp(message, dataPrefix, strlen(dataPrefix)) == 0) {
+  else if (strcmp_P(message, STREAM_STOP) == 0) {
+    if (stream.assembling) {
+      dropStreamFrame();
+    }
+    sendStreamReport();
+    resetStream(false);
+  }
 
-    char* dataPart = message + strlen(dataPrefix);
+#if FRAME_CACHE_SIZE > 0
+  else if (strncmp_P(message, CACHE_SHOW_PREFIX, strlen_P(CACHE_SHOW_PREFIX)) == 0) {
+    char* field;
+    uint16_t hash = (uint16_t)strtoul(message + strlen_P(CACHE_SHOW_PREFIX), &field, 16);
+    uint8_t generation = *field == ':' ? (uint8_t)strtoul(field + 1, NULL, 16) : GENERATION_UNKNOWN;
+    stopPlayback();
+    abandonPendingFrame();
+    int8_t slot = frameCacheFind(hash);
+    if (slot >= 0 && frameCacheLoad(slot, panelLeds)) {
+      showLeds();
+      sendReply_P(CACHE_HIT);
+      commitFrame(generation);
+      TRACE_INFO(TRACE_EVENT_CACHE, slot, 0);
+    } else {
+      sendReply_P(CACHE_MISS);
+      TRACE_INFO(TRACE_EVENT_CACHE, 0xFF, 0);
+    }
+  }
 
-    bool checksum_result = checkCheckSum(dataPart);
-    if (checksum_result) {
-      bluetoothManager.write(ROW_SUCCESS);
+  else if (strncmp_P(message, CACHE_PUT_PREFIX, strlen_P(CACHE_PUT_PREFIX)) == 0) {
+    int8_t slot = frameCacheStore((uint16_t)strtoul(message + strlen_P(CACHE_PUT_PREFIX), NULL, 16), panelLeds);
+    if (slot >= 0) {
+      frameCacheReport(sendReply);
     } else {
-      bluetoothManager.write(ROW_FAIL);
+      sendReply_P(CACHE_FAIL);
     }
+    TRACE_INFO(TRACE_EVENT_CACHE, slot < 0 ? 0xFF : slot, 1);
+  }
+
+  else if (strcmp_P(message, CACHE_LIST) == 0) {
+    frameCacheReport(sendReply);
+  }
+#endif
+
+  else if (strcmp_P(message, TRACE) == 0) {
+    traceDump(sendReply);
   }
 
-  else if (strcmp(message, FIN) == 0) {
-    bluetoothManager.write(FIN_ACK);
-    FastLED.show(50);
+  else if (strcmp_P(message, STATS) == 0) {
+    perfStatsReport(sendReply);
   }
 
-  else if (strcmp(message, LEDS_BLACK) == 0) {
+  else if (strcmp_P(message, STATS_RESET) == 0) {
+    perfStatsReport(sendReply);
+    perfStatsReset();
+  }
+
+  else if (strcmp_P(message, LEDS_BLACK) == 0) {
+    stopPlayback();
     setLedsColor(CRGB::Black);
   }
 
-  else if (strcmp(message, LEDS_WHITE) == 0) {
+  else if (strcmp_P(message, LEDS_WHITE) == 0) {
+    stopPlayback();
     setLedsColor(CRGB::White);
   }
 
-  else if (strcmp(message, LEDS_RED) == 0) {
+  else if (strcmp_P(message, LEDS_RED) == 0) {
+    stopPlayback();
     setLedsColor(CRGB::Red);
   }
 
-  else if (strcmp(message, LEDS_GREEN) == 0) {
+  else if (strcmp_P(message, LEDS_GREEN) == 0) {
+    stopPlayback();
     setLedsColor(CRGB::Green);
   }
 
-  else if (strcmp(message, LEDS_BLUE) == 0) {
+  else if (strcmp_P(message, LEDS_BLUE) == 0) {
+    stopPlayback();
     setLedsColor(CRGB::Blue);
   }
 
   else {
-    bluetoothManager.print("Unknown message: ");
-    bluetoothManager.println(message);
+    TRACE_ERROR(TRACE_EVENT_UNKNOWN_MESSAGE, message[0], strlen(message));
+    bluetoothManager.print(F("Unknown message: "));
+    sendReply(message);
   }
 }
 
 /**
- * processRow is a function that processes an entire row of pixel data by iterating through each pixel in the row and passing
- * the pixel data to the `processPixel` function.
+ * receiveFrameByte is a function that collects the bytes of a binary frame while the receiver is in binary mode.
  *
  * **Parameters:**
  *
- * - `rowData`: A `const char*` representing the binary data for a single row of pixels.
+ * - `c`: A `uint8_t` holding the byte read from the Bluetooth module.
  *
  * **Functionality:**
  *
- * - Iterates through each pixel in the row (assumed to be 16 pixels per row).
- * - For each pixel, the corresponding segment of the `rowData` is passed to the `processPixel` function for processing.
- * - This function is used to update the LED strip with the color data for a complete row.
+ * - A `FRAME_DELIMITER` right after the opening one is an idle sync byte and keeps the receiver waiting for the frame body.
+ * - Any other `FRAME_DELIMITER` closes the frame: the collected bytes are passed to `processFrame` and the receiver returns to text mode.
+ * - Bytes beyond `FRAME_MAX_ENCODED_SIZE` are dropped and the frame is answered with `ROW_FAIL` once it closes, so the app resends it
+ *   right away instead of waiting for a timeout.
  */
-void processRow(const char* rowData) {
-  for(uint8_t pixelIndex = 0; pixelIndex < 16; pixelIndex++) {
-    processPixel(rowData + pixelIndex * 16);
+void receiveFrameByte(uint8_t c) {
+  if (c == FRAME_DELIMITER) {
+    if (frameIndex == 0 && !frameOverflow) {
+      return;
+    }
+    if (frameOverflow) {
+      PERF_COUNT(frameOverflows);
+      TRACE_ERROR(TRACE_EVENT_FRAME_OVERFLOW, 0, 0);
+      if (windowActive) {
+        reportSeqGap();
+      } else if (!stream.active) {
+        sendReply_P(ROW_FAIL);
+      }
+    } else {
+      PERF_STAGE(PERF_STAGE_RECEIVE, perfMessageStartMicros);
+      processFrame(frameBuffer, frameIndex);
+    }
+    receivingFrame = false;
+    frameIndex = 0;
+    return;
+  }
+
+  if (frameIndex < sizeof(frameBuffer)) {
+    frameBuffer[frameIndex++] = c;
+  } else {
+    frameOverflow = true;
   }
 }
 
 /**
- * processQuarterRow is a function that processes a quarter of a row of pixel data by iterating through each pixel in the quarter
- * and passing the pixel data to the `processPixel` function.
+ * processFrame is a function that decodes and verifies a binary frame and performs the action requested by its type.
  *
  * **Parameters:**
  *
- * - `rowData`: A `const char*` representing the binary data for a quarter of a row of pixels.
+ * - `encoded`: A `uint8_t*` pointing to the COBS-encoded frame body. It is decoded in place.
+ * - `length`: A `uint8_t` specifying the number of encoded bytes.
  *
  * **Functionality:**
  *
- * - Iterates through each pixel in the quarter (assumed to be 4 pixels per quarter row).
- * - For each pixel, the corresponding segment of the `rowData` is passed to the `processPixel` function for processing.
- * - This function is used to update the LED strip with the color data for a partial row.
+ * - Decodes the body with `cobsDecode` and validates length and CRC with `frameIsValid`. With `PROTO_CAP_FEC` the check bytes after
+ *   the CRC are verified first and a single corrupted byte is repaired by `fecRepair`, so the frame is accepted without a resend;
+ *   only an uncorrectable frame is answered with `ROW_FAIL`. A frame too short for its check bytes is rejected the same way, before
+ *   its length is reduced by them.
+ * - For `FRAME_TYPE_PIXELS`, every 4 bytes of payload (position, R, G, B) are written to the LED strip with `processPixels`.
+ * - Replies with `ROW_SUCCESS` for an accepted frame and with `ROW_FAIL` for a corrupt or unknown one, like the text `data:` path.
+ *   The CRC-8 of a valid frame is kept in `replyTag`, which `sendRowSuccess` names with `PROTO_CAP_TAGGED_REPLIES`.
+ * - `FRAME_TYPE_PIXELS_DELTA` frames are handed to `processDeltaFrame`.
+ * - `FRAME_TYPE_PALETTE` and `FRAME_TYPE_PIXELS_INDEXED` frames are handed to `processPaletteFrame` and `processIndexedFrame`.
+ * - `FRAME_TYPE_PIXELS_COMPRESSED` frames are decoded by `processCompressedFrame`.
+ * - `FRAME_TYPE_PIXELS_PACKED` frames are expanded by `processPackedFrame`.
+ * - `FRAME_TYPE_ANIMATION_DATA` frames are written to the animation storage by `processAnimationDataFrame`.
+ * - `FRAME_TYPE_PIXELS_SEQ` frames are handed to `processSeqFrame`; in the sliding-window mode a corrupt frame is reported with
+ *   `reportSeqGap` instead of an immediate `ROW_FAIL`.
+ * - `FRAME_TYPE_STREAM` chunks are handed to `processStreamChunk`. While streaming, corrupt and rejected frames are not answered
+ *   at all; the frame they belong to is simply not shown.
+ * - Decoding, CRC check and pixel writes are timed for the `PERF_STAGE_*` statistics, the whole frame per frame type.
  */
-void processQuarterRow(const char* rowData) {
-  for(uint8_t pixelIndex = 0; pixelIndex < 4; pixelIndex++) {
-    processPixel(rowData + pixelIndex * 32); // 4 pixels, each with 4 bytes of information = 32 bits of binary storage
+void processFrame(uint8_t* encoded, uint8_t length) {
+  PERF_START(messageStart);
+  uint8_t decodedLength = cobsDecode(encoded, length, encoded);
+  PERF_STAGE(PERF_STAGE_DECODE, messageStart);
+
+  PERF_START(checksumStart);
+  uint8_t fecResult = FEC_CLEAN;
+  if (fecActive && decodedLength < FRAME_HEADER_SIZE + FRAME_CRC_SIZE + FRAME_FEC_SIZE) {
+    fecResult = FEC_UNCORRECTABLE;  // too short to carry a header, CRC and check bytes; rejected before any length arithmetic
+  } else if (fecActive) {
+    uint8_t repairedPosition = 0;
+    fecResult = fecRepair(encoded, decodedLength, repairedPosition);
+    if (fecResult == FEC_REPAIRED) {
+      PERF_COUNT(fecRepairs);
+      TRACE_INFO(TRACE_EVENT_FEC_REPAIR, repairedPosition, decodedLength);
+    }
+    decodedLength -= FRAME_FEC_SIZE;
+  }
+  bool valid = fecResult != FEC_UNCORRECTABLE && frameIsValid(encoded, decodedLength);
+  PERF_STAGE(PERF_STAGE_CHECKSUM, checksumStart);
+  if (!valid) {
+    PERF_COUNT(crcFailures);
+    TRACE_ERROR(TRACE_EVENT_FRAME_INVALID, length, decodedLength);
+    if (windowActive) {
+      reportSeqGap();
+    } else if (!stream.active) {
+      sendReply_P(ROW_FAIL);
+    }
+    return;
+  }
+
+  uint8_t type = encoded[0];
+  uint8_t payloadLength = encoded[1];
+  const uint8_t* payload = encoded + FRAME_HEADER_SIZE;
+  replyTag = encoded[decodedLength - FRAME_CRC_SIZE];
+  TRACE_DEBUG(TRACE_EVENT_FRAME, type, payloadLength);
+
+  if (type == FRAME_TYPE_PIXELS && payloadLength % PIXEL_BYTE_SIZE == 0) {
+    PERF_START(pixelsStart);
+    processPixels(payload, payloadLength / PIXEL_BYTE_SIZE);
+    PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+    sendRowSuccess();
+  } else if (type == FRAME_TYPE_PIXELS_SEQ && windowActive && payloadLength % PIXEL_BYTE_SIZE == 1) {
+    processSeqFrame(payload[0], payload + 1, payloadLength - 1);
+  } else if (type == FRAME_TYPE_PIXELS_DELTA && payloadLength >= 1) {
+    processDeltaFrame(payload[0], payload + 1, payloadLength - 1);
+  } else if (type == FRAME_TYPE_PALETTE && payloadLength >= 1 && (payloadLength - 1) % 3 == 0) {
+    processPaletteFrame(payload[0], payload + 1, (payloadLength - 1) / 3);
+  } else if (type == FRAME_TYPE_PIXELS_INDEXED && payloadLength >= INDEXED_HEADER_SIZE) {
+    processIndexedFrame(payload, payloadLength);
+  } else if (type == FRAME_TYPE_PIXELS_PACKED && payloadLength >= PACKED_HEADER_SIZE) {
+    processPackedFrame(payload, payloadLength);
+  } else if (type == FRAME_TYPE_ANIMATION_DATA && payloadLength >= ANIM_DATA_OFFSET_SIZE) {
+    processAnimationDataFrame(payload, payloadLength);
+  } else if (type == FRAME_TYPE_STREAM && stream.active && payloadLength == STREAM_HEADER_SIZE + STREAM_CHUNK_BYTES) {
+    PERF_START(pixelsStart);
+    processStreamChunk(payload[0], payload[1], payload + STREAM_HEADER_SIZE);
+    PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+  } else if (type == FRAME_TYPE_PIXELS_COMPRESSED && payloadLength >= COMPRESSED_HEADER_SIZE) {
+    PERF_START(pixelsStart);
+    bool decoded = processCompressedFrame(payload, payloadLength, true);
+    PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+    if (decoded) {
+      sendRowSuccess();
+    } else {
+      TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, type, payloadLength);
+      if (!stream.active) {
+        sendReply_P(ROW_FAIL);
+      }
+    }
+  } else {
+    TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, type, payloadLength);
+    if (!stream.active) {
+      sendReply_P(ROW_FAIL);
+    }
   }
+  PERF_MESSAGE(type, messageStart);
 }
 
 /**
- * processPixel is a function that processes individual pixel data, extracting the row, column, and RGB color information
- * from the binary data and setting the corresponding LED to the specified color.
+ * processDeltaFrame is a function that applies the changed pixels of a delta frame on top of the frame already held in `leds[]`.
  *
  * **Parameters:**
  *
- * - `pixelData`: A `const char*` representing the binary data for a single pixel, including its position and color information.
+ * - `baseGeneration`: A `uint8_t` holding the generation ID of the frame the app computed the delta against.
+ * - `spans`: A `const uint8_t*` pointing to the spans of changed pixels: position of the first pixel, pixel count, then R, G, B per pixel.
+ * - `length`: A `uint8_t` specifying the number of span bytes.
  *
  * **Functionality:**
  *
- * - Extracts the row and column numbers from the first 8 bits of `pixelData`.
- * - Extracts the red, green, and blue color components from the subsequent 24 bits of `pixelData`.
- * - Calculates the correct index for the LED strip based on the row and column numbers, accounting for the zigzag pattern.
- * - Sets the LED at the calculated index to the specified RGB color.
+ * - If `baseGeneration` is not the generation committed by the last `fin:<generation>`, the delta would be applied to the wrong picture;
+ *   the frame is dropped and answered with `DELTA_REJECT`, and the app sends a full frame instead.
+ * - The spans are checked against the payload length and the panel size before any pixel is written, so a malformed frame changes nothing.
+ * - Consecutive pixels of a span have consecutive positions, i.e. a span runs along a row of the matrix.
+ * - Replies with `ROW_SUCCESS` for an applied delta and with `ROW_FAIL` for a malformed one.
  */
-void processPixel(const char* pixelData) {
-  char rowByte[5];
-  char columnByte[5];
-
-  strncpy(rowByte, pixelData, 4);
-  strncpy(columnByte, pixelData + 4, 4);
+void processDeltaFrame(uint8_t baseGeneration, const uint8_t* spans, uint8_t length) {
+  if (baseGeneration == GENERATION_UNKNOWN || baseGeneration != committedGeneration) {
+    TRACE_INFO(TRACE_EVENT_DELTA_REJECT, baseGeneration, committedGeneration);
+    sendReply_P(DELTA_REJECT);
+    return;
+  }
 
-  rowByte[4] = '\0';     // Null-terminate the string
-  columnByte[4] = '\0';  // Null-terminate the string
+  uint8_t offset = 0;
+  while (offset < length) {
+    if (length - offset < DELTA_SPAN_HEADER_SIZE) {
+      TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_PIXELS_DELTA, length + 1);
+      sendReply_P(ROW_FAIL);
+      return;
+    }
+    uint8_t count = spans[offset + 1];
+    if ((uint16_t)spans[offset] + count > NUM_LEDS || length - offset - DELTA_SPAN_HEADER_SIZE < (uint16_t)count * 3) {
+      TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_PIXELS_DELTA, length + 1);
+      sendReply_P(ROW_FAIL);
+      return;
+    }
+    offset += DELTA_SPAN_HEADER_SIZE + count * 3;
+  }
 
-  uint8_t rowNumber = binaryToDecimal(rowByte, 4);
-  //receivedRow.rowNumber = rowNumber;
+  PERF_START(pixelsStart);
+  offset = 0;
+  while (offset < length) {
+    uint8_t position = spans[offset];
+    uint8_t count = spans[offset + 1];
+    const uint8_t* color = spans + offset + DELTA_SPAN_HEADER_SIZE;
+    for (uint8_t i = 0; i < count; i++, color += 3) {
+      stagePixelColor(position + i, color[0], color[1], color[2]);
+    }
+    offset += DELTA_SPAN_HEADER_SIZE + count * 3;
+  }
+  PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+  sendRowSuccess();
+}
 
-  char rByte[9];
-  char gByte[9];
-  char bByte[9];
+/**
+ * processPaletteFrame is a function that stores a block of palette entries uploaded by the app for the palette-indexed frame mode.
+ *
+ * **Parameters:**
+ *
+ * - `firstIndex`: A `uint8_t` holding the palette index of the first entry in the block.
+ * - `colors`: A `const uint8_t*` pointing to the R, G, B bytes of the entries.
+ * - `count`: A `uint8_t` specifying the number of entries in the block.
+ *
+ * **Functionality:**
+ *
+ * - The palette holds `PALETTE_MAX_SIZE` entries and stays valid until it is overwritten, so it is uploaded once per transfer and reused
+ *   by every `FRAME_TYPE_PIXELS_INDEXED` frame after it.
+ * - A block running past `PALETTE_MAX_SIZE` is answered with `ROW_FAIL` and not stored; an accepted block with `ROW_SUCCESS`.
+ */
+void processPaletteFrame(uint8_t firstIndex, const uint8_t* colors, uint8_t count) {
+  if ((uint16_t)firstIndex + count > PALETTE_MAX_SIZE) {
+    TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_PALETTE, 1 + count * 3);
+    sendReply_P(ROW_FAIL);
+    return;
+  }
+  for (uint8_t i = 0; i < count; i++, colors += 3) {
+    palette[firstIndex + i].setRGB(colors[0], colors[1], colors[2]);
+  }
+  sendRowSuccess();
+}
 
-  strncpy(rByte, pixelData + 8, 8);
-  rByte[8] = '\0';  // Null-terminate the string
+/**
+ * processIndexedFrame is a function that expands a run of palette indices into `leds[]` through the palette lookup.
+ *
+ * **Parameters:**
+ *
+ * - `payload`: A `const uint8_t*` pointing to the frame payload: position of the first pixel, bits per index (4 or 8), pixel count,
+ *   and the packed indices.
+ * - `length`: A `uint8_t` specifying the number of payload bytes.
+ *
+ * **Functionality:**
+ *
+ * - The pixels have consecutive positions starting at the first one, so a frame can cover several rows of the matrix.
+ * - With 4 bits per index two pixels share a byte, the first pixel in the upper nibble; an odd count leaves the last lower nibble unused.
+ * - The frame is answered with `ROW_FAIL` and nothing is written if the index width is not 4 or 8, the indices do not fill the
+ *   payload, the pixels run past the panel, or an index is outside the palette; otherwise with `ROW_SUCCESS`.
+ */
+void processIndexedFrame(const uint8_t* payload, uint8_t length) {
+  uint8_t position = payload[0];
+  uint8_t bits = payload[1];
+  uint8_t count = payload[2];
+  const uint8_t* indices = payload + INDEXED_HEADER_SIZE;
+  uint8_t indexBytes = length - INDEXED_HEADER_SIZE;
 
-  strncpy(gByte, pixelData + 16, 8);
-  gByte[8] = '\0';  // Null-terminate the string
+  if ((bits != 4 && bits != 8) || (uint16_t)position + count > NUM_LEDS ||
+      indexBytes != (bits == 8 ? count : (uint8_t)((count + 1) / 2))) {
+    TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_PIXELS_INDEXED, length);
+    sendReply_P(ROW_FAIL);
+    return;
+  }
+  for (uint8_t i = 0; i < count; i++) {
+    if (paletteIndexAt(indices, bits, i) >= PALETTE_MAX_SIZE) {
+      TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_PIXELS_INDEXED, length);
+      sendReply_P(ROW_FAIL);
+      return;
+    }
+  }
 
-  strncpy(bByte, pixelData + 24, 8);
-  bByte[8] = '\0';  // Null-terminate the string
+  PERF_START(pixelsStart);
+  for (uint8_t i = 0; i < count; i++) {
+    const CRGB& color = palette[paletteIndexAt(indices, bits, i)];
+    stagePixelColor(position + i, color.r, color.g, color.b);
+  }
+  PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+  sendRowSuccess();
+}
 
-  uint8_t r = binaryToDecimal(rByte, 8);
-  uint8_t g = binaryToDecimal(gByte, 8);
-  uint8_t b = binaryToDecimal(bByte, 8);
+/**
+ * paletteIndexAt is a function that reads the palette index of the `i`-th pixel from packed 4- or 8-bit indices.
+ *
+ * **Parameters:**
+ *
+ * - `indices`: A `const uint8_t*` pointing to the packed indices.
+ * - `bits`: A `uint8_t` holding the index width, 4 or 8.
+ * - `i`: A `uint8_t` holding the number of the pixel.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the palette index of the pixel.
+ */
+uint8_t paletteIndexAt(const uint8_t* indices, uint8_t bits, uint8_t i) {
+  if (bits == 8) {
+    return indices[i];
+  }
+  return (i & 1) ? (indices[i >> 1] & 0x0F) : (indices[i >> 1] >> 4);
+}
 
+/**
+ * processPackedFrame is a function that expands a run of pixels sent with a reduced color depth into `leds[]`.
+ *
+ * **Parameters:**
+ *
+ * - `payload`: A `const uint8_t*` pointing to the frame payload: position of the first pixel, color depth (`COLOR_DEPTH_*`), pixel count,
+ *   and the packed colors.
+ * - `length`: A `uint8_t` specifying the number of payload bytes.
+ *
+ * **Functionality:**
+ *
+ * - The pixels have consecutive positions starting at the first one; each color is expanded to 24 bits with `unpackColor`.
+ * - The frame is answered with `ROW_FAIL` and nothing is written if the depth is unknown, the colors do not fill the payload, or the
+ *   pixels run past the panel; otherwise with `ROW_SUCCESS`.
+ */
+void processPackedFrame(const uint8_t* payload, uint8_t length) {
+  uint8_t position = payload[0];
+  uint8_t depth = payload[1];
+  uint8_t count = payload[2];
+  const uint8_t* colors = payload + PACKED_HEADER_SIZE;
 
-  uint8_t index;  //= rowNumber*MATRIX_SIZE + binaryToDecimal(columnByte, 4);
-  if (rowNumber % 2 == 1) {
-    // Even rows (0, 2, 4, ...) - Left to Right
-    index = rowNumber * MATRIX_SIZE + binaryToDecimal(columnByte, 4);
-  } else {
-    // Odd rows (1, 3, 5, ...) - Right to Left
-    index = rowNumber * MATRIX_SIZE + (MATRIX_SIZE - 1 - binaryToDecimal(columnByte, 4));
+  if (packedColorBytes(depth, count) != length - PACKED_HEADER_SIZE || (uint16_t)position + count > NUM_LEDS) {
+    TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_PIXELS_PACKED, length);
+    sendReply_P(ROW_FAIL);
+    return;
+  }
+  PERF_START(pixelsStart);
+  for (uint8_t i = 0; i < count; i++) {
+    CRGB color = unpackColor(colors, depth, i);
+    stagePixelColor(position + i, color.r, color.g, color.b);
   }
+  PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+  sendRowSuccess();
+}
+
+/**
+ * processCompressedFrame is a function that decodes a compressed pixel frame.
+ *
+ * **Parameters:**
+ *
+ * - `payload`: A `const uint8_t*` pointing to the frame payload: position of the first pixel, codec (`CODEC_RLE` or `CODEC_LZ`), tokens.
+ * - `length`: A `uint8_t` specifying the number of payload bytes.
+ * - `staged`: A `bool`; `true` for a received frame, which goes to the back buffer (`stagePixelColor`) until `fin`, `false` for a
+ *   frame of the stored animation, which is decoded straight into `leds[]`.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if all tokens were decoded, `false` for an unknown codec or a token that is cut off, runs past the panel,
+ *   or refers to a pixel before position 0. Pixels decoded before the bad token stay written.
+ *
+ * **Functionality:**
+ *
+ * - Every frame holds whole tokens, so the decoder only needs the frame it is working on; the compressed image is never buffered.
+ * - `CODEC_RLE` repeats one color for a run of pixels.
+ * - `CODEC_LZ` mixes literal pixels with matches that copy pixels decoded earlier. The match source is read back with
+ *   `getStagedPixelColor` or `getPixelColor`, so the LZ window (up to 255 pixels) costs no extra SRAM. Earlier frames of the same transfer are part of the window,
+ *   and a match may overlap the pixels it writes, which repeats a pattern.
+ */
+bool processCompressedFrame(const uint8_t* payload, uint8_t length, bool staged) {
+  uint16_t position = payload[0];
+  uint8_t codec = payload[1];
+  uint8_t offset = COMPRESSED_HEADER_SIZE;
+
+  while (offset < length) {
+    uint8_t control = payload[offset++];
+
+    if (codec == CODEC_RLE) {
+      if (control == 0 || length - offset < 3 || position + control > NUM_LEDS) {
+        return false;
+      }
+      for (uint8_t i = 0; i < control; i++) {
+        writePixelColor(position++, payload[offset], payload[offset + 1], payload[offset + 2], staged);
+      }
+      offset += 3;
+    }
+
+    else if (codec == CODEC_LZ && control < LZ_LITERAL_FLAG) {
+      uint8_t count = control + 1;
+      if (length - offset < (uint16_t)count * 3 || position + count > NUM_LEDS) {
+        return false;
+      }
+      for (uint8_t i = 0; i < count; i++, offset += 3) {
+        writePixelColor(position++, payload[offset], payload[offset + 1], payload[offset + 2], staged);
+      }
+    }
 
-  // Set the LED color
-  leds[index].setRGB(r, g, b);
+    else if (codec == CODEC_LZ) {
+      uint8_t count = control - (LZ_LITERAL_FLAG - 1);
+      if (offset >= length) {
+        return false;
+      }
+      uint8_t distance = payload[offset++];
+      if (distance == 0 || distance > position || position + count > NUM_LEDS) {
+        return false;
+      }
+      for (uint8_t i = 0; i < count; i++, position++) {
+        CRGB color = staged ? getStagedPixelColor(position - distance) : getPixelColor(position - distance);
+        writePixelColor(position, color.r, color.g, color.b, staged);
+      }
+    }
+
+    else {
+      return false;
+    }
+  }
+  return true;
 }
 
 /**
- * binaryToDecimal is a function that converts a binary string to its decimal equivalent. The conversion is limited to the size specified by the length parameter.
+ * processAnimationDataFrame is a function that writes a block of an uploaded animation into the animation storage.
  *
  * **Parameters:**
  *
- * - `binaryString`: A `const char*` representing the binary string to be converted to a decimal value.
- * - `length`: A `size_t` specifying the length of the binary string to consider for the conversion.
+ * - `payload`: A `const uint8_t*` pointing to the frame payload: 2 bytes storage offset (big-endian), then the bytes to store.
+ * - `length`: A `uint8_t` specifying the number of payload bytes.
+ *
+ * **Functionality:**
+ *
+ * - A running animation is stopped first, since its data is being replaced.
+ * - A block running past `ANIM_STORAGE_SIZE` is answered with `ROW_FAIL` and not stored; a stored block with `ROW_SUCCESS`.
+ * - The app writes the header at offset 0 last, so an interrupted upload fails the CRC check of `animReadHeader` and is never played.
+ * - An EEPROM byte takes 3.3 ms to write; bytes that did not change are skipped.
+ */
+void processAnimationDataFrame(const uint8_t* payload, uint8_t length) {
+  uint16_t offset = ((uint16_t)payload[0] << 8) | payload[1];
+  uint8_t count = length - ANIM_DATA_OFFSET_SIZE;
+  if ((uint32_t)offset + count > ANIM_STORAGE_SIZE) {
+    TRACE_ERROR(TRACE_EVENT_FRAME_REJECTED, FRAME_TYPE_ANIMATION_DATA, length);
+    sendReply_P(ROW_FAIL);
+    return;
+  }
+  stopAnimation();
+  for (uint8_t i = 0; i < count; i++) {
+    animStorageWrite(offset + i, payload[ANIM_DATA_OFFSET_SIZE + i]);
+  }
+  sendRowSuccess();
+}
+
+/**
+ * startAnimation is a function that starts playing the animation in the animation storage from its first frame.
  *
  * **Returns:**
  *
- * - `uint8_t`: Returns the decimal equivalent of the input binary string.
+ * - `bool`: Returns `true` if the storage holds a valid animation, see `animReadHeader`.
  *
  * **Functionality:**
  *
- * - Iterates over the binary string from left to right, shifting the result left and adding the corresponding bit value.
- * - The function processes only the specified number of bits (`length`) and converts them to a decimal integer.
+ * - A running effect is stopped. The first frame is shown on the next `loop` pass. `leds[]` no longer holds a frame the app knows,
+ *   so the committed generation is dropped and the next transfer cannot be sent as a delta.
  */
-uint8_t binaryToDecimal(const char* binaryString, size_t length) {
-  uint8_t result = 0;
-  for (size_t i = 0; i < length; i++) {
-    if (binaryString[i] == '1') {
-      result = (result << 1) | 1;
+bool startAnimation() {
+  if (!animReadHeader(animation)) {
+    animationPlaying = false;
+    return false;
+  }
+  stopEffect();
+  commitFrame(GENERATION_UNKNOWN);
+  animationOffset = ANIM_HEADER_SIZE;
+  animationFrame = 0;
+  animationFrameMillis = millis() - 1000 / animation.fps;
+  animationPlaying = true;
+  return true;
+}
+
+/**
+ * stopAnimation is a function that stops a running animation; the frame it showed last stays on the panel.
+ */
+void stopAnimation() {
+  if (animationPlaying) {
+    animationPlaying = false;
+    commitFrame(GENERATION_UNKNOWN);
+  }
+}
+
+/**
+ * playAnimationFrame is a function that decodes the next frame of the stored animation into `leds[]` and shows it.
+ *
+ * **Functionality:**
+ *
+ * - Every chunk of the frame is copied from the storage into `frameBuffer`, which is free between messages, and decoded by
+ *   `processCompressedFrame` like a `FRAME_TYPE_PIXELS_COMPRESSED` frame received over the link.
+ * - After the last frame the animation starts over with `ANIM_FLAG_LOOP` and stops on the last frame otherwise.
+ * - Storage contents that do not decode (a chunk that is too long, runs past the data or fails to decode) stop the animation.
+ */
+void playAnimationFrame() {
+  uint16_t end = ANIM_HEADER_SIZE + animation.dataLength;
+  for (;;) {
+    if (animationOffset >= end) {
+      stopAnimation();
+      return;
+    }
+    uint8_t length = animStorageRead(animationOffset++);
+    if (length == 0) {
+      break;
+    }
+    if (length > FRAME_MAX_PAYLOAD || length < COMPRESSED_HEADER_SIZE || animationOffset + length > end) {
+      stopAnimation();
+      return;
+    }
+    for (uint8_t i = 0; i < length; i++) {
+      frameBuffer[i] = animStorageRead(animationOffset++);
+    }
+    if (!processCompressedFrame(frameBuffer, length, false)) {
+      stopAnimation();
+      return;
+    }
+  }
+  showPlaybackFrame();
+
+  if (++animationFrame >= animation.frameCount) {
+    if (animation.flags & ANIM_FLAG_LOOP) {
+      animationOffset = ANIM_HEADER_SIZE;
+      animationFrame = 0;
     } else {
-      result = (result << 1) | 0;
+      animationPlaying = false;
     }
   }
-  return result;
 }
 
 /**
- * checkCheckSum is a function that verifies the integrity of a message by converting it to binary, calculating its checksum,
- * and comparing the result to determine if the message is valid.
+ * startEffect is a function that starts a procedural effect, or tunes the running one, from the parameters of an `fx:` command.
  *
  * **Parameters:**
  *
- * - `message`: A `char*` representing the hexadecimal string message to be checked.
+ * - `parameters`: A `char*` holding up to four hex fields separated by ':': `EFFECT_*`, speed, `EFFECT_PALETTE_*` and seed.
  *
  * **Returns:**
  *
- * - `bool`: Returns `true` if the checksum is valid and the message is correctly formed; otherwise, returns `false`.
+ * - `bool`: Returns `true` if the fields parse and name a known effect and palette; otherwise nothing changes.
  *
  * **Functionality:**
  *
- * - Converts the hexadecimal `message` to a binary string.
- * - Calculates the checksum of the binary data using the `checkSum` function.
- * - Compares the checksum result against the expected value using `result_checker`.
- * - If the checksum is valid, processes the quarter row of data and returns `true`; otherwise, returns `false`.
+ * - Missing trailing fields keep their previous values, so `fx:04` restarts fire with the last speed, palette and seed.
+ * - Naming the running effect again only changes its parameters and keeps its time, so the app can tune it without a jump.
+ * - A running animation is stopped. `leds[]` no longer holds a frame the app knows, so the committed generation is dropped.
  */
-bool checkCheckSum(char* message) {
-  char binaryData[QUARTER_ROW_BINARY_CHAR_SIZE + 1];
+bool startEffect(char* parameters) {
+  uint8_t values[4] = {effect.effect, effect.speed, effect.palette, effect.seed};
+  char* field = parameters;
+  for (uint8_t i = 0; i < 4 && *field != '\0'; i++) {
+    char* end;
+    values[i] = (uint8_t)strtoul(field, &end, 16);
+    if (end == field || (*end != ':' && *end != '\0')) {
+      return false;
+    }
+    field = *end == ':' ? end + 1 : end;
+  }
+  if (values[0] == EFFECT_NONE || values[0] >= EFFECT_COUNT || values[2] >= EFFECT_PALETTE_COUNT) {
+    return false;
+  }
+
+  stopAnimation();
+  if (!effectRunning || values[0] != effect.effect) {
+    effect.time = 0;
+    effectFrameMillis = millis() - 1000 / EFFECT_FPS;
+    commitFrame(GENERATION_UNKNOWN);
+  }
+  effect.effect = values[0];
+  effect.speed = values[1];
+  effect.palette = values[2];
+  effect.seed = values[3];
+  effectRunning = true;
+  return true;
+}
 
-  hexData_to_binaryData(message, binaryData);
+/**
+ * stopEffect is a function that stops a running effect; the frame it rendered last stays on the panel.
+ */
+void stopEffect() {
+  effectRunning = false;
+}
 
-  char result[9];
-  checkSum(binaryData, BLOCK_SIZE, result);
+/**
+ * stopPlayback is a function that stops whatever the device plays on its own, a stored animation or an effect, before the app takes
+ * over the panel.
+ */
+void stopPlayback() {
+  stopAnimation();
+  stopEffect();
+}
 
-  if (result_checker(result, BLOCK_SIZE)) {
-    processQuarterRow(binaryData);
-    return true;
+/**
+ * playbackDue is a function that paces animation and effect frames and keeps them away from incoming messages.
+ *
+ * **Parameters:**
+ *
+ * - `frameMillis`: An `unsigned long&` holding the time the current frame was due; advanced by `interval` when a frame is due.
+ * - `interval`: A `uint16_t` holding the frame interval in ms.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if the next frame should be shown now.
+ *
+ * **Functionality:**
+ *
+ * - No frame is shown while a message is being received or until the line has been idle for `PLAYBACK_IDLE_MILLIS`: `FastLED.show`
+ *   would drop the bytes that arrive meanwhile. The app wakes the device with a burst of empty lines before a command, see
+ *   `wakePlayback` in the app.
+ * - A frame that falls behind by a whole interval, e.g. during a long message, is skipped instead of caught up.
+ */
+bool playbackDue(unsigned long& frameMillis, uint16_t interval) {
+  if (receivingFrame || messageIndex != 0 || millis() - lastByteMillis < PLAYBACK_IDLE_MILLIS ||
+      millis() - frameMillis < interval) {
+    return false;
+  }
+  frameMillis += interval;
+  if (millis() - frameMillis >= interval) {
+    frameMillis = millis();
   }
-  return false;
+  return true;
+}
+
+/**
+ * renderEffectFrame is a function that renders the next frame of the running effect into `leds[]` and shows it.
+ *
+ * **Functionality:**
+ *
+ * - Every pixel is computed with `effectColor`, then the effect time advances by its speed.
+ * - `EFFECT_SCROLL` instead rotates the picture on the panel one column to the left whenever the time passes a multiple of 256, and
+ *   skips the refresh in between.
+ */
+void renderEffectFrame() {
+  if (effect.effect == EFFECT_SCROLL) {
+    uint8_t before = effect.time >> 8;
+    effect.time += effect.speed;
+    if ((uint8_t)(effect.time >> 8) == before) {
+      return;
+    }
+    uint8_t position = 0;
+    for (uint8_t row = 0; row < Panel::height; row++, position += Panel::width) {
+      CRGB first = getPixelColor(position);
+      for (uint8_t column = 0; column < Panel::width - 1; column++) {
+        CRGB next = getPixelColor(position + column + 1);
+        setPixelColor(position + column, next.r, next.g, next.b);
+      }
+      setPixelColor(position + Panel::width - 1, first.r, first.g, first.b);
+    }
+  } else {
+    uint8_t position = 0;
+    for (uint8_t row = 0; row < Panel::height; row++) {
+      for (uint8_t column = 0; column < Panel::width; column++, position++) {
+        CRGB color = effectColor(effect, row, column, Panel::width, Panel::height);
+        setPixelColor(position, color.r, color.g, color.b);
+      }
+    }
+    effect.time += effect.speed;
+  }
+  showPlaybackFrame();
+}
+
+/**
+ * commitFrame is a function that records which frame `leds[]` holds after it has been shown.
+ *
+ * **Parameters:**
+ *
+ * - `generation`: A `uint8_t` holding the generation ID sent with `fin:<generation>`, or `GENERATION_UNKNOWN`.
+ */
+void commitFrame(uint8_t generation) {
+  committedGeneration = generation;
+  framePending = false;
+}
+
+/**
+ * abandonPendingFrame is a function that discards a transfer that ended without `fin`.
+ *
+ * **Functionality:**
+ *
+ * - The back buffer is emptied; `leds[]` still holds the committed frame, which keeps its generation, so the next transfer can
+ *   still be sent as a delta.
+ * - Only if the transfer spilled into `leds[]` (`stagePixelColor`) or wrote it directly, the committed generation is forgotten.
+ */
+void abandonPendingFrame() {
+  stagedFrame.clear();
+  stagingSpilled = false;
+  if (framePending) {
+    commitFrame(GENERATION_UNKNOWN);
+  }
+}
+
+/**
+ * processSeqFrame is a function that applies a sequenced pixel frame of the sliding-window mode (`PROTO_CAP_WINDOW`).
+ *
+ * **Parameters:**
+ *
+ * - `seq`: A `uint8_t` holding the sequence number of the frame.
+ * - `pixels`: A `const uint8_t*` pointing to the pixel records (position, R, G, B) that follow the sequence number.
+ * - `length`: A `uint8_t` specifying the number of pixel bytes.
+ *
+ * **Functionality:**
+ *
+ * - Frames are accepted strictly in order (go-back-N): only `expectedSeq` is applied, after which `expectedSeq` advances and a cumulative
+ *   `ROW-ACK:<expectedSeq>` is scheduled.
+ * - A frame from the future means an earlier one was lost; it is dropped and reported once with `reportSeqGap`, and the app resends
+ *   everything from `expectedSeq`.
+ * - A frame from the past is a retransmit of something already applied; it only refreshes the acknowledgment.
+ */
+void processSeqFrame(uint8_t seq, const uint8_t* pixels, uint8_t length) {
+  if (seq == expectedSeq) {
+    PERF_START(pixelsStart);
+    processPixels(pixels, length / PIXEL_BYTE_SIZE);
+    PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+    expectedSeq++;
+    seqGapReported = false;
+    seqReplyFail = false;
+    seqReplyPending = true;
+  } else if ((uint8_t)(seq - expectedSeq) < SEQ_WINDOW_SIZE) {
+    if (!seqGapReported) {
+      TRACE_INFO(TRACE_EVENT_SEQ_GAP, expectedSeq, seq);  // only the first frame of a gap, like the reply
+    }
+    reportSeqGap();
+  } else if (!seqGapReported) {
+    seqReplyPending = true;
+  }
+}
+
+/**
+ * reportSeqGap is a function that schedules a `ROW-FAIL:<expectedSeq>` reply for a lost or corrupt frame in the sliding-window mode.
+ * Only the first gap is reported until the expected frame arrives, so a whole window of discarded frames costs a single reply.
+ */
+void reportSeqGap() {
+  if (!seqGapReported) {
+    seqGapReported = true;
+    seqReplyFail = true;
+    seqReplyPending = true;
+  }
+}
+
+/**
+ * sendSeqReply is a function that sends the pending sliding-window reply, `ROW-ACK:<expectedSeq>` or `ROW-FAIL:<expectedSeq>`.
+ *
+ * **Functionality:**
+ *
+ * - `SoftwareSerial` cannot receive while it transmits, so replies are deferred by `loop` until the app has stopped sending; with a full
+ *   window in flight that means one reply per window instead of one per frame.
+ * - The reply is sent with `sendReply`, framed like every other reply.
+ */
+void sendSeqReply() {
+  char reply[sizeof(ROW_FAIL_SEQ) + 2];
+  snprintf_P(reply, sizeof(reply), seqReplyFail ? PSTR(ROW_FAIL_SEQ "%02x") : PSTR(ROW_ACK_SEQ "%02x"), expectedSeq);
+  sendReply(reply);
+  seqReplyPending = false;
+}
+
+/**
+ * resetWindow is a function that restarts the sliding-window state at the beginning of a handshake.
+ *
+ * **Parameters:**
+ *
+ * - `active`: A `bool` telling whether the app negotiated `PROTO_CAP_WINDOW` for this session.
+ */
+void resetWindow(bool active) {
+  windowActive = active;
+  expectedSeq = 0;
+  seqReplyPending = false;
+  seqReplyFail = false;
+  seqGapReported = false;
+}
+
+/**
+ * processStreamChunk is a function that writes one chunk of a streamed frame (`PROTO_CAP_STREAM`) and shows the frame once it is
+ * complete.
+ *
+ * **Parameters:**
+ *
+ * - `sequence`: A `uint8_t` holding the frame sequence number; the app counts frames, not chunks.
+ * - `chunk`: A `uint8_t` holding the chunk index; the chunk covers `STREAM_CHUNK_PIXELS` positions from `chunk * STREAM_CHUNK_PIXELS`.
+ * - `colors`: A `const uint8_t*` pointing to `STREAM_CHUNK_PIXELS` colors, 3 bytes (R, G, B) each.
+ *
+ * **Functionality:**
+ *
+ * - No reply: freshness matters more than any single frame, so nothing is resent and the app never waits per chunk.
+ * - Chunks are written straight to `leds[]`, which keeps showing the previous frame until `FastLED.show`; the Uno has no SRAM for a
+ *   second frame buffer. Tearing is confined to `leds[]`: only a frame whose `STREAM_CHUNK_COUNT` chunks all arrived is shown, and
+ *   since every streamed frame covers the whole panel, none of its pixels is left from an earlier frame.
+ * - A chunk of a newer frame gives up the frame being assembled (`dropStreamFrame`). Chunks of older frames arrive too late and are
+ *   ignored, so frames are never shown out of order.
+ * - Once all `STREAM_CHUNK_COUNT` chunks of a frame arrived, it is shown. After the last frame of every group of
+ *   `STREAM_REPORT_INTERVAL` frames a report is scheduled; the app pauses for it there.
+ */
+void processStreamChunk(uint8_t sequence, uint8_t chunk, const uint8_t* colors) {
+  if (chunk >= STREAM_CHUNK_COUNT) {
+    return;
+  }
+  if (stream.assembling && sequence != stream.sequence) {
+    if (!streamIsNewer(sequence, stream.sequence)) {
+      return;
+    }
+    dropStreamFrame();
+  }
+  if (!stream.assembling) {
+    if (stream.started && !streamIsNewer(sequence, stream.sequence)) {
+      return;
+    }
+    stream.started = true;
+    stream.assembling = true;
+    stream.sequence = sequence;
+    stream.chunks = 0;
+  }
+
+  uint8_t first = chunk * STREAM_CHUNK_PIXELS;
+  for (uint8_t i = 0; i < STREAM_CHUNK_PIXELS; i++) {
+    panelLeds[first + i].setRGB(colors[i * 3], colors[i * 3 + 1], colors[i * 3 + 2]);
+  }
+  stream.chunks |= 1U << chunk;
+  framePending = true;
+
+  if (stream.chunks == STREAM_ALL_CHUNKS) {
+    showLeds();
+    commitFrame(GENERATION_UNKNOWN);
+    stream.assembling = false;
+    stream.shownSequence = sequence;
+    stream.shown++;
+    if (sequence % STREAM_REPORT_INTERVAL == STREAM_REPORT_INTERVAL - 1) {
+      stream.reportPending = true;
+    }
+  }
+}
+
+/**
+ * dropStreamFrame is a function that gives up the streamed frame being assembled, because a newer frame started or its missing chunks
+ * did not arrive within `STREAM_STALE_MILLIS`.
+ *
+ * **Functionality:**
+ *
+ * - The chunks that arrived stay in `leds[]` unshown, mixed with the previous frame, and are overwritten by the next complete frame.
+ * - `framePending` stays set, so if the stream ends here the committed generation is forgotten (`abandonPendingFrame`) and the app
+ *   sends a whole frame rather than a delta on top of the mixed pixels.
+ */
+void dropStreamFrame() {
+  stream.assembling = false;
+  stream.dropped++;
+  TRACE_INFO(TRACE_EVENT_STREAM_DROP, stream.sequence, (uint8_t)stream.chunks);
+  if (stream.sequence % STREAM_REPORT_INTERVAL == STREAM_REPORT_INTERVAL - 1) {
+    stream.reportPending = true;
+  }
+}
+
+/**
+ * sendStreamReport is a function that sends the aggregate feedback of a stream, `stream:<last shown>:<shown>:<dropped>` in hex, and
+ * starts counting again.
+ *
+ * **Functionality:**
+ *
+ * - `shown` and `dropped` count frames since the previous report; frames lost completely, without any chunk arriving, are in neither.
+ * - Like `sendSeqReply` it is only called while the line is idle, since `SoftwareSerial` cannot receive while it transmits, and it
+ *   is sent with `sendReply` like every other reply.
+ */
+void sendStreamReport() {
+  char reply[sizeof(STREAM_REPORT_PREFIX) + 8];
+  snprintf_P(reply, sizeof(reply), PSTR(STREAM_REPORT_PREFIX "%02x:%02x:%02x"), stream.shownSequence, stream.shown, stream.dropped);
+  sendReply(reply);
+  stream.shown = 0;
+  stream.dropped = 0;
+  stream.reportPending = false;
+}
+
+/**
+ * resetStream is a function that restarts the stream state at the beginning of a handshake or after `STREAM_STOP`.
+ *
+ * **Parameters:**
+ *
+ * - `active`: A `bool` telling whether the app negotiated `PROTO_CAP_STREAM` for this session.
+ */
+void resetStream(bool active) {
+  StreamState fresh = {active, false, false, false, 0, 0, 0, 0, 0};
+  stream = fresh;
+}
+
+/**
+ * processPixels is a function that writes a run of pixel records to the LED strip by passing each of them to `processPixel`.
+ *
+ * **Parameters:**
+ *
+ * - `pixels`: A `const uint8_t*` pointing to the records, 4 bytes each (position, R, G, B).
+ * - `count`: A `uint8_t` holding the number of records, e.g. 4 for a quarter row or `Panel::width` for a whole row.
+ */
+void processPixels(const uint8_t* pixels, uint8_t count) {
+  for (uint8_t pixelIndex = 0; pixelIndex < count; pixelIndex++) {
+    processPixel(pixels + pixelIndex * PIXEL_BYTE_SIZE);
+  }
+}
+
+/**
+ * processPixel is a function that processes individual pixel data, extracting the position and RGB color information
+ * and setting the corresponding LED to the specified color.
+ *
+ * **Parameters:**
+ *
+ * - `pixelData`: A `const uint8_t*` pointing to the 4 bytes of a single pixel: position (`row * MATRIX_WIDTH + column`), R, G, B.
+ *
+ * **Functionality:**
+ *
+ * - Passes the position and color bytes to `stagePixelColor`; the LED changes with the next `fin`.
+ */
+void processPixel(const uint8_t* pixelData) {
+  stagePixelColor(pixelData[0], pixelData[1], pixelData[2], pixelData[3]);
+}
+
+/**
+ * stagePixelColor is a function that writes a received pixel to the back buffer, `stagedFrame`, instead of `leds[]`.
+ *
+ * **Parameters:**
+ *
+ * - `position`: A `uint8_t` holding the pixel position `row * MATRIX_WIDTH + column`.
+ * - `r`, `g`, `b`: `uint8_t` values of the red, green, and blue color components.
+ *
+ * **Functionality:**
+ *
+ * - `leds[]` keeps the shown frame while the next one is received, and `flipStagedFrame` copies the new frame over on `fin` or
+ *   `show`. A transfer that breaks off leaves the panel and `leds[]` untouched, see `abandonPendingFrame`.
+ * - The back buffer holds `STAGED_FRAME_COLORS` colors per frame, which covers drawings made with the app's color buttons. With one
+ *   more color the frame spills: what is staged is applied to `leds[]`, and the rest of the frame is written there directly as
+ *   before, so it still shows correctly on `fin` but is not protected against a broken-off transfer.
+ */
+void stagePixelColor(uint8_t position, uint8_t r, uint8_t g, uint8_t b) {
+  if (!stagingSpilled) {
+    if (stagedFrame.stage(position, CRGB(r, g, b))) {
+      return;
+    }
+    PERF_COUNT(stagingSpills);
+    TRACE_INFO(TRACE_EVENT_STAGING_SPILL, position, 0);
+    stagedFrame.applyTo(panelLeds);
+    stagingSpilled = true;
+  }
+  setPixelColor(position, r, g, b);
+}
+
+/**
+ * getStagedPixelColor is a function that reads a pixel of the frame being received: from the back buffer if it was staged there,
+ * otherwise from `leds[]`.
+ *
+ * **Parameters:**
+ *
+ * - `position`: A `uint8_t` holding the pixel position `row * MATRIX_WIDTH + column`.
+ *
+ * **Returns:**
+ *
+ * - `CRGB`: Returns the color last written with `stagePixelColor` or `setPixelColor`.
+ */
+CRGB getStagedPixelColor(uint8_t position) {
+  CRGB color;
+  if (stagedFrame.get(position, color)) {
+    return color;
+  }
+  return getPixelColor(position);
+}
+
+/**
+ * flipStagedFrame is a function that makes the received frame the shown one: it copies the back buffer into `leds[]` right before
+ * `showLeds`.
+ */
+void flipStagedFrame() {
+  stagedFrame.applyTo(panelLeds);
+  stagingSpilled = false;
+}
+
+/**
+ * writePixelColor is a function that writes a pixel either to the back buffer (`stagePixelColor`) or straight to `leds[]`
+ * (`setPixelColor`).
+ */
+void writePixelColor(uint8_t position, uint8_t r, uint8_t g, uint8_t b, bool staged) {
+  if (staged) {
+    stagePixelColor(position, r, g, b);
+  } else {
+    setPixelColor(position, r, g, b);
+  }
+}
+
+/**
+ * setPixelColor is a function that sets the LED addressed by a packed position byte to the given RGB color.
+ *
+ * **Parameters:**
+ *
+ * - `position`: A `uint8_t` holding the pixel position `row * MATRIX_WIDTH + column`, see `ledIndex`.
+ * - `r`, `g`, `b`: `uint8_t` values of the red, green, and blue color components.
+ *
+ * **Functionality:**
+ *
+ * - Writes the LED through `panelLeds`, which looks up its index on the strip like `ledIndex` and so accounts for the wiring of the panel.
+ * - Sets the LED at the calculated index to the specified RGB color.
+ * - Marks the frame as pending until `fin` commits it, see `abandonPendingFrame`.
+ * - Effects, animations and frames that spilled out of the back buffer write here; received pixels go through `stagePixelColor`.
+ */
+void setPixelColor(uint8_t position, uint8_t r, uint8_t g, uint8_t b) {
+  panelLeds[position].setRGB(r, g, b);
+  framePending = true;
+}
+
+/**
+ * getPixelColor is a function that reads back the color of the LED addressed by a packed position byte.
+ *
+ * **Parameters:**
+ *
+ * - `position`: A `uint8_t` holding the pixel position `row * MATRIX_WIDTH + column`, see `ledIndex`.
+ *
+ * **Returns:**
+ *
+ * - `CRGB`: Returns the color last written with `setPixelColor`.
+ */
+CRGB getPixelColor(uint8_t position) {
+  return panelLeds[position];
+}
+
+/**
+ * ledIndex is a function that maps a position byte to the index of the LED on the strip.
+ *
+ * **Parameters:**
+ *
+ * - `position`: A `uint8_t` holding `row * MATRIX_WIDTH + column`; with the 16 columns of the default panel the row number is in the
+ *   upper 4 bits and the column number in the lower 4 bits.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the index into `leds[]`, read from the `LayoutTable` of the panel, which accounts for wiring, rotation and
+ *   origin corner.
+ */
+uint8_t ledIndex(uint8_t position) {
+  return pgm_read_byte(&LayoutTable<Panel>::leds[position]);
+}
+
+/**
+ * beginDataLine is a function that prepares the streaming decoder once a text line has started with `DATA_PREFIX`.
+ */
+void beginDataLine() {
+  receivingData = true;
+  dataLength = 0;
+  dataSum = 0x00;
+  dataHighNibble = -1;
+  dataInvalid = false;
+}
+
+/**
+ * receiveDataChar is a function that decodes one character of a "data:" line as it arrives.
+ *
+ * **Parameters:**
+ *
+ * - `c`: A `char` holding the character read from the Bluetooth module.
+ *
+ * **Functionality:**
+ *
+ * - Every second hex digit completes a byte, which is appended to `dataStaging` and added to the running one's complement sum with
+ *   `onesComplementSumUpdate`; no text copy of the line is kept and nothing is converted twice.
+ * - A character that is not a hex digit, or a byte beyond `DATA_MAX_BYTES`, marks the line invalid; the rest of it is ignored and
+ *   `processDataLine` rejects it.
+ */
+void receiveDataChar(char c) {
+  int8_t nibble = hexNibble(c);
+  if (dataInvalid || nibble < 0) {
+    dataInvalid = true;
+    return;
+  }
+  if (dataHighNibble < 0) {
+    dataHighNibble = nibble;
+    return;
+  }
+  if (dataLength == DATA_MAX_BYTES) {
+    dataInvalid = true;
+    return;
+  }
+  uint8_t value = (uint8_t)((dataHighNibble << 4) | nibble);
+  dataHighNibble = -1;
+  dataStaging[dataLength++] = value;
+  dataSum = onesComplementSumUpdate(dataSum, &value, 1);
+}
+
+/**
+ * processDataLine is a function that finishes a "data:" line: it verifies the staged bytes and applies their pixels.
+ *
+ * **Functionality:**
+ *
+ * - The line must hold whole pixel records (position, R, G, B) followed by the one's complement checksum byte, and the sum over all
+ *   of them must be `ONES_COMPLEMENT_VALID`. A quarter row (`QUARTER_ROW_BYTE_SIZE`), half row (`HALF_ROW_BYTE_SIZE`) or whole row
+ *   (`ROW_BYTE_SIZE`) are all accepted, so larger lines need fewer `ROW_SUCCESS` round trips.
+ * - Only a valid line is written to `leds[]` with `processPixels` and answered with `ROW_SUCCESS`; otherwise nothing is written and the
+ *   reply is `ROW_FAIL`, so a corrupt line never leaves half its pixels on the panel.
+ * - Decoding and summing happen while the line arrives and are part of `PERF_STAGE_RECEIVE`; the pixel writes are timed as
+ *   `PERF_STAGE_PIXELS`. A rejected line counts as a checksum failure.
+ */
+void processDataLine() {
+  TRACE_DEBUG(TRACE_EVENT_MESSAGE, DATA_PREFIX[0], dataLength);
+  bool valid = !dataInvalid && dataHighNibble < 0 && dataLength > PIXEL_BYTE_SIZE &&
+               (dataLength - 1) % PIXEL_BYTE_SIZE == 0 && dataSum == ONES_COMPLEMENT_VALID;
+  if (!valid) {
+    PERF_COUNT(checksumFailures);
+    TRACE_ERROR(TRACE_EVENT_CHECKSUM_FAIL, dataLength, 0);
+    sendReply_P(ROW_FAIL);
+    return;
+  }
+
+  PERF_START(pixelsStart);
+  processPixels(dataStaging, (dataLength - 1) / PIXEL_BYTE_SIZE);
+  PERF_STAGE(PERF_STAGE_PIXELS, pixelsStart);
+  sendReply_P(ROW_SUCCESS);
+}
+
+/**
+ * pumpReceive is a function that moves the bytes waiting in the serial library's receive buffer into the larger receive ring buffer.
+ *
+ * **Functionality:**
+ *
+ * - The serial library only buffers 64 bytes. Emptying it often, and right before and after every display refresh, leaves the whole
+ *   library buffer free for bytes that arrive while the firmware is busy.
+ * - Bytes that do not fit into the ring stay in the library buffer and are picked up by a later call, so nothing is dropped here.
+ * - Updates `lastByteMillis`, which `loop` uses to detect an idle line.
+ */
+void pumpReceive() {
+  while (bluetoothManager.available()) {
+    if (rxRingAvailable() == RX_RING_SIZE - 1) {
+      PERF_COUNT(ringFull);
+      return;
+    }
+    rxRingPut((uint8_t)bluetoothManager.read());
+    lastByteMillis = millis();
+    PERF_COUNT(bytesReceived);
+  }
+}
+
+/**
+ * beginBusy is a function that drains the receive path and, with `PROTO_CAP_FLOW_CONTROL`, tells the app to pause sending with a
+ * "busy" line, before the firmware stops listening for a while.
+ *
+ * **Functionality:**
+ *
+ * - `FastLED.show` keeps interrupts disabled for about 8 ms on 256 LEDs; `SoftwareSerial` cannot receive during that time, so bytes
+ *   the app sends then are lost and come back as `ROW-FAIL` retries.
+ * - The "busy" line is surrounded by newlines so it never merges with a reply written without one.
+ */
+void beginBusy() {
+  pumpReceive();
+  if (flowControlActive) {
+    bluetoothManager.print(F(LINK_BUSY_LINE));
+  }
+}
+
+/**
+ * endBusy is a function that drains the receive path after a display refresh and, with `PROTO_CAP_FLOW_CONTROL`, sends the "ready"
+ * line that lets the app continue.
+ */
+void endBusy() {
+  pumpReceive();
+  if (flowControlActive) {
+    bluetoothManager.print(F(LINK_READY_LINE));
+  }
+}
+
+/**
+ * showLeds is a function that shows the content of `leds[]` on the LED strip between `beginBusy` and `endBusy`.
+ */
+void showLeds() {
+  beginBusy();
+  PERF_START(showStart);
+  FastLED.show(50);
+  PERF_STAGE(PERF_STAGE_SHOW, showStart);
+  endBusy();
+}
+
+/**
+ * showPlaybackFrame is a function that shows a frame of an animation or effect. Unlike `showLeds` it sends no "busy"/"ready" lines:
+ * playback frames are only shown while the line is idle, see `playbackDue`, so the app has nothing in flight to hold back.
+ */
+void showPlaybackFrame() {
+  pumpReceive();
+  PERF_START(showStart);
+  FastLED.show(50);
+  PERF_STAGE(PERF_STAGE_SHOW, showStart);
+  pumpReceive();
+}
+
+/**
+ * sendTile is a function that answers a `TILE` or `tile-set:` command with the tile of this panel: `tile:<x>:<y>:<width>:<height>`,
+ * all in hex pixels, the offset from `tileLoad`.
+ */
+void sendTile() {
+  uint8_t x, y;
+  tileLoad(x, y);
+  char reply[sizeof(TILE_PREFIX) + 11];
+  snprintf_P(reply, sizeof(reply), PSTR(TILE_PREFIX "%02x:%02x:%02x:%02x"), x, y, Panel::width, Panel::height);
+  sendReply(reply);
+}
+
+/**
+ * setLinkBaud is a function that switches the Bluetooth link to one of the rates in `LINK_BAUD_RATES`.
+ *
+ * **Parameters:**
+ *
+ * - `code`: A `uint8_t` index into `LINK_BAUD_RATES`.
+ *
+ * **Functionality:**
+ *
+ * - Does nothing if the link already runs at that rate.
+ * - Waits until pending output (such as the `baud-ack` reply) has left at the old rate; `SoftwareSerial` already writes synchronously.
+ * - Restarts the transport at the new rate and resets the whole receive state: bytes still in the receive ring and a half-received
+ *   message, binary frame or `data:` line were sent at the old rate and cannot be decoded across the change.
+ * - Ends a pending `BAUD_CHECK` wait; the `baud:` handler starts a new one after the switch.
+ */
+void setLinkBaud(uint8_t code) {
+  if (code == linkBaudCode) {
+    return;
+  }
+#if BT_TRANSPORT != BT_TRANSPORT_SOFTWARE_SERIAL
+  bluetoothManager.flush();
+#endif
+  bluetoothManager.end();
+  bluetoothManager.begin(linkBaudRate(code));
+
+  linkBaudCode = code;
+  linkSpeedPending = false;
+  rxRingClear();
+  messageIndex = 0;
+  receivingFrame = false;
+  frameIndex = 0;
+  frameOverflow = false;
+  receivingData = false;
 }
 
 /**
@@ -324,8 +1824,13 @@ bool checkCheckSum(char* message) {
  * - Sets all LEDs in the strip to the specified `color`.
  * - Displays the color immediately on the LED strip using `FastLED.show()`.
  * - Adds a brief delay to ensure the color is set correctly.
+ * - Wraps the refresh in `beginBusy` and `endBusy`, like `showLeds`.
  */
 void setLedsColor(CRGB color) {
+  beginBusy();
+  PERF_START(showStart);
   FastLED.showColor(color, 50);
+  PERF_STAGE(PERF_STAGE_SHOW, showStart);
   delay(10);
+  endBusy();
 }
\ No newline at end of file
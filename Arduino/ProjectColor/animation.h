@@ -0,0 +1,94 @@
+#include <EEPROM.h>
+
+// Stored animation: an 8Byte header followed by the frames. Every frame is a list of chunks, each 1Byte length + a
+// FRAME_TYPE_PIXELS_COMPRESSED payload (position, codec, tokens) of up to FRAME_MAX_PAYLOAD bytes, closed by a 0 length.
+// The first frame covers the whole panel, the others only the pixels that change.
+// By default the storage is the EEPROM of the Uno (1024Bytes) up to the frame cache and the tile offset, see framecache.h and tile.h.
+#ifndef ANIM_STORAGE_SIZE
+#define ANIM_STORAGE_SIZE (E2END + 1 - TILE_CONFIG_SIZE - FRAME_CACHE_EEPROM_SIZE)
+#endif
+#define ANIM_HEADER_SIZE 8        // magic, frame count, fps, flags, 2Bytes data length, 2Bytes CRC-16 of the data (both big-endian)
+#define ANIM_MAGIC 0xA5
+#define ANIM_FLAG_LOOP 0x01       // start over after the last frame instead of stopping on it
+#define ANIM_FLAG_AUTOPLAY 0x02   // start playing after reset
+#define ANIM_MAX_FPS 50           // FastLED.show alone takes ~8 ms
+#define ANIM_DATA_OFFSET_SIZE 2   // FRAME_TYPE_ANIMATION_DATA payload: 2Bytes storage offset (big-endian) + data bytes
+#define ANIM_CRC_BLOCK_SIZE 16    // bytes read per step while the CRC of the stored data is checked
+
+struct AnimationHeader {
+  uint8_t frameCount;
+  uint8_t fps;
+  uint8_t flags;
+  uint16_t dataLength;
+};
+
+// The storage backend is these two functions. To keep animations on an external SPI flash or SD card instead of the EEPROM,
+// define ANIM_STORAGE_EXTERNAL and ANIM_STORAGE_SIZE and provide both functions for the chip before this header is included.
+#ifndef ANIM_STORAGE_EXTERNAL
+/**
+ * animStorageRead is a function that reads one byte of the animation storage.
+ *
+ * **Parameters:**
+ *
+ * - `address`: A `uint16_t` offset below `ANIM_STORAGE_SIZE`.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the stored byte.
+ */
+uint8_t animStorageRead(uint16_t address) {
+  return EEPROM.read(address);
+}
+
+/**
+ * animStorageWrite is a function that writes one byte of the animation storage. Unchanged bytes are skipped, which saves the
+ * 3.3 ms and the wear of an EEPROM write cycle.
+ *
+ * **Parameters:**
+ *
+ * - `address`: A `uint16_t` offset below `ANIM_STORAGE_SIZE`.
+ * - `value`: A `uint8_t` holding the byte to store.
+ */
+void animStorageWrite(uint16_t address, uint8_t value) {
+  EEPROM.update(address, value);
+}
+#endif
+
+/**
+ * animReadHeader is a function that reads and checks the header of the stored animation.
+ *
+ * **Parameters:**
+ *
+ * - `header`: An `AnimationHeader&` that receives the frame count, frame rate, flags and data length.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if the magic byte, frame count, frame rate and data length are plausible and the CRC-16 over the frame data
+ *   matches, so a half-finished upload or an erased storage is never played.
+ */
+bool animReadHeader(AnimationHeader& header) {
+  if (animStorageRead(0) != ANIM_MAGIC) {
+    return false;
+  }
+  header.frameCount = animStorageRead(1);
+  header.fps = animStorageRead(2);
+  header.flags = animStorageRead(3);
+  header.dataLength = ((uint16_t)animStorageRead(4) << 8) | animStorageRead(5);
+  uint16_t storedCrc = ((uint16_t)animStorageRead(6) << 8) | animStorageRead(7);
+
+  if (header.frameCount == 0 || header.fps == 0 || header.fps > ANIM_MAX_FPS ||
+      header.dataLength > ANIM_STORAGE_SIZE - ANIM_HEADER_SIZE) {
+    return false;
+  }
+
+  uint8_t block[ANIM_CRC_BLOCK_SIZE];
+  uint16_t crc = 0xFFFF;
+  for (uint16_t offset = 0; offset < header.dataLength; offset += sizeof(block)) {
+    uint8_t count = header.dataLength - offset < sizeof(block) ? header.dataLength - offset : sizeof(block);
+    for (uint8_t i = 0; i < count; i++) {
+      block[i] = animStorageRead(ANIM_HEADER_SIZE + offset + i);
+    }
+    crc = crc16Update(crc, block, count);
+  }
+  return crc == storedCrc;
+}
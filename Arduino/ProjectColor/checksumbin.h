@@ -1,179 +1,243 @@
-#define PIXEL_BINARY_CHAR_SIZE 36  //1_PIXEL * 4_bytes(position,R,G,B) * 8bits(per Byte) + 4bits(1Byte for checksum)
+#define PIXEL_BYTE_SIZE 4 //1_PIXEL * 4_bytes(position,R,G,B)
 #define ROW_HEX_CHAR_SIZE 136 //16_PIXEL * 4_bytes(position,R,G,B) * 2chars(per Byte) + 2chars(1Byte for checksum)
-#define ROW_BINARY_CHAR_SIZE 520 //16_PIXEL * 4_bytes(position,R,G,B) * 8chars(per Byte) + 8chars(1Byte for checksum)
+#define ROW_BYTE_SIZE 65 //16_PIXEL * 4_bytes(position,R,G,B) + 1Byte for checksum
 
 #define HALF_ROW_HEX_CHAR_SIZE 66 //8_PIXEL * 4_bytes(position,R,G,B) * 2chars(per Byte) + 2chars(1Byte for checksum)
-#define HALF_ROW_BINARY_CHAR_SIZE 264 //8_PIXEL * 4_bytes(position,R,G,B) * 8chars(per Byte) + 8chars(1Byte for checksum)
+#define HALF_ROW_BYTE_SIZE 33 //8_PIXEL * 4_bytes(position,R,G,B) + 1Byte for checksum
 
 #define QUARTER_ROW_HEX_CHAR_SIZE 34 //4_PIXEL * 4_bytes(position,R,G,B) * 2chars(per Byte) + 2chars(1Byte for checksum)
-#define QUARTER_ROW_BINARY_CHAR_SIZE 136 //4_PIXEL * 4_bytes(position,R,G,B) * 8chars(per Byte) + 8chars(1Byte for checksum)
+#define QUARTER_ROW_BYTE_SIZE 17 //4_PIXEL * 4_bytes(position,R,G,B) + 1Byte for checksum
 
+#define ONES_COMPLEMENT_VALID 0xFF // one's complement sum of data + checksum when nothing was corrupted
+
+#ifndef CRC_USE_TABLES
+#define CRC_USE_TABLES 1 // 1: 256-entry PROGMEM tables (768 Bytes of flash), 0: bitwise loops (no tables, ~8x slower)
+#endif
+
+#if CRC_USE_TABLES
+// CRC-8, polynomial 0x07
+const uint8_t CRC8_TABLE[256] PROGMEM = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15, 0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D,
+    0x70, 0x77, 0x7E, 0x79, 0x6C, 0x6B, 0x62, 0x65, 0x48, 0x4F, 0x46, 0x41, 0x54, 0x53, 0x5A, 0x5D,
+    0xE0, 0xE7, 0xEE, 0xE9, 0xFC, 0xFB, 0xF2, 0xF5, 0xD8, 0xDF, 0xD6, 0xD1, 0xC4, 0xC3, 0xCA, 0xCD,
+    0x90, 0x97, 0x9E, 0x99, 0x8C, 0x8B, 0x82, 0x85, 0xA8, 0xAF, 0xA6, 0xA1, 0xB4, 0xB3, 0xBA, 0xBD,
+    0xC7, 0xC0, 0xC9, 0xCE, 0xDB, 0xDC, 0xD5, 0xD2, 0xFF, 0xF8, 0xF1, 0xF6, 0xE3, 0xE4, 0xED, 0xEA,
+    0xB7, 0xB0, 0xB9, 0xBE, 0xAB, 0xAC, 0xA5, 0xA2, 0x8F, 0x88, 0x81, 0x86, 0x93, 0x94, 0x9D, 0x9A,
+    0x27, 0x20, 0x29, 0x2E, 0x3B, 0x3C, 0x35, 0x32, 0x1F, 0x18, 0x11, 0x16, 0x03, 0x04, 0x0D, 0x0A,
+    0x57, 0x50, 0x59, 0x5E, 0x4B, 0x4C, 0x45, 0x42, 0x6F, 0x68, 0x61, 0x66, 0x73, 0x74, 0x7D, 0x7A,
+    0x89, 0x8E, 0x87, 0x80, 0x95, 0x92, 0x9B, 0x9C, 0xB1, 0xB6, 0xBF, 0xB8, 0xAD, 0xAA, 0xA3, 0xA4,
+    0xF9, 0xFE, 0xF7, 0xF0, 0xE5, 0xE2, 0xEB, 0xEC, 0xC1, 0xC6, 0xCF, 0xC8, 0xDD, 0xDA, 0xD3, 0xD4,
+    0x69, 0x6E, 0x67, 0x60, 0x75, 0x72, 0x7B, 0x7C, 0x51, 0x56, 0x5F, 0x58, 0x4D, 0x4A, 0x43, 0x44,
+    0x19, 0x1E, 0x17, 0x10, 0x05, 0x02, 0x0B, 0x0C, 0x21, 0x26, 0x2F, 0x28, 0x3D, 0x3A, 0x33, 0x34,
+    0x4E, 0x49, 0x40, 0x47, 0x52, 0x55, 0x5C, 0x5B, 0x76, 0x71, 0x78, 0x7F, 0x6A, 0x6D, 0x64, 0x63,
+    0x3E, 0x39, 0x30, 0x37, 0x22, 0x25, 0x2C, 0x2B, 0x06, 0x01, 0x08, 0x0F, 0x1A, 0x1D, 0x14, 0x13,
+    0xAE, 0xA9, 0xA0, 0xA7, 0xB2, 0xB5, 0xBC, 0xBB, 0x96, 0x91, 0x98, 0x9F, 0x8A, 0x8D, 0x84, 0x83,
+    0xDE, 0xD9, 0xD0, 0xD7, 0xC2, 0xC5, 0xCC, 0xCB, 0xE6, 0xE1, 0xE8, 0xEF, 0xFA, 0xFD, 0xF4, 0xF3
+};
+
+// CRC-16/CCITT-FALSE, polynomial 0x1021
+const uint16_t CRC16_TABLE[256] PROGMEM = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF,
+    0x1231, 0x0210, 0x3273, 0x2252, 0x52B5, 0x4294, 0x72F7, 0x62D6,
+    0x9339, 0x8318, 0xB37B, 0xA35A, 0xD3BD, 0xC39C, 0xF3FF, 0xE3DE,
+    0x2462, 0x3443, 0x0420, 0x1401, 0x64E6, 0x74C7, 0x44A4, 0x5485,
+    0xA56A, 0xB54B, 0x8528, 0x9509, 0xE5EE, 0xF5CF, 0xC5AC, 0xD58D,
+    0x3653, 0x2672, 0x1611, 0x0630, 0x76D7, 0x66F6, 0x5695, 0x46B4,
+    0xB75B, 0xA77A, 0x9719, 0x8738, 0xF7DF, 0xE7FE, 0xD79D, 0xC7BC,
+    0x48C4, 0x58E5, 0x6886, 0x78A7, 0x0840, 0x1861, 0x2802, 0x3823,
+    0xC9CC, 0xD9ED, 0xE98E, 0xF9AF, 0x8948, 0x9969, 0xA90A, 0xB92B,
+    0x5AF5, 0x4AD4, 0x7AB7, 0x6A96, 0x1A71, 0x0A50, 0x3A33, 0x2A12,
+    0xDBFD, 0xCBDC, 0xFBBF, 0xEB9E, 0x9B79, 0x8B58, 0xBB3B, 0xAB1A,
+    0x6CA6, 0x7C87, 0x4CE4, 0x5CC5, 0x2C22, 0x3C03, 0x0C60, 0x1C41,
+    0xEDAE, 0xFD8F, 0xCDEC, 0xDDCD, 0xAD2A, 0xBD0B, 0x8D68, 0x9D49,
+    0x7E97, 0x6EB6, 0x5ED5, 0x4EF4, 0x3E13, 0x2E32, 0x1E51, 0x0E70,
+    0xFF9F, 0xEFBE, 0xDFDD, 0xCFFC, 0xBF1B, 0xAF3A, 0x9F59, 0x8F78,
+    0x9188, 0x81A9, 0xB1CA, 0xA1EB, 0xD10C, 0xC12D, 0xF14E, 0xE16F,
+    0x1080, 0x00A1, 0x30C2, 0x20E3, 0x5004, 0x4025, 0x7046, 0x6067,
+    0x83B9, 0x9398, 0xA3FB, 0xB3DA, 0xC33D, 0xD31C, 0xE37F, 0xF35E,
+    0x02B1, 0x1290, 0x22F3, 0x32D2, 0x4235, 0x5214, 0x6277, 0x7256,
+    0xB5EA, 0xA5CB, 0x95A8, 0x8589, 0xF56E, 0xE54F, 0xD52C, 0xC50D,
+    0x34E2, 0x24C3, 0x14A0, 0x0481, 0x7466, 0x6447, 0x5424, 0x4405,
+    0xA7DB, 0xB7FA, 0x8799, 0x97B8, 0xE75F, 0xF77E, 0xC71D, 0xD73C,
+    0x26D3, 0x36F2, 0x0691, 0x16B0, 0x6657, 0x7676, 0x4615, 0x5634,
+    0xD94C, 0xC96D, 0xF90E, 0xE92F, 0x99C8, 0x89E9, 0xB98A, 0xA9AB,
+    0x5844, 0x4865, 0x7806, 0x6827, 0x18C0, 0x08E1, 0x3882, 0x28A3,
+    0xCB7D, 0xDB5C, 0xEB3F, 0xFB1E, 0x8BF9, 0x9BD8, 0xABBB, 0xBB9A,
+    0x4A75, 0x5A54, 0x6A37, 0x7A16, 0x0AF1, 0x1AD0, 0x2AB3, 0x3A92,
+    0xFD2E, 0xED0F, 0xDD6C, 0xCD4D, 0xBDAA, 0xAD8B, 0x9DE8, 0x8DC9,
+    0x7C26, 0x6C07, 0x5C64, 0x4C45, 0x3CA2, 0x2C83, 0x1CE0, 0x0CC1,
+    0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
+    0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
+};
+#endif
 
 /**
- * Ones_complement is a function that computes the one's complement of a given binary string. The function inverts each bit in the string, changing '0' to '1' and '1' to '0'.
+ * onesComplementSumUpdate is a function that adds a block of bytes to a running 8-bit one's complement sum. It is the byte-native
+ * replacement of the bit-string `checkSum`, and produces the same value as the app's 8-bit block checksum, so messages from
+ * older app builds are still accepted.
  *
  * **Parameters:**
  *
- * - `data`: A `char*` representing the binary string for which the one's complement will be calculated. The string is modified in place.
+ * - `sum`: A `uint8_t` holding the running sum. Start with `0x00`.
+ * - `data`: A `const uint8_t*` pointing to the bytes to be added.
+ * - `length`: A `uint8_t` specifying the number of bytes in `data`.
  *
- * **Functionality:**
+ * **Returns:**
  *
- * - The function iterates over each character in the `data` string.
- * - For each character, it checks if the character is '0' or '1' and then inverts it.
- * - The modified string is the one's complement of the original input, and the inversion is done in place.
+ * - `uint8_t`: Returns the updated sum, which can be passed back in for the next block of the same message.
  *
- * - This function is typically used in checksum calculations to ensure data integrity by helping verify the transmitted data.
+ * **Functionality:**
+ *
+ * - Every byte is added as an 8-bit block; a carry out of the top bit is added back to the lowest bit (end-around carry).
  */
-void Ones_complement(char* data) {
-    for (int i = 0; i < strlen(data); i++) {
-        if (data[i] == '0')
-            data[i] = '1';
-        else
-            data[i] = '0';
+uint8_t onesComplementSumUpdate(uint8_t sum, const uint8_t* data, uint8_t length) {
+    uint16_t accumulator = sum;
+    for (uint8_t index = 0; index < length; index++) {
+        accumulator += data[index];
+        accumulator = (accumulator & 0xFF) + (accumulator >> 8);
     }
+    return (uint8_t)accumulator;
 }
 
 /**
- * checkSum is a function that calculates the checksum of a binary string by dividing it into blocks of a specified size, performing binary addition on each block, and then applying one's complement.
- * The checksum helps ensure data integrity during transmission.
+ * onesComplementChecksum is a function that calculates the checksum byte the sender appends to a message.
  *
  * **Parameters:**
  *
- * - `data`: A `char*` representing the binary string for which the checksum will be calculated. The string may be padded to fit the block size.
- * - `block_size`: An `int` specifying the size of each block (i.e., the number of bits) used in the checksum calculation.
- * - `result`: A `char*` where the calculated checksum will be stored. The checksum is the one's complement of the binary addition result.
+ * - `data`: A `const uint8_t*` pointing to the message bytes.
+ * - `length`: A `uint8_t` specifying the number of bytes in `data`.
  *
- * **Functionality:**
+ * **Returns:**
  *
- * - The function first checks if the length of `data` is divisible by `block_size`. If not, the string is padded with leading zeros to make it so.
- * - It then initializes the `result` with the first block of data.
- * - The function performs binary addition of the blocks, updating the `result` with each addition.
- * - If a carry is generated during the addition, it is handled and propagated accordingly.
- * - Finally, the function applies one's complement to the `result`, ensuring that it represents the checksum of the input `data`.
+ * - `uint8_t`: Returns the one's complement of the one's complement sum of the message.
  */
-void checkSum(char* data, int block_size, char* result) {
-    // Check data size is divisible by block_size
-    int n = strlen(data);
-    if (n % block_size != 0) {
-        int pad_size = block_size - (n % block_size);
-        for (int i = n + pad_size - 1; i >= pad_size; i--) {
-            data[i] = data[i - pad_size];
-        }
-        for (int i = 0; i < pad_size; i++) {
-            data[i] = '0';
-        }
-        n += pad_size;
-        data[n] = '\0'; // Add null-terminator at the end
-    }
-
-    // Initialize result to the first block of data
-    strncpy(result, data, block_size);
-    result[block_size] = '\0'; // Null-terminate the result
-
-    // Loop to calculate block-wise addition of data
-    for (int i = block_size; i < n; i += block_size) {
-        char next_block[block_size + 1];
-        strncpy(next_block, &data[i], block_size);
-        next_block[block_size] = '\0'; // Null-terminate next_block
-
-        char additions[block_size + 1];
-        int sum = 0, carry = 0;
-
-        for (int k = block_size - 1; k >= 0; k--) {
-            sum = (next_block[k] - '0') + (result[k] - '0') + carry;
-            carry = sum / 2;
-            additions[k] = (sum % 2) + '0';
-        }
-        additions[block_size] = '\0';
-
-        // If carry is 1, handle it
-        if (carry == 1) {
-            for (int l = block_size - 1; l >= 0; l--) {
-                sum = (additions[l] - '0') + carry;
-                carry = sum / 2;
-                additions[l] = (sum % 2) + '0';
-            }
-        }
-
-        strcpy(result, additions); // Copy additions to result
-    }
+uint8_t onesComplementChecksum(const uint8_t* data, uint8_t length) {
+    return (uint8_t)~onesComplementSumUpdate(0x00, data, length);
+}
 
-    // Apply One's complement to the result
-    Ones_complement(result);
+/**
+ * onesComplementIsValid is a function that verifies a message that ends with its one's complement checksum byte.
+ *
+ * **Parameters:**
+ *
+ * - `data`: A `const uint8_t*` pointing to the message bytes followed by the checksum byte.
+ * - `length`: A `uint8_t` specifying the number of bytes in `data`, including the checksum byte.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if the sum over message and checksum is `ONES_COMPLEMENT_VALID`, meaning its complement is all zero bits.
+ */
+bool onesComplementIsValid(const uint8_t* data, uint8_t length) {
+    return onesComplementSumUpdate(0x00, data, length) == ONES_COMPLEMENT_VALID;
 }
 
 /**
- * result_checker is a function that verifies whether a given checksum result is valid by checking if all bits in the result are zero.
+ * crc8Update is a function that feeds a block of bytes into a running CRC-8 (polynomial 0x07, initial value 0x00). It protects binary frames,
+ * where the data is not available as a bit string.
  *
  * **Parameters:**
  *
- * - `result`: A `char*` representing the binary checksum result that needs to be verified.
- * - `block_size`: An `int` specifying the size of the block (i.e., the number of bits) to be checked.
+ * - `crc`: A `uint8_t` holding the running CRC. Start with `0x00`.
+ * - `data`: A `const uint8_t*` pointing to the bytes to be checked.
+ * - `length`: A `uint8_t` specifying the number of bytes in `data`.
  *
  * **Returns:**
  *
- * - `bool`: Returns `true` if all bits in the `result` are '0', indicating a valid checksum. Otherwise, returns `false`.
+ * - `uint8_t`: Returns the updated CRC, which can be passed back in for the next block, or a single byte at a time.
  *
  * **Functionality:**
  *
- * - The function iterates over each bit in the `result` string.
- * - If any bit is found to be non-zero, the function returns `false`.
- * - If all bits are '0', the function returns `true`, indicating that the checksum is valid and the data integrity is intact.
+ * - With `CRC_USE_TABLES` each byte costs one `pgm_read_byte` from `CRC8_TABLE`; otherwise the polynomial is applied bit by bit.
  */
-bool result_checker(char* result, int block_size) {
-	for (size_t i = 0; i < block_size; i++)
-	{
-		if (result[i] != '0')
-		{
-			return false;
-		}
-	}
-	return true;
+uint8_t crc8Update(uint8_t crc, const uint8_t* data, uint8_t length) {
+    for (uint8_t index = 0; index < length; index++) {
+#if CRC_USE_TABLES
+        crc = pgm_read_byte(&CRC8_TABLE[crc ^ data[index]]);
+#else
+        crc ^= data[index];
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x80) ? (uint8_t)((crc << 1) ^ 0x07) : (uint8_t)(crc << 1);
+        }
+#endif
+    }
+    return crc;
 }
 
 /**
- * hexData_to_binaryData is a function that converts a hexadecimal string into its equivalent binary string representation. Each hex digit is translated into a 4-bit binary sequence.
+ * crc8 is a function that calculates the CRC-8 of a complete byte buffer with `crc8Update`.
  *
  * **Parameters:**
  *
- * - `hexData`: A `const char*` representing the hexadecimal data to be converted to binary.
- * - `binaryData`: A `char*` where the resulting binary string will be stored. The binary string is constructed by appending 4-bit binary equivalents of each hex digit.
+ * - `data`: A `const uint8_t*` pointing to the bytes to be checked.
+ * - `length`: A `uint8_t` specifying the number of bytes in `data`.
  *
- * **Functionality:**
- *
- * - The function initializes `binaryData` as an empty string.
- * - It then iterates over each character in `hexData`, appending the corresponding 4-bit binary string to `binaryData`.
- * - The function handles both uppercase and lowercase hexadecimal digits.
- * - If an invalid hexadecimal character is encountered, the function appends "????" to `binaryData` to indicate an error.
+ * **Returns:**
  *
- * - This function is typically used when binary data is needed for further processing or transmission, but the data is initially provided in hexadecimal format.
+ * - `uint8_t`: Returns the CRC-8 of the buffer.
  */
-void hexData_to_binaryData(const char* hexData, char* binaryData) {
-    // Initialize the binary string to an empty string
-    binaryData[0] = '\0';
+uint8_t crc8(const uint8_t* data, uint8_t length) {
+    return crc8Update(0x00, data, length);
+}
 
-    // Convert each hex digit to its binary equivalent
-    for (int index = 0; index < strlen(hexData); index++) {
-        switch (hexData[index]) {
-            case '0': 			strcat(binaryData, "0000"); break;
-            case '1': 			strcat(binaryData, "0001"); break;
-            case '2': 			strcat(binaryData, "0010"); break;
-            case '3': 			strcat(binaryData, "0011"); break;
-            case '4': 			strcat(binaryData, "0100"); break;
-            case '5': 			strcat(binaryData, "0101"); break;
-            case '6': 			strcat(binaryData, "0110"); break;
-            case '7': 			strcat(binaryData, "0111"); break;
-            case '8': 			strcat(binaryData, "1000"); break;
-            case '9': 			strcat(binaryData, "1001"); break;
-            case 'a': case 'A': strcat(binaryData, "1010"); break;
-            case 'b': case 'B': strcat(binaryData, "1011"); break;
-            case 'c': case 'C': strcat(binaryData, "1100"); break;
-            case 'd': case 'D': strcat(binaryData, "1101"); break;
-            case 'e': case 'E': strcat(binaryData, "1110"); break;
-            case 'f': case 'F': strcat(binaryData, "1111"); break;
-            default: // Handle invalid hex characters if needed
-                strcat(binaryData, "????");
-                break;
+/**
+ * crc16Update is a function that feeds a block of bytes into a running CRC-16/CCITT-FALSE (polynomial 0x1021, initial value 0xFFFF).
+ * It is meant for longer payloads, where CRC-8 misses too many burst errors.
+ *
+ * **Parameters:**
+ *
+ * - `crc`: A `uint16_t` holding the running CRC. Start with `0xFFFF`.
+ * - `data`: A `const uint8_t*` pointing to the bytes to be checked.
+ * - `length`: A `uint16_t` specifying the number of bytes in `data`.
+ *
+ * **Returns:**
+ *
+ * - `uint16_t`: Returns the updated CRC.
+ */
+uint16_t crc16Update(uint16_t crc, const uint8_t* data, uint16_t length) {
+    for (uint16_t index = 0; index < length; index++) {
+#if CRC_USE_TABLES
+        crc = (crc << 8) ^ pgm_read_word(&CRC16_TABLE[(uint8_t)(crc >> 8) ^ data[index]]);
+#else
+        crc ^= (uint16_t)data[index] << 8;
+        for (uint8_t bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
         }
+#endif
     }
-}
\ No newline at end of file
+    return crc;
+}
+
+/**
+ * crc16 is a function that calculates the CRC-16/CCITT-FALSE of a complete byte buffer with `crc16Update`.
+ *
+ * **Parameters:**
+ *
+ * - `data`: A `const uint8_t*` pointing to the bytes to be checked.
+ * - `length`: A `uint16_t` specifying the number of bytes in `data`.
+ *
+ * **Returns:**
+ *
+ * - `uint16_t`: Returns the CRC-16 of the buffer.
+ */
+uint16_t crc16(const uint8_t* data, uint16_t length) {
+    return crc16Update(0xFFFF, data, length);
+}
+
+/**
+ * hexNibble is a function that converts a single hexadecimal character to its 4-bit value.
+ *
+ * **Parameters:**
+ *
+ * - `c`: A `char` holding the hexadecimal digit. Both uppercase and lowercase digits are accepted.
+ *
+ * **Returns:**
+ *
+ * - `int8_t`: Returns the value 0..15, or `-1` if `c` is not a hexadecimal digit.
+ */
+int8_t hexNibble(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
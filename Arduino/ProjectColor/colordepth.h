@@ -0,0 +1,98 @@
+#define COLOR_DEPTH_RGB888 0x00   // 3Bytes per pixel
+#define COLOR_DEPTH_RGB565 0x01   // 2Bytes per pixel, big-endian rrrrrggg gggbbbbb
+#define COLOR_DEPTH_RGB444 0x02   // 3Bytes per 2 pixels: r0g0 b0r1 g1b1, an odd last pixel takes 2Bytes
+#define COLOR_DEPTH_RGB332 0x03   // 1Byte per pixel rrrgggbb
+
+#define PACKED_HEADER_SIZE 3      // 1Byte position of the first pixel + 1Byte color depth + 1Byte pixel count
+
+// Expansion of n-bit color components to 8 bits by bit replication, so that 0 stays 0x00 and the maximum becomes 0xFF
+const uint8_t EXPAND_2BIT[4] PROGMEM = {
+    0x00, 0x55, 0xAA, 0xFF
+};
+const uint8_t EXPAND_3BIT[8] PROGMEM = {
+    0x00, 0x24, 0x49, 0x6D, 0x92, 0xB6, 0xDB, 0xFF
+};
+const uint8_t EXPAND_4BIT[16] PROGMEM = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xAA, 0xBB, 0xCC, 0xDD, 0xEE, 0xFF
+};
+const uint8_t EXPAND_5BIT[32] PROGMEM = {
+    0x00, 0x08, 0x10, 0x18, 0x21, 0x29, 0x31, 0x39, 0x42, 0x4A, 0x52, 0x5A, 0x63, 0x6B, 0x73, 0x7B,
+    0x84, 0x8C, 0x94, 0x9C, 0xA5, 0xAD, 0xB5, 0xBD, 0xC6, 0xCE, 0xD6, 0xDE, 0xE7, 0xEF, 0xF7, 0xFF
+};
+const uint8_t EXPAND_6BIT[64] PROGMEM = {
+    0x00, 0x04, 0x08, 0x0C, 0x10, 0x14, 0x18, 0x1C, 0x20, 0x24, 0x28, 0x2C, 0x30, 0x34, 0x38, 0x3C,
+    0x41, 0x45, 0x49, 0x4D, 0x51, 0x55, 0x59, 0x5D, 0x61, 0x65, 0x69, 0x6D, 0x71, 0x75, 0x79, 0x7D,
+    0x82, 0x86, 0x8A, 0x8E, 0x92, 0x96, 0x9A, 0x9E, 0xA2, 0xA6, 0xAA, 0xAE, 0xB2, 0xB6, 0xBA, 0xBE,
+    0xC3, 0xC7, 0xCB, 0xCF, 0xD3, 0xD7, 0xDB, 0xDF, 0xE3, 0xE7, 0xEB, 0xEF, 0xF3, 0xF7, 0xFB, 0xFF
+};
+
+/**
+ * packedColorBytes is a function that returns how many bytes a run of pixels takes in a given color depth.
+ *
+ * **Parameters:**
+ *
+ * - `depth`: A `uint8_t` holding one of the `COLOR_DEPTH_*` values.
+ * - `count`: A `uint8_t` specifying the number of pixels.
+ *
+ * **Returns:**
+ *
+ * - `uint16_t`: Returns the number of bytes, or `0xFFFF` for an unknown depth.
+ */
+uint16_t packedColorBytes(uint8_t depth, uint8_t count) {
+    switch (depth) {
+        case COLOR_DEPTH_RGB888: return (uint16_t)count * 3;
+        case COLOR_DEPTH_RGB565: return (uint16_t)count * 2;
+        case COLOR_DEPTH_RGB444: return ((uint16_t)count * 3 + 1) / 2;
+        case COLOR_DEPTH_RGB332: return count;
+        default: return 0xFFFF;
+    }
+}
+
+/**
+ * unpackColor is a function that expands the color of the `i`-th pixel of packed color data to a 24-bit `CRGB`.
+ *
+ * **Parameters:**
+ *
+ * - `data`: A `const uint8_t*` pointing to the packed colors.
+ * - `depth`: A `uint8_t` holding one of the `COLOR_DEPTH_*` values, already checked with `packedColorBytes`.
+ * - `i`: A `uint8_t` holding the number of the pixel.
+ *
+ * **Returns:**
+ *
+ * - `CRGB`: Returns the expanded color.
+ *
+ * **Functionality:**
+ *
+ * - The reduced components are looked up in the `EXPAND_*BIT` tables, so expanding a pixel costs three table reads and no multiplication.
+ */
+CRGB unpackColor(const uint8_t* data, uint8_t depth, uint8_t i) {
+    switch (depth) {
+        case COLOR_DEPTH_RGB565: {
+            const uint8_t* p = data + 2 * i;
+            return CRGB(pgm_read_byte(&EXPAND_5BIT[p[0] >> 3]),
+                        pgm_read_byte(&EXPAND_6BIT[((p[0] & 0x07) << 3) | (p[1] >> 5)]),
+                        pgm_read_byte(&EXPAND_5BIT[p[1] & 0x1F]));
+        }
+        case COLOR_DEPTH_RGB444: {
+            const uint8_t* p = data + 3 * (i >> 1);
+            if (i & 1) {
+                return CRGB(pgm_read_byte(&EXPAND_4BIT[p[1] & 0x0F]),
+                            pgm_read_byte(&EXPAND_4BIT[p[2] >> 4]),
+                            pgm_read_byte(&EXPAND_4BIT[p[2] & 0x0F]));
+            }
+            return CRGB(pgm_read_byte(&EXPAND_4BIT[p[0] >> 4]),
+                        pgm_read_byte(&EXPAND_4BIT[p[0] & 0x0F]),
+                        pgm_read_byte(&EXPAND_4BIT[p[1] >> 4]));
+        }
+        case COLOR_DEPTH_RGB332: {
+            uint8_t c = data[i];
+            return CRGB(pgm_read_byte(&EXPAND_3BIT[c >> 5]),
+                        pgm_read_byte(&EXPAND_3BIT[(c >> 2) & 0x07]),
+                        pgm_read_byte(&EXPAND_2BIT[c & 0x03]));
+        }
+        default: {
+            const uint8_t* p = data + 3 * i;
+            return CRGB(p[0], p[1], p[2]);
+        }
+    }
+}
@@ -0,0 +1,105 @@
+// Procedural effects rendered on the device. An effect is selected and tuned with 4 bytes: effect, speed, palette and seed.
+#define EFFECT_NONE 0x00
+#define EFFECT_GRADIENT 0x01      // palette spread along the diagonal, sliding
+#define EFFECT_RAINBOW 0x02       // full hue circle across the columns, cycling; ignores the palette
+#define EFFECT_PLASMA 0x03        // sum of three sine waves looked up in the palette
+#define EFFECT_FIRE 0x04          // noise rising from the bottom row, cooled with height; best with EFFECT_PALETTE_HEAT
+#define EFFECT_NOISE 0x05         // 3D noise drifting through the palette
+#define EFFECT_SCROLL 0x06        // rotates the picture on the panel to the left; ignores palette and seed
+#define EFFECT_COUNT 0x07
+
+#define EFFECT_PALETTE_RAINBOW 0x00
+#define EFFECT_PALETTE_PARTY 0x01
+#define EFFECT_PALETTE_OCEAN 0x02
+#define EFFECT_PALETTE_FOREST 0x03
+#define EFFECT_PALETTE_LAVA 0x04
+#define EFFECT_PALETTE_HEAT 0x05
+#define EFFECT_PALETTE_CLOUD 0x06
+#define EFFECT_PALETTE_COUNT 0x07
+
+#ifndef EFFECT_FPS
+#define EFFECT_FPS 30             // rendering a noise frame takes ~10 ms and FastLED.show ~8 ms on the Uno
+#endif
+#define EFFECT_NOISE_SCALE 48     // noise coordinates per pixel; 256 is one noise feature
+#define EFFECT_FIRE_COOLING 14    // heat lost per row above the bottom one
+
+struct EffectState {
+  uint8_t effect;
+  uint8_t speed;    // time advance per frame, 0 freezes the effect
+  uint8_t palette;  // EFFECT_PALETTE_*
+  uint8_t seed;     // offsets the pattern, so two panels with the same effect differ
+  uint16_t time;    // advanced by speed every frame, wraps
+};
+
+/**
+ * effectPalette is a function that maps an `EFFECT_PALETTE_*` value to one of FastLED's built-in palettes in program memory.
+ *
+ * **Parameters:**
+ *
+ * - `palette`: A `uint8_t` holding the palette, below `EFFECT_PALETTE_COUNT`.
+ *
+ * **Returns:**
+ *
+ * - `const TProgmemRGBPalette16&`: Returns the palette. `ColorFromPalette` reads it from flash, so no palette is copied to SRAM.
+ */
+const TProgmemRGBPalette16& effectPalette(uint8_t palette) {
+  switch (palette) {
+    case EFFECT_PALETTE_PARTY: return PartyColors_p;
+    case EFFECT_PALETTE_OCEAN: return OceanColors_p;
+    case EFFECT_PALETTE_FOREST: return ForestColors_p;
+    case EFFECT_PALETTE_LAVA: return LavaColors_p;
+    case EFFECT_PALETTE_HEAT: return HeatColors_p;
+    case EFFECT_PALETTE_CLOUD: return CloudColors_p;
+    default: return RainbowColors_p;
+  }
+}
+
+/**
+ * effectColor is a function that renders one pixel of a procedural effect.
+ *
+ * **Parameters:**
+ *
+ * - `state`: A `const EffectState&` holding the effect, its parameters and the current time.
+ * - `row`, `column`: `uint8_t` coordinates of the pixel, row 0 at the top.
+ * - `width`, `height`: `uint8_t` number of columns and rows of the panel.
+ *
+ * **Returns:**
+ *
+ * - `CRGB`: Returns the color of the pixel. `EFFECT_SCROLL` moves existing pixels instead and is not rendered here.
+ *
+ * **Functionality:**
+ *
+ * - Uses FastLED's 8-bit integer helpers (`sin8`, `inoise8`, `qsub8`, `ColorFromPalette`), so a pixel costs a few hundred cycles.
+ * - The 8-bit phase is `time / 16`; at `EFFECT_FPS` a speed of 16 takes about 8 s through the palette.
+ */
+CRGB effectColor(const EffectState& state, uint8_t row, uint8_t column, uint8_t width, uint8_t height) {
+  uint8_t phase = state.time >> 4;
+  uint8_t step = 256 / width;
+  uint8_t rowStep = 256 / height;
+  const TProgmemRGBPalette16& palette = effectPalette(state.palette);
+
+  switch (state.effect) {
+    case EFFECT_GRADIENT:
+      return ColorFromPalette(palette, (uint8_t)((row * rowStep + column * step) / 2 + phase + state.seed));
+
+    case EFFECT_RAINBOW:
+      return CRGB(CHSV((uint8_t)(column * step + phase + state.seed), 255, 255));
+
+    case EFFECT_PLASMA: {
+      uint8_t index = sin8(column * step + phase) + sin8(row * rowStep - phase + state.seed) + sin8((row * rowStep + column * step) / 2 + phase * 2);
+      return ColorFromPalette(palette, index);
+    }
+
+    case EFFECT_FIRE: {
+      uint8_t noise = inoise8(column * EFFECT_NOISE_SCALE + (state.seed << 8), row * EFFECT_NOISE_SCALE + state.time, state.time >> 2);
+      uint8_t above = height - 1 - row;
+      return ColorFromPalette(palette, qsub8(noise, above * EFFECT_FIRE_COOLING));
+    }
+
+    case EFFECT_NOISE:
+      return ColorFromPalette(palette, inoise8(column * EFFECT_NOISE_SCALE, row * EFFECT_NOISE_SCALE, state.time + (state.seed << 8)));
+
+    default:
+      return CRGB::Black;
+  }
+}
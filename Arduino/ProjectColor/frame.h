@@ -0,0 +1,322 @@
+// Frame containers for the panel: 3 bytes per pixel (CRGB) or palette indices, no coordinates per pixel and no heap. They replace
+// the Pixel/PixelRow/Matrix classes, which took 5 bytes per pixel plus String objects and did not fit into the Uno's 2 KB of SRAM.
+// Include after FastLED.h and layout.h.
+#ifndef FRAME_SRAM_BUDGET
+#define FRAME_SRAM_BUDGET 1024    // bytes a single frame may take; leds[] of a 16x16 panel takes 768 of the Uno's 2048
+#endif
+#define STAGED_FRAME_BITS 4       // index bits per pixel of a StagedFrame; index 0 means "unchanged"
+#define STAGED_FRAME_COLORS ((1 << STAGED_FRAME_BITS) - 1)
+
+/**
+ * PixelSpan is a run of consecutive pixels, e.g. one row of a `FrameView`.
+ *
+ * - `pixels`: A `CRGB*` pointing to the first pixel.
+ * - `length`: A `uint16_t` holding the number of pixels.
+ */
+struct PixelSpan {
+  CRGB* pixels;
+  uint16_t length;
+
+  CRGB& operator[](uint16_t i) const {
+    return pixels[i];
+  }
+
+  void fill(const CRGB& color) const {
+    for (uint16_t i = 0; i < length; i++) {
+      pixels[i] = color;
+    }
+  }
+
+  void copyFrom(const CRGB* source) const {
+    memcpy(pixels, source, length * sizeof(CRGB));
+  }
+};
+
+/**
+ * FrameView is a class template that gives row and column access to `Width` x `Height` pixels stored row by row somewhere else, e.g.
+ * in a `Frame`, a buffer of the caller or a received payload.
+ *
+ * **Functionality:**
+ *
+ * - Holds only a pointer; copies of a view refer to the same pixels.
+ * - `row` and `span` return `PixelSpan`s; `fill`, `copyFrom` and `blit` work on the whole frame, `blit` clipped to its edges.
+ */
+template <uint8_t Width, uint8_t Height>
+class FrameView {
+ public:
+  static constexpr uint8_t width = Width;
+  static constexpr uint8_t height = Height;
+  static constexpr uint16_t count = (uint16_t)Width * Height;
+  static constexpr uint16_t bytes = count * sizeof(CRGB);
+
+  explicit FrameView(CRGB* pixels) : pixels_(pixels) {}
+
+  CRGB* data() const {
+    return pixels_;
+  }
+
+  CRGB& operator[](uint16_t position) const {
+    return pixels_[position];
+  }
+
+  CRGB& at(uint8_t row, uint8_t column) const {
+    return pixels_[(uint16_t)row * Width + column];
+  }
+
+  PixelSpan row(uint8_t row) const {
+    PixelSpan span = {pixels_ + (uint16_t)row * Width, Width};
+    return span;
+  }
+
+  PixelSpan span(uint16_t first, uint16_t length) const {
+    PixelSpan span = {pixels_ + first, length};
+    return span;
+  }
+
+  void fill(const CRGB& color) const {
+    span(0, count).fill(color);
+  }
+
+  void copyFrom(const FrameView& source) const {
+    memcpy(pixels_, source.data(), bytes);
+  }
+
+  /**
+   * blit is a function that copies a smaller or larger frame into this one, with its top left pixel at `top`, `left`.
+   *
+   * **Parameters:**
+   *
+   * - `source`: A `FrameView` of any size.
+   * - `top`, `left`: `int16_t` position of the source's top left pixel; negative values and pixels past the edges are clipped.
+   */
+  template <uint8_t SourceWidth, uint8_t SourceHeight>
+  void blit(const FrameView<SourceWidth, SourceHeight>& source, int16_t top, int16_t left) const {
+    int16_t firstColumn = left < 0 ? -left : 0;
+    int16_t lastColumn = SourceWidth < Width - left ? SourceWidth : Width - left;
+    if (firstColumn >= lastColumn) {
+      return;
+    }
+    for (int16_t row = top < 0 ? -top : 0; row < SourceHeight && top + row < Height; row++) {
+      memcpy(&at(top + row, left + firstColumn), &source.at(row, firstColumn), (lastColumn - firstColumn) * sizeof(CRGB));
+    }
+  }
+
+ private:
+  CRGB* pixels_;
+};
+
+/**
+ * Frame is a class template owning the pixels of a `FrameView`, 3 bytes per pixel.
+ *
+ * **Functionality:**
+ *
+ * - A frame larger than `FRAME_SRAM_BUDGET` does not compile. It cannot be copied, since the copy's view would still point to the
+ *   original; use `copyFrom`.
+ */
+template <uint8_t Width, uint8_t Height>
+class Frame : public FrameView<Width, Height> {
+  static_assert(FrameView<Width, Height>::bytes <= FRAME_SRAM_BUDGET, "frame exceeds FRAME_SRAM_BUDGET");
+
+ public:
+  Frame() : FrameView<Width, Height>(storage_) {}
+  Frame(const Frame&) = delete;
+  Frame& operator=(const Frame&) = delete;
+
+ private:
+  CRGB storage_[(uint16_t)Width * Height];
+};
+
+/**
+ * IndexedFrame is a class template holding `Width` x `Height` palette indices of `Bits` bits each (1, 2, 4 or 8), packed like the
+ * payload of `FRAME_TYPE_PIXELS_INDEXED`: the first pixel in the most significant bits of a byte.
+ *
+ * **Functionality:**
+ *
+ * - A 16x16 frame takes 128 bytes with 4-bit indices instead of 768 as `Frame`; the palette is kept by the caller.
+ * - `expandTo` writes the colors into a `FrameView` or `PanelView`.
+ */
+template <uint8_t Width, uint8_t Height, uint8_t Bits>
+class IndexedFrame {
+  static_assert(Bits == 1 || Bits == 2 || Bits == 4 || Bits == 8, "index width must be 1, 2, 4 or 8 bits");
+
+ public:
+  static constexpr uint8_t width = Width;
+  static constexpr uint8_t height = Height;
+  static constexpr uint16_t count = (uint16_t)Width * Height;
+  static constexpr uint16_t bytes = (count * Bits + 7) / 8;
+  static_assert(bytes <= FRAME_SRAM_BUDGET, "indexed frame exceeds FRAME_SRAM_BUDGET");
+
+  uint8_t* data() {
+    return indices_;
+  }
+
+  uint8_t get(uint16_t position) const {
+    return (indices_[position / PER_BYTE] >> shift(position)) & MASK;
+  }
+
+  void set(uint16_t position, uint8_t index) {
+    uint8_t& packed = indices_[position / PER_BYTE];
+    packed = (packed & ~(MASK << shift(position))) | ((index & MASK) << shift(position));
+  }
+
+  void fill(uint8_t index) {
+    uint8_t pattern = index & MASK;
+    for (uint8_t bits = Bits; bits < 8; bits *= 2) {
+      pattern |= pattern << bits;
+    }
+    memset(indices_, pattern, bytes);
+  }
+
+  template <typename View>
+  void expandTo(const View& target, const CRGB* palette) const {
+    for (uint16_t position = 0; position < count; position++) {
+      target[position] = palette[get(position)];
+    }
+  }
+
+ private:
+  static constexpr uint8_t PER_BYTE = 8 / Bits;
+  static constexpr uint8_t MASK = (uint8_t)((1 << Bits) - 1);
+
+  static uint8_t shift(uint16_t position) {
+    return (PER_BYTE - 1 - position % PER_BYTE) * Bits;
+  }
+
+  uint8_t indices_[bytes];
+};
+
+/**
+ * StagedFrame is a class template holding the pixels of a frame being received, the back buffer to the front buffer `leds[]`: the
+ * shown frame stays in `leds[]` until the new one is complete and `applyTo` copies it over.
+ *
+ * **Functionality:**
+ *
+ * - Holds a `STAGED_FRAME_BITS` index per pixel and up to `STAGED_FRAME_COLORS` colors, 128 + 45 bytes for a 16x16 panel where a
+ *   second `Frame` would take 768. Index 0 marks a pixel the new frame leaves as it is, so a delta stages only what it changes.
+ * - `stage` fails for a color beyond the first `STAGED_FRAME_COLORS` of the frame; the caller then applies what is staged and writes
+ *   the rest of the frame directly.
+ * - `get` reads a staged pixel back, e.g. as the source of an LZ match.
+ */
+template <uint8_t Width, uint8_t Height>
+class StagedFrame {
+ public:
+  static constexpr uint16_t count = (uint16_t)Width * Height;
+
+  StagedFrame() : used_(0) {
+    indices_.fill(0);
+  }
+
+  bool empty() const {
+    return used_ == 0;
+  }
+
+  void clear() {
+    if (used_ > 0) {
+      indices_.fill(0);
+      used_ = 0;
+    }
+  }
+
+  bool stage(uint16_t position, const CRGB& color) {
+    uint8_t index = 0;
+    while (index < used_ && colors_[index] != color) {
+      index++;
+    }
+    if (index == used_) {
+      if (used_ == STAGED_FRAME_COLORS) {
+        return false;
+      }
+      colors_[used_++] = color;
+    }
+    indices_.set(position, index + 1);
+    return true;
+  }
+
+  bool get(uint16_t position, CRGB& color) const {
+    uint8_t index = indices_.get(position);
+    if (index == 0) {
+      return false;
+    }
+    color = colors_[index - 1];
+    return true;
+  }
+
+  /**
+   * applyTo is a function that writes the staged pixels into a `FrameView` or `PanelView` and empties the buffer.
+   *
+   * **Parameters:**
+   *
+   * - `target`: The view holding the shown frame; pixels with index 0 are not touched.
+   */
+  template <typename View>
+  void applyTo(const View& target) {
+    if (used_ == 0) {
+      return;
+    }
+    for (uint16_t position = 0; position < count; position++) {
+      uint8_t index = indices_.get(position);
+      if (index != 0) {
+        target[position] = colors_[index - 1];
+      }
+    }
+    clear();
+  }
+
+ private:
+  IndexedFrame<Width, Height, STAGED_FRAME_BITS> indices_;
+  CRGB colors_[STAGED_FRAME_COLORS];
+  uint8_t used_;
+};
+
+/**
+ * PanelView is a class template that aliases the LED strip (`leds[]`) as a frame of the panel described by a `PanelLayout`.
+ *
+ * **Functionality:**
+ *
+ * - Positions are `row * width + column`, as in a `FrameView`; every access goes through the flash table of `LayoutTable`, so a
+ *   `Frame` drawn row by row can be copied onto the panel with `copyFrom` or `blit` regardless of the wiring.
+ * - `fill` ignores the order and writes the strip directly.
+ */
+template <typename Layout>
+class PanelView {
+ public:
+  static constexpr uint8_t width = Layout::width;
+  static constexpr uint8_t height = Layout::height;
+  static constexpr uint16_t count = Layout::count;
+  static constexpr uint16_t bytes = count * sizeof(CRGB);
+  static_assert(bytes <= FRAME_SRAM_BUDGET, "panel exceeds FRAME_SRAM_BUDGET");
+
+  explicit PanelView(CRGB* leds) : leds_(leds) {}
+
+  CRGB& operator[](uint16_t position) const {
+    return leds_[pgm_read_byte(&LayoutTable<Layout>::leds[position])];
+  }
+
+  CRGB& at(uint8_t row, uint8_t column) const {
+    return (*this)[(uint16_t)row * Layout::width + column];
+  }
+
+  void fill(const CRGB& color) const {
+    for (uint16_t i = 0; i < count; i++) {
+      leds_[i] = color;
+    }
+  }
+
+  void copyFrom(const FrameView<Layout::width, Layout::height>& source) const {
+    for (uint16_t position = 0; position < count; position++) {
+      (*this)[position] = source[position];
+    }
+  }
+
+  template <uint8_t SourceWidth, uint8_t SourceHeight>
+  void blit(const FrameView<SourceWidth, SourceHeight>& source, int16_t top, int16_t left) const {
+    for (int16_t row = top < 0 ? -top : 0; row < SourceHeight && top + row < Layout::height; row++) {
+      for (int16_t column = left < 0 ? -left : 0; column < SourceWidth && left + column < Layout::width; column++) {
+        at(top + row, left + column) = source.at(row, column);
+      }
+    }
+  }
+
+ private:
+  CRGB* leds_;
+};
@@ -0,0 +1,357 @@
+#include <EEPROM.h>
+
+// Frame cache: recurring frames kept on the device under a CRC-16 of their pixels, so the app shows a frame the device already holds
+// with "cache-show:<hash>" instead of a transfer. The storage starts with a directory (magic + FRAME_CACHE_SLOTS slots of 2Bytes hash,
+// 2Bytes offset, 2Bytes length, all big-endian; length 0 is a free slot), followed by the frames as RLE runs of 1Byte count (1..255) +
+// 3Bytes(R,G,B) in position order. On the Uno it sits in the EEPROM between the animation storage and the tile offset.
+#ifndef FRAME_CACHE_SIZE
+#define FRAME_CACHE_SIZE 384      // bytes taken from the animation storage; 0 turns the cache off
+#endif
+#define FRAME_CACHE_SLOTS 8
+#define FRAME_CACHE_SLOT_SIZE 6
+#define FRAME_CACHE_DIRECTORY_SIZE (1 + FRAME_CACHE_SLOTS * FRAME_CACHE_SLOT_SIZE)
+#define FRAME_CACHE_MAGIC 0xC5
+#define FRAME_CACHE_RUN_SIZE 4
+#define FRAME_CACHE_ADDRESS (E2END + 1 - TILE_CONFIG_SIZE - FRAME_CACHE_SIZE)
+#ifdef FRAME_CACHE_EXTERNAL
+#define FRAME_CACHE_EEPROM_SIZE 0 // EEPROM bytes the cache takes from the animation storage, see animation.h
+#else
+#define FRAME_CACHE_EEPROM_SIZE FRAME_CACHE_SIZE
+#endif
+#if FRAME_CACHE_SIZE > 0
+#define FRAME_CACHE_CAPS PROTO_CAP_CACHE  // offered in PROTO_CAPS_SUPPORTED
+#else
+#define FRAME_CACHE_CAPS 0
+#endif
+
+#if FRAME_CACHE_SIZE > 0
+static_assert(FRAME_CACHE_SIZE > FRAME_CACHE_DIRECTORY_SIZE + FRAME_CACHE_RUN_SIZE, "FRAME_CACHE_SIZE leaves no room for a frame");
+
+uint16_t frameCacheUsed[FRAME_CACHE_SLOTS];  // LRU stamps per slot, in SRAM only; after a reset all entries are equally old
+uint16_t frameCacheClock = 0;
+
+// The storage backend is these two functions, like animStorageRead and animStorageWrite. Define FRAME_CACHE_EXTERNAL and provide
+// both to keep the cache on an external chip; FRAME_CACHE_SIZE may then exceed the EEPROM and FRAME_CACHE_ADDRESS is not used.
+#ifndef FRAME_CACHE_EXTERNAL
+/**
+ * cacheStorageRead is a function that reads one byte of the frame cache storage.
+ *
+ * **Parameters:**
+ *
+ * - `address`: A `uint16_t` offset below `FRAME_CACHE_SIZE`.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the stored byte.
+ */
+uint8_t cacheStorageRead(uint16_t address) {
+  return EEPROM.read(FRAME_CACHE_ADDRESS + address);
+}
+
+/**
+ * cacheStorageWrite is a function that writes one byte of the frame cache storage, skipping unchanged bytes like `animStorageWrite`.
+ *
+ * **Parameters:**
+ *
+ * - `address`: A `uint16_t` offset below `FRAME_CACHE_SIZE`.
+ * - `value`: A `uint8_t` holding the byte to store.
+ */
+void cacheStorageWrite(uint16_t address, uint8_t value) {
+  EEPROM.update(FRAME_CACHE_ADDRESS + address, value);
+}
+#endif
+
+uint16_t frameCacheWord(uint16_t address) {
+  return ((uint16_t)cacheStorageRead(address) << 8) | cacheStorageRead(address + 1);
+}
+
+void frameCacheSetWord(uint16_t address, uint16_t value) {
+  cacheStorageWrite(address, value >> 8);
+  cacheStorageWrite(address + 1, value & 0xFF);
+}
+
+uint16_t frameCacheSlotAddress(uint8_t slot) {
+  return 1 + slot * FRAME_CACHE_SLOT_SIZE;
+}
+
+uint16_t frameCacheLength(uint8_t slot) {
+  return frameCacheWord(frameCacheSlotAddress(slot) + 4);
+}
+
+uint16_t frameCacheOffset(uint8_t slot) {
+  return frameCacheWord(frameCacheSlotAddress(slot) + 2);
+}
+
+uint16_t frameCacheHashOf(uint8_t slot) {
+  return frameCacheWord(frameCacheSlotAddress(slot));
+}
+
+/**
+ * frameCacheFree is a function that marks a slot as free; its frame bytes become a gap for the next `frameCacheStore`.
+ */
+void frameCacheFree(uint8_t slot) {
+  frameCacheSetWord(frameCacheSlotAddress(slot) + 4, 0);
+}
+
+/**
+ * frameCacheBegin is a function that checks the directory after reset and empties a storage that holds no cache yet, e.g. a new
+ * chip or an EEPROM last used by a larger animation storage.
+ *
+ * **Functionality:**
+ *
+ * - A slot whose frame does not lie within the storage is freed, so a damaged directory never sends a read past the cache.
+ */
+void frameCacheBegin() {
+  if (cacheStorageRead(0) != FRAME_CACHE_MAGIC) {
+    for (uint8_t slot = 0; slot < FRAME_CACHE_SLOTS; slot++) {
+      frameCacheFree(slot);
+    }
+    cacheStorageWrite(0, FRAME_CACHE_MAGIC);
+  }
+  for (uint8_t slot = 0; slot < FRAME_CACHE_SLOTS; slot++) {
+    uint16_t length = frameCacheLength(slot);
+    uint16_t offset = frameCacheOffset(slot);
+    if (length != 0 && (length % FRAME_CACHE_RUN_SIZE != 0 || offset < FRAME_CACHE_DIRECTORY_SIZE || offset > FRAME_CACHE_SIZE ||
+                        length > FRAME_CACHE_SIZE - offset)) {
+      frameCacheFree(slot);
+    }
+    frameCacheUsed[slot] = 0;
+  }
+}
+
+/**
+ * frameCacheFind is a function that looks up a frame by its hash.
+ *
+ * **Parameters:**
+ *
+ * - `hash`: A `uint16_t` holding the CRC-16 of the frame, see `frameCacheHash`.
+ *
+ * **Returns:**
+ *
+ * - `int8_t`: Returns the slot holding the frame, or -1.
+ */
+int8_t frameCacheFind(uint16_t hash) {
+  for (uint8_t slot = 0; slot < FRAME_CACHE_SLOTS; slot++) {
+    if (frameCacheLength(slot) != 0 && frameCacheHashOf(slot) == hash) {
+      return slot;
+    }
+  }
+  return -1;
+}
+
+/**
+ * frameCacheHash is a function template that computes the key of a frame: the CRC-16/CCITT-FALSE over R, G, B of every pixel in
+ * position order, as `frameHash` in the app does.
+ *
+ * **Parameters:**
+ *
+ * - `frame`: A `FrameView` or `PanelView`.
+ *
+ * **Returns:**
+ *
+ * - `uint16_t`: Returns the hash.
+ */
+template <typename View>
+uint16_t frameCacheHash(const View& frame) {
+  uint16_t crc = 0xFFFF;
+  for (uint16_t position = 0; position < View::count; position++) {
+    const CRGB& color = frame[position];
+    uint8_t rgb[3] = {color.r, color.g, color.b};
+    crc = crc16Update(crc, rgb, 3);
+  }
+  return crc;
+}
+
+/**
+ * frameCacheGap is a function that finds the first free stretch of the storage that holds `length` bytes.
+ *
+ * **Parameters:**
+ *
+ * - `length`: A `uint16_t` holding the bytes needed.
+ *
+ * **Returns:**
+ *
+ * - `uint16_t`: Returns the offset of the stretch, or 0 if there is none.
+ *
+ * **Functionality:**
+ *
+ * - Frames are not moved to close gaps, since every EEPROM byte written costs 3.3 ms; a frame is placed in the first gap it fits.
+ */
+uint16_t frameCacheGap(uint16_t length) {
+  uint16_t start = FRAME_CACHE_DIRECTORY_SIZE;
+  while (start + length <= FRAME_CACHE_SIZE) {
+    uint16_t blockedUntil = start;
+    for (uint8_t slot = 0; slot < FRAME_CACHE_SLOTS; slot++) {
+      uint16_t slotLength = frameCacheLength(slot);
+      uint16_t offset = frameCacheOffset(slot);
+      if (slotLength != 0 && offset < start + length && offset + slotLength > blockedUntil) {
+        blockedUntil = offset + slotLength;
+      }
+    }
+    if (blockedUntil == start) {
+      return start;
+    }
+    start = blockedUntil;
+  }
+  return 0;
+}
+
+/**
+ * frameCacheStore is a function template that stores a frame under its hash, evicting the least recently used frames until it fits.
+ *
+ * **Parameters:**
+ *
+ * - `hash`: A `uint16_t` holding the hash the app computed; it must match `frameCacheHash` of the frame.
+ * - `frame`: A `FrameView` or `PanelView` holding the frame.
+ *
+ * **Returns:**
+ *
+ * - `int8_t`: Returns the slot, or -1 if the hash does not match or the frame takes more RLE runs than the whole storage holds.
+ *
+ * **Functionality:**
+ *
+ * - The runs are written first and the slot's length last, so a reset in between leaves a free slot, never a half-written frame.
+ * - A frame stored before under the same hash is replaced.
+ */
+template <typename View>
+int8_t frameCacheStore(uint16_t hash, const View& frame) {
+  if (frameCacheHash(frame) != hash) {
+    return -1;
+  }
+  uint16_t length = 0;
+  for (uint16_t position = 0; position < View::count; length += FRAME_CACHE_RUN_SIZE) {
+    uint16_t end = position + 1;
+    while (end < View::count && end - position < 255 && frame[end] == frame[position]) {
+      end++;
+    }
+    position = end;
+  }
+  if (length > FRAME_CACHE_SIZE - FRAME_CACHE_DIRECTORY_SIZE) {
+    return -1;
+  }
+
+  int8_t previous = frameCacheFind(hash);
+  if (previous >= 0) {
+    frameCacheFree(previous);
+  }
+  int8_t slot;
+  uint16_t offset;
+  for (;;) {
+    slot = -1;
+    int8_t oldest = -1;
+    for (uint8_t i = 0; i < FRAME_CACHE_SLOTS; i++) {
+      if (frameCacheLength(i) == 0) {
+        slot = slot < 0 ? i : slot;
+      } else if (oldest < 0 || frameCacheUsed[i] < frameCacheUsed[oldest]) {
+        oldest = i;
+      }
+    }
+    offset = slot >= 0 ? frameCacheGap(length) : 0;
+    if (offset != 0) {
+      break;
+    }
+    frameCacheFree(oldest);  // oldest exists: with no frame stored, the whole storage is one gap large enough
+  }
+
+  uint16_t address = offset;
+  for (uint16_t position = 0; position < View::count; address += FRAME_CACHE_RUN_SIZE) {
+    uint16_t end = position + 1;
+    while (end < View::count && end - position < 255 && frame[end] == frame[position]) {
+      end++;
+    }
+    const CRGB& color = frame[position];
+    cacheStorageWrite(address, end - position);
+    cacheStorageWrite(address + 1, color.r);
+    cacheStorageWrite(address + 2, color.g);
+    cacheStorageWrite(address + 3, color.b);
+    position = end;
+  }
+  uint16_t slotAddress = frameCacheSlotAddress(slot);
+  frameCacheSetWord(slotAddress, hash);
+  frameCacheSetWord(slotAddress + 2, offset);
+  frameCacheSetWord(slotAddress + 4, length);
+  frameCacheUsed[slot] = ++frameCacheClock;
+  return slot;
+}
+
+/**
+ * frameCacheLoad is a function template that writes a cached frame into a view.
+ *
+ * **Parameters:**
+ *
+ * - `slot`: A `uint8_t` holding the slot returned by `frameCacheFind`.
+ * - `frame`: A `FrameView` or `PanelView` to write to.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if the frame was written. A frame whose runs do not cover the view exactly or whose pixels do not match the
+ *   slot's hash is freed and `frame` stays untouched.
+ *
+ * **Functionality:**
+ *
+ * - The runs are read twice: once to check them against the hash, then to write the pixels. Reading the EEPROM costs no more than
+ *   a second buffer, which does not fit into SRAM.
+ */
+template <typename View>
+bool frameCacheLoad(uint8_t slot, const View& frame) {
+  uint16_t offset = frameCacheOffset(slot);
+  uint16_t end = offset + frameCacheLength(slot);
+  uint16_t crc = 0xFFFF;
+  uint16_t pixels = 0;
+  for (uint16_t address = offset; address < end; address += FRAME_CACHE_RUN_SIZE) {
+    uint8_t count = cacheStorageRead(address);
+    uint8_t rgb[3] = {cacheStorageRead(address + 1), cacheStorageRead(address + 2), cacheStorageRead(address + 3)};
+    for (uint8_t i = 0; i < count; i++) {
+      crc = crc16Update(crc, rgb, 3);
+    }
+    pixels += count;
+  }
+  if (pixels != View::count || crc != frameCacheHashOf(slot)) {
+    frameCacheFree(slot);
+    return false;
+  }
+
+  uint16_t position = 0;
+  for (uint16_t address = offset; address < end; address += FRAME_CACHE_RUN_SIZE) {
+    uint8_t count = cacheStorageRead(address);
+    CRGB color(cacheStorageRead(address + 1), cacheStorageRead(address + 2), cacheStorageRead(address + 3));
+    for (uint8_t i = 0; i < count; i++) {
+      frame[position++] = color;
+    }
+  }
+  frameCacheUsed[slot] = ++frameCacheClock;
+  return true;
+}
+
+/**
+ * frameCacheReport is a function that sends the contents of the cache as `cache:<free bytes>:<hash>:<hash>...`, all in hex, most
+ * recently used first, so the app can align its mirror with the device.
+ *
+ * **Parameters:**
+ *
+ * - `send`: A `ReplySender` that sends the line, normally `sendReply`.
+ */
+void frameCacheReport(ReplySender send) {
+  uint16_t unused = FRAME_CACHE_SIZE - FRAME_CACHE_DIRECTORY_SIZE;
+  for (uint8_t slot = 0; slot < FRAME_CACHE_SLOTS; slot++) {
+    unused -= frameCacheLength(slot);
+  }
+  char line[6 + 4 + FRAME_CACHE_SLOTS * 5 + 1];  // "cache:", the free bytes and ":<hash>" per slot
+  uint8_t length = snprintf_P(line, sizeof(line), PSTR("cache:%x"), unused);
+  bool listed[FRAME_CACHE_SLOTS] = {false};
+  for (;;) {
+    int8_t newest = -1;
+    for (uint8_t slot = 0; slot < FRAME_CACHE_SLOTS; slot++) {
+      if (!listed[slot] && frameCacheLength(slot) != 0 && (newest < 0 || frameCacheUsed[slot] > frameCacheUsed[newest])) {
+        newest = slot;
+      }
+    }
+    if (newest < 0) {
+      break;
+    }
+    listed[newest] = true;
+    length += snprintf_P(line + length, sizeof(line) - length, PSTR(":%04x"), frameCacheHashOf(newest));
+  }
+  send(line);
+}
+#endif
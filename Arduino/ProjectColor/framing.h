@@ -0,0 +1,203 @@
+#define FRAME_DELIMITER 0x00      // Sync byte: opens and closes every binary frame, never appears inside a COBS-encoded body
+#define FRAME_HEADER_SIZE 2       // 1Byte frame type + 1Byte payload length
+#define FRAME_CRC_SIZE 1          // 1Byte CRC-8 over header and payload
+#define FRAME_FEC_SIZE 2          // with PROTO_CAP_FEC: 2_bytes(P,Q) after the CRC, repairing one corrupted byte of the frame
+#define FRAME_MAX_PAYLOAD 65      //1Byte sequence + 16_PIXEL * 4_bytes(position,R,G,B)
+#define FRAME_MAX_DECODED_SIZE (FRAME_HEADER_SIZE + FRAME_MAX_PAYLOAD + FRAME_CRC_SIZE + FRAME_FEC_SIZE)
+#define FRAME_MAX_ENCODED_SIZE (FRAME_MAX_DECODED_SIZE + 1)  // COBS adds 1Byte per 254Bytes of data
+
+#define FRAME_TYPE_PIXELS 0x01    // payload: N * 4_bytes(position,R,G,B), position = (row << 4) + column
+#define FRAME_TYPE_PIXELS_SEQ 0x02 // payload: 1Byte sequence number + N * 4_bytes(position,R,G,B)
+#define FRAME_TYPE_PIXELS_DELTA 0x03 // payload: 1Byte base generation + spans of 2_bytes(position,count) + count * 3_bytes(R,G,B)
+#define FRAME_TYPE_PALETTE 0x04   // payload: 1Byte index of the first entry + N * 3_bytes(R,G,B)
+#define FRAME_TYPE_PIXELS_INDEXED 0x05 // payload: 3_bytes(position,bits per index,count) + count packed 4- or 8-bit palette indices
+#define FRAME_TYPE_PIXELS_COMPRESSED 0x06 // payload: 2_bytes(position,codec) + whole codec tokens
+#define FRAME_TYPE_PIXELS_PACKED 0x07 // payload: 3_bytes(position,color depth,count) + count colors packed in that depth
+#define FRAME_TYPE_ANIMATION_DATA 0x08 // payload: 2_bytes(storage offset) + bytes of a stored animation, see animation.h
+#define FRAME_TYPE_STREAM 0x09    // payload: 1Byte frame sequence + 1Byte chunk index + 16 * 3_bytes(R,G,B), see stream.h; never answered
+#define FRAME_TYPE_LAST FRAME_TYPE_STREAM  // highest frame type; perfstats.h keeps one slot per type up to it
+
+#define PROTO_CAP_BINARY_FRAMES 0x01
+#define PROTO_CAP_WINDOW 0x02     // sequenced frames, up to SEQ_WINDOW_SIZE in flight, cumulative ROW-ACK:<next seq>
+#define PROTO_CAP_DELTA 0x04      // delta frames against the last committed frame, committed with fin:<generation>
+#define PROTO_CAP_PALETTE 0x08    // palette upload + frames of palette indices
+#define PROTO_CAP_COMPRESSED 0x10 // RLE and LZ compressed pixel frames
+#define PROTO_CAP_COLOR_DEPTH 0x20 // pixel frames in RGB565 / RGB444 / RGB332
+#define PROTO_CAP_LINK_SPEED 0x40 // baud:<rates> negotiation, see transport.h
+#define PROTO_CAP_FLOW_CONTROL 0x80 // "busy" / "ready" lines around display refreshes
+#define PROTO_CAP_FEC 0x100       // every binary frame carries FRAME_FEC_SIZE check bytes, see fecRepair; older firmware reads only the low byte
+#define PROTO_CAP_STREAM 0x200    // unacknowledged FRAME_TYPE_STREAM frames until stream-stop, see stream.h
+#define PROTO_CAP_CACHE 0x400     // cache-show / cache-put / cache-list of recurring frames, see framecache.h
+#define PROTO_CAP_TAGGED_REPLIES 0x800 // applied frames are confirmed with ROW-SUCCESS:<CRC-8 of the frame>, see sendRowSuccess
+#define PROTO_CAPS_BINARY_ONLY (PROTO_CAP_WINDOW | PROTO_CAP_DELTA | PROTO_CAP_PALETTE | PROTO_CAP_COMPRESSED | PROTO_CAP_COLOR_DEPTH | PROTO_CAP_FEC | \
+                                PROTO_CAP_STREAM | PROTO_CAP_TAGGED_REPLIES)  // capabilities that need PROTO_CAP_BINARY_FRAMES
+#define PROTO_CAPS_SUPPORTED (PROTO_CAP_BINARY_FRAMES | PROTO_CAPS_BINARY_ONLY | LINK_SPEED_CAPS | PROTO_CAP_FLOW_CONTROL | \
+                              FRAME_CACHE_CAPS)
+
+#define DELTA_SPAN_HEADER_SIZE 2  // 1Byte position of the first pixel + 1Byte number of pixels in the span
+#define GENERATION_UNKNOWN 0      // leds[] holds content the app cannot reproduce, deltas are rejected
+
+#define PALETTE_MAX_SIZE 32       // 32 * 3Bytes of SRAM; a 256-entry palette (768Bytes) would not fit next to leds[] on the Uno
+#define INDEXED_HEADER_SIZE 3     // 1Byte position of the first pixel + 1Byte bits per index + 1Byte pixel count
+
+#define COMPRESSED_HEADER_SIZE 2  // 1Byte position of the first pixel + 1Byte codec
+#define CODEC_RLE 0x01            // tokens: 1Byte run length (1..255) + 3_bytes(R,G,B)
+#define CODEC_LZ 0x02             // tokens: 0x00..0x7F = (n + 1) literal pixels of 3_bytes(R,G,B); 0x80..0xFF = copy (n - 0x7F) pixels from 1Byte distance back
+#define LZ_LITERAL_FLAG 0x80      // LZ control bytes below this value start a literal run, the others a match
+
+#define SEQ_WINDOW_SIZE 16        // frames the app may send before it has to wait for an acknowledgment
+#define SEQ_ACK_IDLE_MILLIS 4     // line idle time (~4 byte times at 9600 baud) before a deferred ROW-ACK/ROW-FAIL is sent
+
+#define FEC_POLYNOMIAL 0x1D       // x^8 + x^4 + x^3 + x^2 + 1 without x^8, the field of Reed-Solomon codes; x (2) has order 255 in it
+#define FEC_CLEAN 0               // fecRepair results
+#define FEC_REPAIRED 1
+#define FEC_UNCORRECTABLE 2
+
+typedef void (*ReplySender)(const char* reply); // sends one reply line held in SRAM, ended with a newline; the sketch passes sendReply
+
+/**
+ * cobsDecode is a function that reverses Consistent Overhead Byte Stuffing on a frame body received between two `FRAME_DELIMITER` bytes.
+ *
+ * **Parameters:**
+ *
+ * - `input`: A `const uint8_t*` pointing to the COBS-encoded bytes, without the surrounding delimiters.
+ * - `length`: A `uint8_t` specifying the number of encoded bytes in `input`.
+ * - `output`: A `uint8_t*` where the decoded bytes are written. It may point to the same buffer as `input`, since decoding never writes ahead of reading.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the number of decoded bytes, or `0` if the input is not a valid COBS sequence.
+ *
+ * **Functionality:**
+ *
+ * - Each block starts with a code byte holding the distance to the next zero; the `code - 1` bytes that follow are copied unchanged.
+ * - A zero is restored after every block except the last one and except blocks with the maximum code `0xFF`.
+ * - A zero code byte or a block running past the end of the input marks the frame as corrupt.
+ */
+uint8_t cobsDecode(const uint8_t* input, uint8_t length, uint8_t* output) {
+    uint8_t readIndex = 0;
+    uint8_t writeIndex = 0;
+
+    while (readIndex < length) {
+        uint8_t code = input[readIndex];
+        if (code == 0 || (uint16_t)readIndex + code > length) {
+            return 0;
+        }
+        readIndex++;
+
+        for (uint8_t i = 1; i < code; i++) {
+            output[writeIndex++] = input[readIndex++];
+        }
+
+        if (code != 0xFF && readIndex < length) {
+            output[writeIndex++] = 0;
+        }
+    }
+    return writeIndex;
+}
+
+/**
+ * frameIsValid is a function that checks the structure and the CRC of a decoded binary frame.
+ *
+ * **Parameters:**
+ *
+ * - `frame`: A `const uint8_t*` pointing to the decoded frame (type, length, payload, CRC).
+ * - `length`: A `uint8_t` specifying the number of decoded bytes.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if the declared payload length matches the frame size and the CRC-8 over header and payload matches the trailing byte.
+ */
+bool frameIsValid(const uint8_t* frame, uint8_t length) {
+    if (length < FRAME_HEADER_SIZE + FRAME_CRC_SIZE) {
+        return false;
+    }
+    if (frame[1] != length - FRAME_HEADER_SIZE - FRAME_CRC_SIZE) {
+        return false;
+    }
+    return crc8(frame, length - FRAME_CRC_SIZE) == frame[length - FRAME_CRC_SIZE];
+}
+
+/**
+ * fecTimesX is a function that multiplies a value by x (2) in GF(256), the field of the `FRAME_FEC_SIZE` check bytes.
+ *
+ * **Parameters:**
+ *
+ * - `value`: A `uint8_t` holding the field element.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns `value * x`, reduced by `FEC_POLYNOMIAL`.
+ */
+uint8_t fecTimesX(uint8_t value) {
+    return (value << 1) ^ ((value & 0x80) ? FEC_POLYNOMIAL : 0);
+}
+
+/**
+ * fecCheckBytes is a function that computes the two check bytes the app appends to a frame with `PROTO_CAP_FEC`.
+ *
+ * **Parameters:**
+ *
+ * - `data`: A `const uint8_t*` pointing to the decoded frame (type, length, payload, CRC).
+ * - `length`: A `uint8_t` specifying the number of bytes in `data`.
+ * - `p`, `q`: `uint8_t&` receiving the check bytes.
+ *
+ * **Functionality:**
+ *
+ * - `p` is the XOR of all bytes and `q` the sum of `data[i] * x^i` in GF(256), evaluated from the last byte down (Horner), one shift
+ *   and at most one XOR per byte. Together they form a Reed-Solomon style code that corrects one byte per frame.
+ */
+void fecCheckBytes(const uint8_t* data, uint8_t length, uint8_t& p, uint8_t& q) {
+    p = 0;
+    q = 0;
+    for (uint8_t i = length; i > 0; i--) {
+        p ^= data[i - 1];
+        q = fecTimesX(q) ^ data[i - 1];
+    }
+}
+
+/**
+ * fecRepair is a function that verifies the check bytes of a decoded frame and repairs a single corrupted byte in place.
+ *
+ * **Parameters:**
+ *
+ * - `frame`: A `uint8_t*` pointing to the decoded frame, followed by its `FRAME_FEC_SIZE` check bytes.
+ * - `length`: A `uint8_t` specifying the number of decoded bytes, check bytes included.
+ * - `position`: A `uint8_t&` receiving the index of the repaired byte.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns `FEC_CLEAN`, `FEC_REPAIRED` or `FEC_UNCORRECTABLE`.
+ *
+ * **Functionality:**
+ *
+ * - The syndromes `sp` and `sq` are the received check bytes XOR the recomputed ones. A byte `i` corrupted by `e` gives `sp = e` and
+ *   `sq = e * x^i`, so `i` is found by multiplying `e` by x until it equals `sq`. x has order 255, so the position is unique in a frame.
+ * - If only one syndrome is set, a check byte itself was hit and the frame is used as received.
+ * - More than one corrupted byte either finds no position or a wrong one; the CRC-8 checked afterwards by `frameIsValid` rejects
+ *   both. Corruption of a COBS code byte, or of a byte into `FRAME_DELIMITER`, moves the bytes of the frame and cannot be repaired.
+ */
+uint8_t fecRepair(uint8_t* frame, uint8_t length, uint8_t& position) {
+    if (length <= FRAME_FEC_SIZE) {
+        return FEC_UNCORRECTABLE;
+    }
+    uint8_t dataLength = length - FRAME_FEC_SIZE;
+    uint8_t p;
+    uint8_t q;
+    fecCheckBytes(frame, dataLength, p, q);
+    uint8_t sp = p ^ frame[dataLength];
+    uint8_t sq = q ^ frame[dataLength + 1];
+    if (sp == 0 || sq == 0) {
+        return FEC_CLEAN;
+    }
+
+    uint8_t syndrome = sp;
+    for (position = 0; position < dataLength; position++) {
+        if (syndrome == sq) {
+            frame[position] ^= sp;
+            return FEC_REPAIRED;
+        }
+        syndrome = fecTimesX(syndrome);
+    }
+    return FEC_UNCORRECTABLE;
+}
@@ -0,0 +1,129 @@
+// Geometry of the LED panel, fixed at compile time. The app addresses pixels by position `row * MATRIX_WIDTH + column`, row 0 at the
+// top; PanelLayout maps that position to the LED on the strip and LayoutTable holds the mapping for every position in flash.
+#define LAYOUT_PROGRESSIVE 0        // every strip row runs in the same direction
+#define LAYOUT_SERPENTINE 1         // strip rows alternate direction (zigzag)
+
+#define LAYOUT_ROTATE_0 0           // quarter turns clockwise of the picture on the panel
+#define LAYOUT_ROTATE_90 1
+#define LAYOUT_ROTATE_180 2
+#define LAYOUT_ROTATE_270 3
+
+#define LAYOUT_ORIGIN_RIGHT 0x01    // corner of the first LED, seen from the front after rotation
+#define LAYOUT_ORIGIN_BOTTOM 0x02
+#define LAYOUT_ORIGIN_TOP_LEFT 0x00
+#define LAYOUT_ORIGIN_TOP_RIGHT LAYOUT_ORIGIN_RIGHT
+#define LAYOUT_ORIGIN_BOTTOM_LEFT LAYOUT_ORIGIN_BOTTOM
+#define LAYOUT_ORIGIN_BOTTOM_RIGHT (LAYOUT_ORIGIN_BOTTOM | LAYOUT_ORIGIN_RIGHT)
+
+// The 16x16 panel: serpentine, first LED top right. A panel wired in columns, like most 8x32 panels, is a row-wired panel rotated by
+// 90 or 270 degrees, e.g. -DMATRIX_WIDTH=32 -DMATRIX_HEIGHT=8 -DMATRIX_ROTATION=LAYOUT_ROTATE_90 for an 8x32 panel mounted sideways.
+#ifndef MATRIX_WIDTH
+#define MATRIX_WIDTH 16
+#endif
+#ifndef MATRIX_HEIGHT
+#define MATRIX_HEIGHT 16
+#endif
+#ifndef MATRIX_WIRING
+#define MATRIX_WIRING LAYOUT_SERPENTINE
+#endif
+#ifndef MATRIX_ROTATION
+#define MATRIX_ROTATION LAYOUT_ROTATE_0
+#endif
+#ifndef MATRIX_ORIGIN
+#define MATRIX_ORIGIN LAYOUT_ORIGIN_TOP_RIGHT
+#endif
+
+/**
+ * PanelLayout is a class template describing how the pixels of a `Width` x `Height` picture are wired on a panel.
+ *
+ * **Template parameters:**
+ *
+ * - `Width`, `Height`: `uint8_t` columns and rows of the picture, as the app draws it.
+ * - `Wiring`: `LAYOUT_PROGRESSIVE` or `LAYOUT_SERPENTINE`.
+ * - `Rotation`: One of the `LAYOUT_ROTATE_*` values; with 90 and 270 degrees the strip rows run along the picture's columns.
+ * - `Origin`: One of the `LAYOUT_ORIGIN_*` corners, where the strip starts.
+ *
+ * **Functionality:**
+ *
+ * - All members are `constexpr` (C++11, single expressions), so `index` can fill a table at compile time; nothing of the layout is
+ *   computed on the device.
+ */
+template <uint8_t Width, uint8_t Height, uint8_t Wiring, uint8_t Rotation, uint8_t Origin>
+struct PanelLayout {
+  static constexpr uint8_t width = Width;
+  static constexpr uint8_t height = Height;
+  static constexpr uint16_t count = (uint16_t)Width * Height;
+  static constexpr uint8_t stripWidth = (Rotation & 1) ? Height : Width;    // LEDs per strip row
+  static constexpr uint8_t stripHeight = (Rotation & 1) ? Width : Height;
+
+  // Row and column on the panel after rotating the picture.
+  static constexpr uint8_t rotatedRow(uint8_t row, uint8_t column) {
+    return Rotation == LAYOUT_ROTATE_0 ? row : Rotation == LAYOUT_ROTATE_90 ? column :
+           Rotation == LAYOUT_ROTATE_180 ? Height - 1 - row : Width - 1 - column;
+  }
+
+  static constexpr uint8_t rotatedColumn(uint8_t row, uint8_t column) {
+    return Rotation == LAYOUT_ROTATE_0 ? column : Rotation == LAYOUT_ROTATE_90 ? Height - 1 - row :
+           Rotation == LAYOUT_ROTATE_180 ? Width - 1 - column : row;
+  }
+
+  // Index on the strip of a panel row and column, counted from the origin corner.
+  static constexpr uint16_t stripIndex(uint8_t row, uint8_t column) {
+    return (uint16_t)row * stripWidth + ((Wiring == LAYOUT_SERPENTINE && (row & 1)) ? stripWidth - 1 - column : column);
+  }
+
+  static constexpr uint16_t panelIndex(uint8_t row, uint8_t column) {
+    return stripIndex((Origin & LAYOUT_ORIGIN_BOTTOM) ? stripHeight - 1 - row : row,
+                      (Origin & LAYOUT_ORIGIN_RIGHT) ? stripWidth - 1 - column : column);
+  }
+
+  /**
+   * index is a function that maps a pixel position of the picture to the index of its LED on the strip.
+   *
+   * **Parameters:**
+   *
+   * - `position`: A `uint16_t` holding `row * Width + column`.
+   *
+   * **Returns:**
+   *
+   * - `uint16_t`: Returns the index into `leds[]`.
+   */
+  static constexpr uint16_t index(uint16_t position) {
+    return panelIndex(rotatedRow(position / Width, position % Width), rotatedColumn(position / Width, position % Width));
+  }
+};
+
+template <uint16_t... Positions>
+struct LayoutSequence {};
+
+// LayoutSequenceOf<N>::type is LayoutSequence<0, 1, ..., N - 1>; C++11 has no std::make_integer_sequence.
+template <uint16_t Count, uint16_t... Positions>
+struct LayoutSequenceOf : LayoutSequenceOf<Count - 1, Count - 1, Positions...> {};
+
+template <uint16_t... Positions>
+struct LayoutSequenceOf<0, Positions...> {
+  typedef LayoutSequence<Positions...> type;
+};
+
+/**
+ * LayoutTable is a class template holding the LED index of every pixel position of a `PanelLayout` in program memory.
+ *
+ * **Functionality:**
+ *
+ * - `leds[position]` is filled by `Layout::index` at compile time and read with `pgm_read_byte`: one flash load per pixel instead
+ *   of divisions and branches, and no SRAM. A 16x16 table takes 256 bytes of flash.
+ * - Entries are bytes, so the layout may have at most 256 pixels, which is also the range of the position byte on the wire.
+ */
+template <typename Layout, typename Sequence = typename LayoutSequenceOf<Layout::count>::type>
+struct LayoutTable;
+
+template <typename Layout, uint16_t... Positions>
+struct LayoutTable<Layout, LayoutSequence<Positions...> > {
+  static_assert(sizeof...(Positions) <= 256, "LED indices are stored as bytes; a layout may have at most 256 pixels");
+  static const uint8_t leds[sizeof...(Positions)];
+};
+
+template <typename Layout, uint16_t... Positions>
+const uint8_t LayoutTable<Layout, LayoutSequence<Positions...> >::leds[sizeof...(Positions)] PROGMEM = {
+  (uint8_t)Layout::index(Positions)...
+};
@@ -0,0 +1,200 @@
+#ifndef PERF_STATS_ENABLED
+#define PERF_STATS_ENABLED 1      // 0: the PERF_* macros compile to nothing and the statistics take no SRAM
+#endif
+
+#define PERF_STAGE_RECEIVE 0      // first byte of a message until its terminator, i.e. waiting for the UART
+#define PERF_STAGE_DECODE 1       // cobsDecode; "data:" lines are decoded while they arrive, within PERF_STAGE_RECEIVE
+#define PERF_STAGE_CHECKSUM 2     // one's complement checksum / CRC-8
+#define PERF_STAGE_PIXELS 3       // writing the pixels of a message into leds[]
+#define PERF_STAGE_SHOW 4         // FastLED.show
+#define PERF_STAGE_COUNT 5
+
+#define PERF_MSG_CONTROL 0        // text commands (syn, fin, baud, ...); 1..FRAME_TYPE_LAST are the binary frames by FRAME_TYPE_*
+#define PERF_MSG_DATA (FRAME_TYPE_LAST + 1)  // text "data:" lines
+#define PERF_MSG_COUNT (PERF_MSG_DATA + 1)
+
+#define PERF_STATS_PREFIX "stats:"
+#define PERF_STAGE_PREFIX "stage:"
+#define PERF_MSG_PREFIX "msg:"
+#define PERF_COUNTERS_PREFIX "counters:"
+#define PERF_STATS_END "stats-end"
+
+#if PERF_STATS_ENABLED
+
+// Durations are kept in micros() (4 us resolution on a 16 MHz Uno); 16-bit fields saturate instead of wrapping.
+struct PerfStage {
+  uint32_t totalMicros;
+  uint16_t count;
+  uint16_t maxMicros;
+};
+
+struct PerfMessage {
+  uint32_t totalMicros;
+  uint16_t count;
+  uint16_t maxMicros;
+};
+
+struct PerfCounters {
+  uint32_t bytesReceived;     // bytes moved from the serial library into the receive ring
+  uint16_t bytesDropped;      // text bytes dropped because incomingMessage was full
+  uint16_t messagesTruncated; // text messages that lost bytes that way
+  uint16_t frameOverflows;    // binary frames longer than frameBuffer
+  uint16_t checksumFailures;  // "data:" lines with a bad one's complement checksum
+  uint16_t crcFailures;       // binary frames with a bad COBS body, length or CRC-8
+  uint16_t ringFull;          // pumpReceive calls that stopped because the receive ring was full
+  uint16_t fecRepairs;        // binary frames with a corrupted byte repaired by fecRepair instead of a resend
+  uint16_t stagingSpills;     // received frames with more colors than StagedFrame holds, written to leds[] before fin
+};
+
+PerfStage perfStages[PERF_STAGE_COUNT];
+PerfMessage perfMessages[PERF_MSG_COUNT];
+PerfCounters perfCounters;
+unsigned long perfResetMillis = 0;
+unsigned long perfMessageStartMicros = 0;
+
+#define PERF_START(name) unsigned long name = micros()
+#define PERF_MESSAGE_BEGIN() perfMessageStartMicros = micros()
+#define PERF_STAGE(stage, start) perfStageAdd(stage, start)
+#define PERF_MESSAGE(type, start) perfMessageAdd(type, start)
+#define PERF_COUNT(counter) perfCount(perfCounters.counter)
+
+/**
+ * perfCount is a function that increments a 16-bit statistics counter without wrapping around.
+ *
+ * **Parameters:**
+ *
+ * - `counter`: A `uint16_t&` referring to the counter.
+ */
+void perfCount(uint16_t& counter) {
+  if (counter != 0xFFFF) {
+    counter++;
+  }
+}
+
+void perfCount(uint32_t& counter) {
+  counter++;
+}
+
+/**
+ * perfElapsed is a function that returns the time since `start`, saturated to 16 bits.
+ *
+ * **Parameters:**
+ *
+ * - `start`: An `unsigned long` holding a `micros()` timestamp.
+ *
+ * **Returns:**
+ *
+ * - `uint16_t`: Returns the elapsed microseconds, or `0xFFFF` for 65 ms and more.
+ */
+uint16_t perfElapsed(unsigned long start) {
+  unsigned long elapsed = micros() - start;
+  return elapsed > 0xFFFF ? 0xFFFF : (uint16_t)elapsed;
+}
+
+/**
+ * perfStageAdd is a function that adds the time since `start` to a processing stage.
+ *
+ * **Parameters:**
+ *
+ * - `stage`: A `uint8_t` holding one of the `PERF_STAGE_*` values.
+ * - `start`: An `unsigned long` holding the `micros()` timestamp taken when the stage began.
+ */
+void perfStageAdd(uint8_t stage, unsigned long start) {
+  uint16_t elapsed = perfElapsed(start);
+  PerfStage& entry = perfStages[stage];
+  entry.totalMicros += elapsed;
+  perfCount(entry.count);
+  if (elapsed > entry.maxMicros) {
+    entry.maxMicros = elapsed;
+  }
+}
+
+/**
+ * perfMessageAdd is a function that records the processing time of one message.
+ *
+ * **Parameters:**
+ *
+ * - `type`: A `uint8_t` holding `PERF_MSG_CONTROL`, `PERF_MSG_DATA` or the `FRAME_TYPE_*` of a binary frame.
+ * - `start`: An `unsigned long` holding the `micros()` timestamp taken when processing began.
+ *
+ * **Functionality:**
+ *
+ * - The time covers the whole handler, including the reply it writes; with `SoftwareSerial` that is about 1 ms per reply byte at 9600 baud.
+ */
+void perfMessageAdd(uint8_t type, unsigned long start) {
+  if (type >= PERF_MSG_COUNT) {
+    return;
+  }
+  uint16_t elapsed = perfElapsed(start);
+  PerfMessage& entry = perfMessages[type];
+  entry.totalMicros += elapsed;
+  perfCount(entry.count);
+  if (elapsed > entry.maxMicros) {
+    entry.maxMicros = elapsed;
+  }
+}
+
+#else
+
+#define PERF_START(name)
+#define PERF_MESSAGE_BEGIN()
+#define PERF_STAGE(stage, start)
+#define PERF_MESSAGE(type, start)
+#define PERF_COUNT(counter)
+
+#endif
+
+/**
+ * perfStatsReset is a function that clears all statistics and restarts the measuring period.
+ */
+void perfStatsReset() {
+#if PERF_STATS_ENABLED
+  memset(perfStages, 0, sizeof(perfStages));
+  memset(perfMessages, 0, sizeof(perfMessages));
+  memset(&perfCounters, 0, sizeof(perfCounters));
+  perfResetMillis = millis();
+#endif
+}
+
+/**
+ * perfStatsReport is a function that sends the statistics as reply lines.
+ *
+ * **Parameters:**
+ *
+ * - `send`: A `ReplySender` that sends each line, normally `sendReply`.
+ *
+ * **Functionality:**
+ *
+ * - `stats:<millis since reset>` opens the report.
+ * - One `stage:<stage>:<count>:<total us>:<max us>` line per `PERF_STAGE_*` value.
+ * - One `msg:<type>:<count>:<total us>:<max us>` line per message type that occurred, see `PERF_MSG_*`.
+ * - `counters:<bytes received>:<bytes dropped>:<messages truncated>:<frame overflows>:<checksum failures>:<CRC failures>:<ring full>`
+ *   followed by `:<FEC repairs>:<staging spills>`.
+ * - `stats-end` closes the report. A build with `PERF_STATS_ENABLED` 0 only sends this line.
+ */
+void perfStatsReport(ReplySender send) {
+  char line[72];  // the longest line, "counters:" with every field at its maximum, takes 67 characters
+#if PERF_STATS_ENABLED
+  snprintf_P(line, sizeof(line), PSTR(PERF_STATS_PREFIX "%lu"), (unsigned long)(millis() - perfResetMillis));
+  send(line);
+  for (uint8_t stage = 0; stage < PERF_STAGE_COUNT; stage++) {
+    snprintf_P(line, sizeof(line), PSTR(PERF_STAGE_PREFIX "%u:%u:%lu:%u"), stage, perfStages[stage].count,
+               (unsigned long)perfStages[stage].totalMicros, perfStages[stage].maxMicros);
+    send(line);
+  }
+  for (uint8_t type = 0; type < PERF_MSG_COUNT; type++) {
+    if (perfMessages[type].count == 0) {
+      continue;
+    }
+    snprintf_P(line, sizeof(line), PSTR(PERF_MSG_PREFIX "%u:%u:%lu:%u"), type, perfMessages[type].count,
+               (unsigned long)perfMessages[type].totalMicros, perfMessages[type].maxMicros);
+    send(line);
+  }
+  snprintf_P(line, sizeof(line), PSTR(PERF_COUNTERS_PREFIX "%lu:%u:%u:%u:%u:%u:%u:%u:%u"), (unsigned long)perfCounters.bytesReceived,
+             perfCounters.bytesDropped, perfCounters.messagesTruncated, perfCounters.frameOverflows, perfCounters.checksumFailures,
+             perfCounters.crcFailures, perfCounters.ringFull, perfCounters.fecRepairs, perfCounters.stagingSpills);
+  send(line);
+#endif
+  snprintf_P(line, sizeof(line), PSTR(PERF_STATS_END));
+  send(line);
+}
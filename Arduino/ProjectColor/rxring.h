@@ -0,0 +1,62 @@
+#ifndef RX_RING_SIZE
+#define RX_RING_SIZE 128          // must be a power of two; on top of the 64Bytes the serial library buffers itself
+#endif
+#define RX_RING_MASK (RX_RING_SIZE - 1)
+
+// Single producer / single consumer: only rxRingPut moves the head and only rxRingGet moves the tail. Both run in loop(), the
+// producer in pumpReceive, so the ring needs no locking; it is not meant to be filled from an interrupt handler.
+uint8_t rxRing[RX_RING_SIZE];
+uint8_t rxRingHead = 0;
+uint8_t rxRingTail = 0;
+
+/**
+ * rxRingAvailable is a function that returns the number of bytes waiting in the receive ring buffer.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the number of bytes that `rxRingGet` can read.
+ */
+uint8_t rxRingAvailable() {
+    return (uint8_t)(rxRingHead - rxRingTail) & RX_RING_MASK;
+}
+
+/**
+ * rxRingPut is a function that appends a byte to the receive ring buffer.
+ *
+ * **Parameters:**
+ *
+ * - `c`: A `uint8_t` holding the received byte.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `false` if the ring is full and the byte was not stored. One slot stays free to tell a full ring from an empty one.
+ */
+bool rxRingPut(uint8_t c) {
+    uint8_t next = (rxRingHead + 1) & RX_RING_MASK;
+    if (next == rxRingTail) {
+        return false;
+    }
+    rxRing[rxRingHead] = c;
+    rxRingHead = next;
+    return true;
+}
+
+/**
+ * rxRingGet is a function that removes the oldest byte from the receive ring buffer. Check `rxRingAvailable` first.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the oldest byte in the ring.
+ */
+uint8_t rxRingGet() {
+    uint8_t c = rxRing[rxRingTail];
+    rxRingTail = (rxRingTail + 1) & RX_RING_MASK;
+    return c;
+}
+
+/**
+ * rxRingClear is a function that discards every byte waiting in the receive ring buffer.
+ */
+void rxRingClear() {
+    rxRingTail = rxRingHead;
+}
@@ -0,0 +1,46 @@
+// Real-time streaming (PROTO_CAP_STREAM): after one handshake the app pushes whole frames back to back as FRAME_TYPE_STREAM chunks,
+// without an acknowledgment per chunk. The newest complete frame is shown; incomplete and late frames are dropped, and the app learns
+// about both from a "stream:" report after every STREAM_REPORT_INTERVAL frames.
+#define STREAM_HEADER_SIZE 2      // 1Byte frame sequence + 1Byte chunk index
+#define STREAM_CHUNK_PIXELS 16    // pixels per chunk, 3_bytes(R,G,B) each; a chunk covers positions chunk * 16 .. chunk * 16 + 15
+#define STREAM_CHUNK_BYTES (STREAM_CHUNK_PIXELS * 3)
+#define STREAM_REPORT_INTERVAL 16 // frames per report; the app pauses after the last frame of each group to receive it
+#define STREAM_STALE_MILLIS 50    // line idle time after which an incomplete frame is given up
+
+/**
+ * StreamState holds the progress of a stream.
+ *
+ * - `active`: `PROTO_CAP_STREAM` was negotiated.
+ * - `assembling`: `true` while the chunks of frame `sequence` are being written to `leds[]`.
+ * - `started`: `true` once a frame was begun; from then on only frames newer than `sequence` are begun.
+ * - `chunks`: A bit mask of the chunks of that frame received so far, bit n for chunk n.
+ * - `shownSequence`: The sequence number of the last frame shown.
+ * - `shown`, `dropped`: Frames shown and frames given up since the last report.
+ * - `reportPending`: A report is sent once the line is idle.
+ */
+struct StreamState {
+  bool active;
+  bool assembling;
+  bool started;
+  bool reportPending;
+  uint8_t sequence;
+  uint8_t shownSequence;
+  uint16_t chunks;
+  uint8_t shown;
+  uint8_t dropped;
+};
+
+/**
+ * streamIsNewer is a function that compares two frame sequence numbers, which wrap after 255.
+ *
+ * **Parameters:**
+ *
+ * - `sequence`, `reference`: `uint8_t` sequence numbers.
+ *
+ * **Returns:**
+ *
+ * - `bool`: Returns `true` if `sequence` is up to 127 frames after `reference`.
+ */
+bool streamIsNewer(uint8_t sequence, uint8_t reference) {
+  return (int8_t)(sequence - reference) > 0;
+}
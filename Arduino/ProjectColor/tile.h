@@ -0,0 +1,44 @@
+#include <EEPROM.h>
+
+// Position of this panel in a wall of several panels, each driven by its own firmware and Bluetooth link. The app cuts its canvas
+// into one tile per panel at these offsets (in pixels) and commits all tiles together, see `fin-sync` and `show` in ProjectColor.ino.
+#ifndef TILE_DEFAULT_X
+#define TILE_DEFAULT_X 0          // used until the app stores another offset with tile-set:
+#endif
+#ifndef TILE_DEFAULT_Y
+#define TILE_DEFAULT_Y 0
+#endif
+#define TILE_CONFIG_SIZE 3        // magic, x, y at the end of the EEPROM; the animation storage stops before it
+#define TILE_CONFIG_ADDRESS (E2END + 1 - TILE_CONFIG_SIZE)
+#define TILE_CONFIG_MAGIC 0x7E
+
+/**
+ * tileLoad is a function that reads the tile offset of this panel from the EEPROM.
+ *
+ * **Parameters:**
+ *
+ * - `x`, `y`: `uint8_t&` that receive the offset of the panel's top left pixel in the canvas; `TILE_DEFAULT_X` and
+ *   `TILE_DEFAULT_Y` if no offset was stored.
+ */
+void tileLoad(uint8_t& x, uint8_t& y) {
+  if (EEPROM.read(TILE_CONFIG_ADDRESS) != TILE_CONFIG_MAGIC) {
+    x = TILE_DEFAULT_X;
+    y = TILE_DEFAULT_Y;
+    return;
+  }
+  x = EEPROM.read(TILE_CONFIG_ADDRESS + 1);
+  y = EEPROM.read(TILE_CONFIG_ADDRESS + 2);
+}
+
+/**
+ * tileStore is a function that stores the tile offset of this panel in the EEPROM, so it survives a reset.
+ *
+ * **Parameters:**
+ *
+ * - `x`, `y`: `uint8_t` offset of the panel's top left pixel in the canvas.
+ */
+void tileStore(uint8_t x, uint8_t y) {
+  EEPROM.update(TILE_CONFIG_ADDRESS + 1, x);
+  EEPROM.update(TILE_CONFIG_ADDRESS + 2, y);
+  EEPROM.update(TILE_CONFIG_ADDRESS, TILE_CONFIG_MAGIC);
+}
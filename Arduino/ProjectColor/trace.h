@@ -0,0 +1,128 @@
+#define TRACE_LEVEL_OFF 0
+#define TRACE_LEVEL_ERROR 1       // corrupt or rejected input
+#define TRACE_LEVEL_INFO 2        // session events: handshake, fin, link speed, sequence gaps
+#define TRACE_LEVEL_DEBUG 3       // every message and frame; fills the ring within one transfer
+
+#ifndef TRACE_LEVEL
+#define TRACE_LEVEL TRACE_LEVEL_INFO
+#endif
+
+#ifndef TRACE_RING_SIZE
+#define TRACE_RING_SIZE 8         // events, must be a power of two; 5Bytes of SRAM each
+#endif
+#define TRACE_RING_MASK (TRACE_RING_SIZE - 1)
+
+// Event IDs and their two arguments
+#define TRACE_EVENT_MESSAGE 0x01          // text message: first character, length
+#define TRACE_EVENT_SYN 0x02              // handshake: accepted capabilities low byte, high byte; the window is on with PROTO_CAP_WINDOW
+#define TRACE_EVENT_FIN 0x03              // frame shown: generation, 0
+#define TRACE_EVENT_BAUD 0x04             // link speed switched: rate code, 1 while waiting for baud-check
+#define TRACE_EVENT_LINK_FALLBACK 0x05    // baud-check missing: abandoned rate code, 0
+#define TRACE_EVENT_CHECKSUM_FAIL 0x06    // "data:" line rejected: converted bytes, 0
+#define TRACE_EVENT_FRAME 0x07            // binary frame: type, payload length
+#define TRACE_EVENT_FRAME_INVALID 0x08    // bad COBS body, length or CRC: encoded length, decoded length
+#define TRACE_EVENT_FRAME_OVERFLOW 0x09   // frame longer than frameBuffer: 0, 0
+#define TRACE_EVENT_FRAME_REJECTED 0x0A   // unknown type or malformed payload: type, payload length
+#define TRACE_EVENT_SEQ_GAP 0x0B          // windowed frame out of order: expected sequence, received sequence
+#define TRACE_EVENT_DELTA_REJECT 0x0C     // delta against another frame: base generation, committed generation
+#define TRACE_EVENT_UNKNOWN_MESSAGE 0x0D  // unknown text message: first character, length
+#define TRACE_EVENT_FEC_REPAIR 0x0E       // corrupted byte repaired by fecRepair: position in the decoded frame, decoded length
+#define TRACE_EVENT_STREAM_DROP 0x0F      // streamed frame given up: sequence, mask of the chunks received (low byte)
+#define TRACE_EVENT_STAGING_SPILL 0x10    // received frame too colorful for the back buffer, written to leds[]: position, 0
+#define TRACE_EVENT_CACHE 0x11            // cache-show / cache-put: slot (0xFF on a miss or failure), 1 for cache-put
+
+#define TRACE_DUMP_PREFIX "trace:"
+#define TRACE_DUMP_END "trace-end"
+
+#if TRACE_LEVEL > TRACE_LEVEL_OFF
+
+struct TraceEvent {
+  uint16_t millis;  // lower 16 bits of millis(), wraps every 65 s
+  uint8_t event;
+  uint8_t arg0;
+  uint8_t arg1;
+};
+
+TraceEvent traceRing[TRACE_RING_SIZE];
+uint8_t traceHead = 0;     // next slot to write
+uint8_t traceCount = 0;    // valid events, up to TRACE_RING_SIZE
+
+/**
+ * traceRecord is a function that appends an event to the trace ring, overwriting the oldest event once the ring is full.
+ *
+ * **Parameters:**
+ *
+ * - `event`: A `uint8_t` holding one of the `TRACE_EVENT_*` IDs.
+ * - `arg0`, `arg1`: `uint8_t` arguments whose meaning depends on the event.
+ *
+ * **Functionality:**
+ *
+ * - Costs a few dozen cycles and no serial traffic, so enabled traces stay cheap on the hot path. Use the `TRACE_*` macros instead of
+ *   calling it directly, so traces above `TRACE_LEVEL` compile to nothing.
+ */
+void traceRecord(uint8_t event, uint8_t arg0, uint8_t arg1) {
+  TraceEvent& entry = traceRing[traceHead];
+  entry.millis = (uint16_t)millis();
+  entry.event = event;
+  entry.arg0 = arg0;
+  entry.arg1 = arg1;
+  traceHead = (traceHead + 1) & TRACE_RING_MASK;
+  if (traceCount < TRACE_RING_SIZE) {
+    traceCount++;
+  }
+}
+
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_ERROR
+#define TRACE_ERROR(event, arg0, arg1) traceRecord(event, arg0, arg1)
+#else
+#define TRACE_ERROR(event, arg0, arg1)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_INFO
+#define TRACE_INFO(event, arg0, arg1) traceRecord(event, arg0, arg1)
+#else
+#define TRACE_INFO(event, arg0, arg1)
+#endif
+
+#if TRACE_LEVEL >= TRACE_LEVEL_DEBUG
+#define TRACE_DEBUG(event, arg0, arg1) traceRecord(event, arg0, arg1)
+#else
+#define TRACE_DEBUG(event, arg0, arg1)
+#endif
+
+/**
+ * traceDump is a function that sends the events in the trace ring, oldest first, as reply lines.
+ *
+ * **Parameters:**
+ *
+ * - `send`: A `ReplySender` that sends each line, normally `sendReply`.
+ *
+ * **Functionality:**
+ *
+ * - `trace:<millis>:<level>:<count>` opens the dump with the lower 16 bits of the current `millis()`, so the reader can compute the age
+ *   of every event, the compiled `TRACE_LEVEL` and the number of events.
+ * - One `<millis>:<event>:<arg0>:<arg1>` line per event, all fields in hex.
+ * - `trace-end` closes the dump. The ring is not cleared; a build with `TRACE_LEVEL_OFF` reports 0 events.
+ */
+void traceDump(ReplySender send) {
+  char line[16];
+#if TRACE_LEVEL > TRACE_LEVEL_OFF
+  uint8_t count = traceCount;
+#else
+  uint8_t count = 0;
+#endif
+  snprintf_P(line, sizeof(line), PSTR(TRACE_DUMP_PREFIX "%04x:%x:%02x"), (uint16_t)millis(), TRACE_LEVEL, count);
+  send(line);
+#if TRACE_LEVEL > TRACE_LEVEL_OFF
+  uint8_t index = (traceHead - traceCount) & TRACE_RING_MASK;
+  for (uint8_t i = 0; i < count; i++, index = (index + 1) & TRACE_RING_MASK) {
+    const TraceEvent& entry = traceRing[index];
+    snprintf_P(line, sizeof(line), PSTR("%04x:%02x:%02x:%02x"), entry.millis, entry.event, entry.arg0, entry.arg1);
+    send(line);
+  }
+#endif
+  snprintf_P(line, sizeof(line), PSTR(TRACE_DUMP_END));
+  send(line);
+}
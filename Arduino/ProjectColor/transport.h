@@ -0,0 +1,77 @@
+#define BT_TRANSPORT_SOFTWARE_SERIAL 0  // SoftwareSerial on pins 9 (RX) / 10 (TX)
+#define BT_TRANSPORT_ALTSOFTSERIAL 1    // AltSoftSerial on its fixed pins 8 (RX) / 9 (TX), keeps receiving while it transmits
+#define BT_TRANSPORT_HARDWARE_SERIAL 2  // hardware UART on pins 0 (RX) / 1 (TX), shared with USB, so debug output is turned off
+
+#ifndef BT_TRANSPORT
+#define BT_TRANSPORT BT_TRANSPORT_SOFTWARE_SERIAL
+#endif
+
+#define LINK_BAUD_DEFAULT_CODE 0        // index of 9600 in LINK_BAUD_RATES, the rate after reset and after every fallback
+#define LINK_BAUD_RATE_COUNT 5
+#define LINK_SPEED_TIMEOUT_MILLIS 2000  // time the app has to confirm a new rate with baud-check before the firmware falls back
+
+// Rates the transport can receive reliably on a 16 MHz Uno, as a bit mask over LINK_BAUD_RATES
+#if BT_TRANSPORT == BT_TRANSPORT_HARDWARE_SERIAL
+#define LINK_BAUD_TRANSPORT_MASK 0x1F   // up to 115200
+#else
+#define LINK_BAUD_TRANSPORT_MASK 0x0F   // up to 57600
+#endif
+
+// The peer's UART has to follow every rate change. HC-05/HC-06 modules only take AT commands while no phone is connected, and
+// AT+UART stores the rate in the module's flash, so the firmware never reconfigures the module. Define BT_MODULE_FOLLOWS_BAUD to 1
+// for a peer that detects the rate on its own (a wired link); without it the link stays at 9600 and PROTO_CAP_LINK_SPEED is not
+// offered, so the app does not spend a baud: round trip on every transfer.
+#ifndef BT_MODULE_FOLLOWS_BAUD
+#define BT_MODULE_FOLLOWS_BAUD 0
+#endif
+
+#if BT_MODULE_FOLLOWS_BAUD
+#define LINK_BAUD_SUPPORTED_MASK LINK_BAUD_TRANSPORT_MASK
+#define LINK_SPEED_CAPS PROTO_CAP_LINK_SPEED  // offered in PROTO_CAPS_SUPPORTED
+#else
+#define LINK_BAUD_SUPPORTED_MASK (1 << LINK_BAUD_DEFAULT_CODE)
+#define LINK_SPEED_CAPS 0
+#endif
+
+const uint32_t LINK_BAUD_RATES[LINK_BAUD_RATE_COUNT] PROGMEM = {
+    9600, 19200, 38400, 57600, 115200
+};
+
+/**
+ * linkBaudRate is a function that returns the baud rate of a rate code used in the `baud:` negotiation.
+ *
+ * **Parameters:**
+ *
+ * - `code`: A `uint8_t` index into `LINK_BAUD_RATES`.
+ *
+ * **Returns:**
+ *
+ * - `uint32_t`: Returns the baud rate, or the default rate for an unknown code.
+ */
+uint32_t linkBaudRate(uint8_t code) {
+    if (code >= LINK_BAUD_RATE_COUNT) {
+        code = LINK_BAUD_DEFAULT_CODE;
+    }
+    return pgm_read_dword(&LINK_BAUD_RATES[code]);
+}
+
+/**
+ * linkBaudChoose is a function that picks the fastest rate both sides support.
+ *
+ * **Parameters:**
+ *
+ * - `offeredMask`: A `uint8_t` bit mask over `LINK_BAUD_RATES` with the rates the app offers.
+ *
+ * **Returns:**
+ *
+ * - `uint8_t`: Returns the code of the highest rate in both `offeredMask` and `LINK_BAUD_SUPPORTED_MASK`, or `LINK_BAUD_DEFAULT_CODE`.
+ */
+uint8_t linkBaudChoose(uint8_t offeredMask) {
+    uint8_t common = offeredMask & LINK_BAUD_SUPPORTED_MASK;
+    for (int8_t code = LINK_BAUD_RATE_COUNT - 1; code >= 0; code--) {
+        if (common & (1 << code)) {
+            return code;
+        }
+    }
+    return LINK_BAUD_DEFAULT_CODE;
+}
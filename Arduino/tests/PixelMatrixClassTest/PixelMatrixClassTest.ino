@@ -1,19 +1,30 @@
-#include<string.h>
-#include "Matrix.h"
-#define MATRIX_SIZE 16
+#include <FastLED.h>
+#include "../../ProjectColor/layout.h"
+#include "../../ProjectColor/frame.h"
 
-void custom_main() {
-  Matrix PixelMatrix;
-  PixelMatrix.print();
+Frame<MATRIX_WIDTH, MATRIX_HEIGHT> pixelMatrix;   // 768 bytes; the old Matrix class took 1280 plus a String per printed pixel
 
-  for (uint8_t row = 0; row < MATRIX_SIZE; row++) {
-    for (uint8_t column = 0; column < MATRIX_SIZE; column++) {
-      PixelMatrix.rows[row].pixel[column].setRed(255);
-      PixelMatrix.rows[row].pixel[column].setGreen(255);
-      PixelMatrix.rows[row].pixel[column].setBlue(255);
+void printFrame() {
+  char line[32];
+  Serial.println("---------------------------");
+  for (uint8_t row = 0; row < pixelMatrix.height; row++) {
+    for (uint8_t column = 0; column < pixelMatrix.width; column++) {
+      const CRGB& pixel = pixelMatrix.at(row, column);
+      snprintf(line, sizeof(line), "(%u, %u): %u %u %u", row, column, pixel.r, pixel.g, pixel.b);
+      Serial.println(line);
     }
   }
-  PixelMatrix.print();
+  Serial.println("---------------------------");
+}
+
+void custom_main() {
+  pixelMatrix.fill(CRGB::Black);
+  printFrame();
+
+  for (uint8_t row = 0; row < pixelMatrix.height; row++) {
+    pixelMatrix.row(row).fill(CRGB(255, 255, 255));
+  }
+  printFrame();
 }
 
 void setup() {
@@ -23,4 +34,3 @@ void setup() {
 
 void loop() {
 }
-
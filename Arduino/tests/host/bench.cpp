@@ -0,0 +1,1834 @@
+// Throughput benchmark for the host build of ProjectColor.ino.
+//
+// The firmware runs setup() and loop() on its own thread against the device end of the simulated link (host_link.h). The main
+// thread plays the app: it replays the syn / data / fin exchange of SendButton.kt for a 16x16 image from image_color_mapper.py,
+// checks leds[] against the image after every fin-ack, and reports frames/s, bytes/frame and the firmware's processing time.
+// --mode animation instead uploads the frames once as a stored animation (AnimationLogic.kt) and times its playback on the device;
+// --mode effect starts a plasma effect with one command, times --frames frames of it and stops it again (EffectLogic.kt).
+// --mode layout runs no transfer; it checks the firmware's LED layout table against the original zigzag wiring and other layouts
+// from layout.h for covering every LED once. --mode frame checks the frame containers of frame.h, including the panel view of leds[].
+// --mode stream streams the frames without acknowledgments (StreamLogic.kt) and checks the "stream:" reports, the last shown frame and
+// that every refresh showed a complete frame.
+// --mode codec runs no transfer either; it times the checksums and decoders of the firmware against the bit-string checksums they
+// replaced, on packets cut from every image of the corpus, checks that all implementations agree byte for byte, and compares the
+// encoders of the benchmark, which follow the app's, with the vectors in codec_vectors.txt.
+// --write-vectors regenerates that file after a deliberate protocol change.
+// --mode perf runs no transfer; it records every frame type, text commands and "data:" lines in the firmware's statistics and checks
+// that each lands in its own "msg:" slot of the report.
+// --cache cycles through CACHE_BENCH_FRAMES frames and shows a frame with cache-show once the device holds it, as SendButton.kt does
+// with PROTO_CAP_CACHE; every frame from the second round on must be a cache hit.
+// --loss drops every n-th quarter row message of the text and binary modes before it reaches the link, as a lossy radio would.
+// --adaptive-rto resends after the timeout of a RetransmitTimer, as RetransmitLogic.kt does, instead of after --timeout-ms; the
+// benchmark then reports the latency of every quarter row exchange and fails if the slowest one took longer than --max-tail-ms.
+// --jitter-ms holds every reply back for a random time of up to that many milliseconds, in order, as the varying latency of a
+// Bluetooth link does; a timeout shorter than that makes replies arrive after their part was resent. The binary mode negotiates
+// PROTO_CAP_TAGGED_REPLIES and drops confirmations that name another frame, as awaitReply does in the app. Every stop-and-wait run
+// fails if a part was confirmed although no intact copy of it was sent; a --jitter-ms run also fails if no late reply was dropped.
+//
+// usage: bench [--mode text|binary|window|animation|effect|layout|frame|stream|codec|perf] [--baud <rate>] [--frames <n>] [--corpus <image_color_mapper.py>] [--image <name>]
+//              [--line-pixels 4|8|16] [--flow-control] [--sync-commit] [--fec] [--corrupt <n>] [--abort] [--cache] [--timeout-ms <ms>]
+//              [--link-speed] [--loss <n>] [--adaptive-rto] [--jitter-ms <ms>] [--max-tail-ms <ms>] [--min-fps <fps>] [--stats] [--trace]
+//              [--vectors <codec_vectors.txt>] [--write-vectors]
+//
+// --line-pixels sets the pixels per "data:" line of the text mode; the firmware takes quarter, half and whole rows.
+// --baud 0 removes the pacing and measures the firmware alone. The benchmark exits with 1 if a frame did not arrive intact or the
+// frame rate stays below --min-fps. --sync-commit ends every frame with fin-sync and show, as a panel of a tiled wall (TileLogic.kt),
+// and checks that nothing is shown before show. --corrupt flips one byte in the first transmission of every n-th binary frame, as
+// line noise would; --fec negotiates PROTO_CAP_FEC, and the benchmark then fails if a corrupted frame needed a resend or a frame
+// shorter than its check bytes was not rejected. --abort breaks off half of the next frame before every frame and fails if that
+// reached leds[] or the LEDs. --stats and --trace print the firmware's own "stats" report and trace ring after the run.
+// --link-speed negotiates the fastest link speed after the first handshake, as negotiateLinkSpeed does, and keeps it for the
+// transfers that follow, as LinkSpeed does; it fails unless the firmware switched rates only once and kept the rate throughout.
+#include "Arduino.h"
+#include "FastLED.h"
+#include "host_link.h"
+#include "layout.h"
+#include "frame.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <time.h>
+
+// Firmware symbols, defined in sketch.cpp. The sketch headers cannot be included a second time without duplicating their functions;
+// layout.h and frame.h hold only templates and inline members and are the exception.
+void setup();
+void loop();
+uint8_t onesComplementChecksum(const uint8_t* data, uint8_t length);
+uint8_t crc8(const uint8_t* data, uint8_t length);
+uint8_t ledIndex(uint8_t position);
+uint16_t crc16Update(uint16_t crc, const uint8_t* data, uint16_t length);
+void fecCheckBytes(const uint8_t* data, uint8_t length, uint8_t& p, uint8_t& q);
+uint8_t cobsDecode(const uint8_t* input, uint8_t length, uint8_t* output);
+bool frameIsValid(const uint8_t* frame, uint8_t length);
+void beginDataLine();
+void receiveDataChar(char c);
+void processPixels(const uint8_t* pixels, uint8_t count);
+bool processCompressedFrame(const uint8_t* payload, uint8_t length, bool staged);
+void perfStatsReset();
+void perfMessageAdd(uint8_t type, unsigned long start);
+typedef void (*ReplySender)(const char* reply);
+void perfStatsReport(ReplySender send);
+CRGB getStagedPixelColor(uint8_t position);
+void abandonPendingFrame();
+extern CRGB leds[];
+extern uint8_t frameBuffer[];
+extern uint8_t dataLength;
+extern uint8_t dataSum;
+
+// The bit-string checksums of checksum.cpp and libs/checksum.h, defined in legacy_checksum.cpp.
+uint8_t legacyStringChecksum(const std::string& hex);
+uint8_t legacyCharArrayChecksum(const std::string& hex);
+
+namespace {
+
+// Protocol constants as the app uses them (Framing.kt)
+const uint8_t FRAME_DELIMITER = 0x00;
+const uint8_t FRAME_TYPE_PIXELS = 0x01;
+const uint8_t FRAME_TYPE_PIXELS_SEQ = 0x02;
+const uint8_t FRAME_TYPE_ANIMATION_DATA = 0x08;
+const uint8_t FRAME_TYPE_STREAM = 0x09;
+const unsigned PROTO_CAP_BINARY_FRAMES = 0x01;
+const unsigned PROTO_CAP_WINDOW = 0x02;
+const unsigned PROTO_CAP_LINK_SPEED = 0x40;
+const unsigned PROTO_CAP_FLOW_CONTROL = 0x80;
+const unsigned PROTO_CAP_FEC = 0x100;
+const unsigned PROTO_CAP_STREAM = 0x200;
+const unsigned PROTO_CAP_CACHE = 0x400;
+const unsigned PROTO_CAP_TAGGED_REPLIES = 0x800;
+
+const int MATRIX_SIZE = 16;
+const int QUARTER_ROW_PIXELS = 4;
+const int PARTS = MATRIX_SIZE * MATRIX_SIZE / QUARTER_ROW_PIXELS;
+const int RETRY_LIMIT = 20;
+
+// Stored animation format (animation.h)
+const int ANIM_HEADER_SIZE = 8;
+const uint8_t ANIM_MAGIC = 0xA5;
+const int ANIM_BLOCK_SIZE = 63;
+const int ANIM_MERGE_GAP = 2;
+const int ANIM_FPS = 25;
+const uint8_t CODEC_RLE = 0x01;
+const int FRAME_MAX_PAYLOAD = 65;
+
+const int PLAYBACK_WAKE_NEWLINES = 16;
+const int PLAYBACK_WAKE_PAUSE_MILLIS = 30;
+const char* EFFECT_BENCH_COMMAND = "fx:03:20:01:2a";  // plasma, speed 32, party palette, seed 42
+
+// Streaming (stream.h, StreamLogic.kt)
+const int STREAM_CHUNK_PIXELS = 16;
+const int STREAM_REPORT_INTERVAL = 16;
+const int STREAM_SHOW_PAUSE_MILLIS = 10;
+
+// Link speed (transport.h, SendButton.kt)
+const int LINK_BAUD_DEFAULT_CODE = 0;
+const int LINK_BAUD_RATE_COUNT = 5;
+const unsigned long LINK_BAUD_RATES[LINK_BAUD_RATE_COUNT] = {9600, 19200, 38400, 57600, 115200};
+
+// Codec suite (--mode codec)
+const char* CODEC_IMAGES[] = {"overlay_image", "snake_image"};
+const int CODEC_LINE_PIXELS[] = {4, 8, 16};  // quarter, half and whole row "data:" lines
+const uint8_t ONES_COMPLEMENT_VALID = 0xFF;
+const double CODEC_MIN_MICROS = 20000;       // timed per codec and packet size
+const double CODEC_MIN_SPEEDUP = 10;         // the byte-native checksum against the faster bit-string one
+
+// Frame cache (framecache.h, FrameCacheLogic.kt)
+const int CACHE_BENCH_FRAMES = 4;
+
+// Retransmission timeout (RetransmitLogic.kt)
+const double RTO_INITIAL_MILLIS = 1000;
+const double RTO_MIN_MILLIS = 200;
+const double RTO_MAX_MILLIS = 5000;
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string mode = "binary";
+    unsigned long baud = 9600;
+    int frames = 5;
+    int linePixels = QUARTER_ROW_PIXELS;
+    std::string corpus = HOST_DEFAULT_CORPUS;
+    std::string image = "overlay_image";
+    bool flowControl = false;
+    bool syncCommit = false;
+    bool fec = false;
+    int corrupt = 0;
+    bool abort = false;
+    bool cache = false;
+    bool linkSpeed = false;
+    int loss = 0;
+    bool adaptiveRto = false;
+    int jitterMillis = 0;
+    double maxTailMillis = 0;
+    std::string vectors = HOST_DEFAULT_VECTORS;
+    bool writeVectors = false;
+    unsigned long timeoutMillis = 1000;
+    double minFps = 0;
+    bool stats = false;
+    bool trace = false;
+};
+
+struct DriverStats {
+    unsigned long messages = 0;
+    unsigned long corrupted = 0;
+    unsigned long retries = 0;
+    unsigned long lost = 0;
+    unsigned long replies = 0;
+    unsigned long staleConfirmations = 0;  // ROW-SUCCESS lines dropped because they did not confirm the part waited for
+    unsigned long misattributed = 0;       // parts confirmed although no intact copy was sent
+
+    double turnaroundTotalMicros = 0;
+    double turnaroundMaxMicros = 0;
+};
+
+// Firmware thread state; written by the firmware thread, read by the main thread after it has stopped.
+std::atomic<bool> firmwareRunning(true);
+unsigned long busyLoops = 0;
+double busyCpuMicros = 0;
+double busyWallMicros = 0;
+double busyWallMaxMicros = 0;
+
+// The smoothed round trip and its deviation as RetransmitTimer keeps them (RFC 6298); the timeout doubles after every timeout until
+// the next round trip is measured.
+struct RetransmitTimer {
+    double srttMillis = -1;
+    double rttVarMillis = 0;
+    int backoffs = 0;
+
+    unsigned long timeoutMillis() const {
+        double base = srttMillis < 0 ? RTO_INITIAL_MILLIS : std::max(RTO_MIN_MILLIS, srttMillis + 4 * rttVarMillis);
+        return (unsigned long)std::min(RTO_MAX_MILLIS, base * (1 << std::min(backoffs, 16)));
+    }
+
+    void sample(double rttMillis) {
+        if (srttMillis < 0) {
+            srttMillis = rttMillis;
+            rttVarMillis = rttMillis / 2;
+        } else {
+            rttVarMillis = 0.75 * rttVarMillis + 0.25 * std::abs(srttMillis - rttMillis);
+            srttMillis = 0.875 * srttMillis + 0.125 * rttMillis;
+        }
+        backoffs = 0;
+    }
+};
+
+DriverStats stats;
+RetransmitTimer retransmitTimer;
+std::vector<double> exchangeMillis;  // first send to accepted reply, per quarter row of the stop-and-wait modes
+bool fecFrames = false;
+bool taggedReplies = false;
+std::string received;
+bool linkBusy = false;
+Options options;
+
+// Reply lines held back by --jitter-ms; a line is released no earlier than the one before it, so the order is kept.
+struct DelayedLine {
+    Clock::time_point releaseAt;
+    std::string text;
+};
+std::deque<DelayedLine> delayedLines;
+std::string arriving;
+std::mt19937 jitterRandom(1);
+
+double threadCpuMicros() {
+    struct timespec now;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+    return now.tv_sec * 1e6 + now.tv_nsec / 1e3;
+}
+
+double elapsedMicros(Clock::time_point since) {
+    return std::chrono::duration<double, std::micro>(Clock::now() - since).count();
+}
+
+// Runs the sketch like the Arduino core's main(). loop() calls that consumed input count as busy; idle calls yield the host CPU.
+void firmwareMain() {
+    setup();
+    while (firmwareRunning) {
+        unsigned long readBefore = hostLinkCounters().deviceBytesRead;
+        Clock::time_point wallStart = Clock::now();
+        double cpuStart = threadCpuMicros();
+        loop();
+        if (hostLinkCounters().deviceBytesRead != readBefore) {
+            double wall = elapsedMicros(wallStart);
+            busyLoops++;
+            busyCpuMicros += threadCpuMicros() - cpuStart;
+            busyWallMicros += wall;
+            busyWallMaxMicros = std::max(busyWallMaxMicros, wall);
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(50));
+        }
+    }
+}
+
+// Reads the overlay_image/snake_image style tables of image_color_mapper.py; smaller images are placed on a black 16x16 background.
+bool loadImage(const std::string& path, const std::string& name, uint32_t image[MATRIX_SIZE][MATRIX_SIZE]) {
+    std::ifstream file(path);
+    if (!file) {
+        fprintf(stderr, "cannot open corpus %s\n", path.c_str());
+        return false;
+    }
+    std::stringstream content;
+    content << file.rdbuf();
+    std::string text = content.str();
+
+    size_t start = text.find("\n" + name + " = [");
+    if (text.compare(0, name.size() + 4, name + " = [") == 0) {
+        start = 0;
+    }
+    if (start == std::string::npos) {
+        fprintf(stderr, "image %s not found in %s\n", name.c_str(), path.c_str());
+        return false;
+    }
+    size_t end = text.find("]]", start);
+    if (end == std::string::npos) {
+        return false;
+    }
+
+    memset(image, 0, sizeof(uint32_t) * MATRIX_SIZE * MATRIX_SIZE);
+    int row = -1;
+    int column = 0;
+    for (size_t i = text.find('[', start) + 1; i < end; i++) {
+        if (text[i] == '[') {
+            row++;
+            column = 0;
+        } else if (text.compare(i, 2, "0x") == 0) {
+            uint32_t color = (uint32_t)strtoul(text.c_str() + i, NULL, 16);
+            if (row >= 0 && row < MATRIX_SIZE && column < MATRIX_SIZE) {
+                image[row][column] = color;
+            }
+            column++;
+            i++;
+        }
+    }
+    return row >= 0;
+}
+
+// Frame k shows the image rotated k columns to the left, so consecutive frames differ.
+uint32_t frameColor(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, int row, int column) {
+    return image[row][(column + frame) % MATRIX_SIZE];
+}
+
+// Pixel records (position, R, G, B) of count pixels from position first on.
+void runPixels(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, int first, int count, uint8_t* pixels) {
+    for (int i = 0; i < count; i++) {
+        int row = (first + i) / MATRIX_SIZE;
+        int column = (first + i) % MATRIX_SIZE;
+        uint32_t color = frameColor(image, frame, row, column);
+        pixels[i * 4] = (uint8_t)((row << 4) + column);
+        pixels[i * 4 + 1] = (uint8_t)(color >> 16);
+        pixels[i * 4 + 2] = (uint8_t)(color >> 8);
+        pixels[i * 4 + 3] = (uint8_t)color;
+    }
+}
+
+void quarterRowPixels(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, int part, uint8_t pixels[QUARTER_ROW_PIXELS * 4]) {
+    runPixels(image, frame, part * QUARTER_ROW_PIXELS, QUARTER_ROW_PIXELS, pixels);
+}
+
+// The reply that confirms a frame: with PROTO_CAP_TAGGED_REPLIES it names the CRC-8 over type, length and payload.
+std::string rowSuccessFor(uint8_t type, const uint8_t* payload, uint8_t length) {
+    if (!taggedReplies) {
+        return "ROW-SUCCESS";
+    }
+    std::vector<uint8_t> body = {type, length};
+    body.insert(body.end(), payload, payload + length);
+    char reply[16];
+    snprintf(reply, sizeof(reply), "ROW-SUCCESS:%02x", crc8(body.data(), (uint8_t)body.size()));
+    return reply;
+}
+
+// With fecFrames the frame carries the PROTO_CAP_FEC check bytes. corruptAt >= 0 flips a non-zero byte of the body from that index
+// on into another non-zero byte, which leaves the COBS structure intact, like a bit error on the line.
+std::vector<uint8_t> buildFrame(uint8_t type, const uint8_t* payload, uint8_t length, int corruptAt = -1) {
+    std::vector<uint8_t> body;
+    body.push_back(type);
+    body.push_back(length);
+    body.insert(body.end(), payload, payload + length);
+    body.push_back(crc8(body.data(), (uint8_t)body.size()));
+    if (fecFrames) {
+        uint8_t p;
+        uint8_t q;
+        fecCheckBytes(body.data(), (uint8_t)body.size(), p, q);
+        body.push_back(p);
+        body.push_back(q);
+    }
+    for (size_t i = 0; corruptAt >= 0 && i < body.size(); i++) {
+        uint8_t& byte = body[(corruptAt + i) % body.size()];
+        if (byte != 0) {
+            byte ^= (byte ^ 0x5A) != 0 ? 0x5A : 0xA5;
+            stats.corrupted++;
+            break;
+        }
+    }
+
+    std::vector<uint8_t> frame(1, FRAME_DELIMITER);
+    size_t codeIndex = frame.size();
+    frame.push_back(0);
+    uint8_t code = 1;
+    for (uint8_t byte : body) {
+        if (byte == 0) {
+            frame[codeIndex] = code;
+            codeIndex = frame.size();
+            frame.push_back(0);
+            code = 1;
+        } else {
+            frame.push_back(byte);
+            code++;
+        }
+    }
+    frame[codeIndex] = code;
+    frame.push_back(FRAME_DELIMITER);
+    return frame;
+}
+
+// Moves whatever the firmware sent into `received`, taking out the flow control lines. With --jitter-ms every complete line waits in
+// delayedLines until its release time, and the wait for more bytes ends early when the next line is due.
+void pollReplies(unsigned long timeoutMicros) {
+    if (!delayedLines.empty()) {
+        auto untilRelease = std::chrono::duration_cast<std::chrono::microseconds>(delayedLines.front().releaseAt - Clock::now());
+        timeoutMicros = std::min(timeoutMicros, (unsigned long)std::max<long long>(0, untilRelease.count()));
+    }
+    uint8_t buffer[256];
+    size_t count = hostDriverRead(buffer, sizeof(buffer), timeoutMicros);
+    if (options.jitterMillis <= 0) {
+        received.append((const char*)buffer, count);
+    } else {
+        arriving.append((const char*)buffer, count);
+        std::uniform_int_distribution<int> jitter(0, options.jitterMillis * 1000);
+        for (size_t end = arriving.find('\n'); end != std::string::npos; end = arriving.find('\n')) {
+            Clock::time_point releaseAt = Clock::now() + std::chrono::microseconds(jitter(jitterRandom));
+            if (!delayedLines.empty()) {
+                releaseAt = std::max(releaseAt, delayedLines.back().releaseAt);
+            }
+            delayedLines.push_back({releaseAt, arriving.substr(0, end + 1)});
+            arriving.erase(0, end + 1);
+        }
+        while (!delayedLines.empty() && delayedLines.front().releaseAt <= Clock::now()) {
+            received += delayedLines.front().text;
+            delayedLines.pop_front();
+        }
+    }
+    for (;;) {
+        size_t busy = received.find("\nbusy\n");
+        size_t ready = received.find("\nready\n");
+        if (busy == std::string::npos && ready == std::string::npos) {
+            return;
+        }
+        if (ready == std::string::npos || (busy != std::string::npos && busy < ready)) {
+            received.erase(busy, 6);
+            linkBusy = true;
+        } else {
+            received.erase(ready, 7);
+            linkBusy = false;
+        }
+    }
+}
+
+void waitUntilReady() {
+    Clock::time_point start = Clock::now();
+    while (linkBusy && elapsedMicros(start) < options.timeoutMillis * 1000.0) {
+        pollReplies(1000);
+    }
+    linkBusy = false;
+}
+
+void send(const std::vector<uint8_t>& bytes) {
+    waitUntilReady();
+    hostDriverWrite(bytes.data(), bytes.size());
+    stats.messages++;
+}
+
+void sendLine(const std::string& line) {
+    std::string text = line + "\n";
+    send(std::vector<uint8_t>(text.begin(), text.end()));
+}
+
+// Counts the confirmations among the replies about to be dropped unread.
+void countStaleConfirmations(const std::string& replies) {
+    for (size_t at = replies.find("ROW-SUCCESS"); at != std::string::npos; at = replies.find("ROW-SUCCESS", at + 1)) {
+        stats.staleConfirmations++;
+    }
+}
+
+// Waits for the first of `tokens` and returns its index, or -1 after the timeout. Everything up to the token is consumed, so a
+// reply that is none of the tokens is dropped.
+int awaitReply(const std::vector<std::string>& tokens, Clock::time_point sentAt, std::string* rest = NULL,
+               unsigned long timeoutMillis = options.timeoutMillis) {
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMillis);
+    for (;;) {
+        size_t best = std::string::npos;
+        int found = -1;
+        for (size_t i = 0; i < tokens.size(); i++) {
+            size_t at = received.find(tokens[i]);
+            if (at != std::string::npos && at < best) {
+                best = at;
+                found = (int)i;
+            }
+        }
+        if (found >= 0) {
+            countStaleConfirmations(received.substr(0, best));
+            size_t end = best + tokens[found].size();
+            if (rest != NULL) {
+                size_t lineEnd = received.find('\n', end);
+                if (lineEnd == std::string::npos && Clock::now() < deadline) {
+                    pollReplies(1000);
+                    continue;
+                }
+                *rest = received.substr(end, lineEnd == std::string::npos ? std::string::npos : lineEnd - end);
+                end = lineEnd == std::string::npos ? received.size() : lineEnd;
+            }
+            received.erase(0, end);
+            double turnaround = elapsedMicros(sentAt);
+            stats.replies++;
+            stats.turnaroundTotalMicros += turnaround;
+            stats.turnaroundMaxMicros = std::max(stats.turnaroundMaxMicros, turnaround);
+            return found;
+        }
+        Clock::time_point now = Clock::now();
+        if (now >= deadline) {
+            return -1;
+        }
+        pollReplies((unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(deadline - now).count());
+    }
+}
+
+// awaitReply for a message just sent; with --adaptive-rto the timeout comes from retransmitTimer, which backs off if there is no
+// reply. Only the first token, the reply that names the message, is measured, and only for a first transmission (Karn's algorithm).
+int awaitRetransmitReply(const std::vector<std::string>& tokens, bool firstTransmission) {
+    Clock::time_point sentAt = Clock::now();
+    if (!options.adaptiveRto) {
+        return awaitReply(tokens, sentAt);
+    }
+    int reply = awaitReply(tokens, sentAt, NULL, retransmitTimer.timeoutMillis());
+    if (reply < 0) {
+        retransmitTimer.backoffs++;
+    } else if (reply == 0 && firstTransmission) {
+        retransmitTimer.sample(elapsedMicros(sentAt) / 1000);
+    }
+    return reply;
+}
+
+bool handshake(unsigned caps) {
+    for (int attempt = 0; attempt < RETRY_LIMIT; attempt++) {
+        received.clear();
+        if (caps == 0) {
+            sendLine("syn");
+        } else {
+            char line[16];
+            snprintf(line, sizeof(line), "syn:%02x", caps);
+            sendLine(line);
+        }
+        if (awaitRetransmitReply({"syn-ack"}, attempt == 0) == 0) {
+            sendLine("ack");
+            return true;
+        }
+        stats.retries++;
+    }
+    return false;
+}
+
+// Offers every rate of LINK_BAUD_RATES with "baud:" and confirms the answered one with "baud-check", as negotiateLinkSpeed does;
+// returns the rate code, or -1 if the firmware did not answer or confirm it.
+int negotiateLinkSpeed() {
+    char line[16];
+    snprintf(line, sizeof(line), "baud:%02x", (1 << LINK_BAUD_RATE_COUNT) - 1);
+    sendLine(line);
+    std::string fields;
+    if (awaitReply({"baud-ack:"}, Clock::now(), &fields) != 0) {
+        return -1;
+    }
+    int code = (int)strtol(fields.c_str(), NULL, 16);
+    if (code == LINK_BAUD_DEFAULT_CODE) {
+        return code;
+    }
+    sendLine("baud-check");
+    return awaitReply({"baud-ok"}, Clock::now()) == 0 ? code : -1;
+}
+
+// Stages the frame with fin-sync and shows it with show; the staged frame must not reach the LEDs before show.
+bool terminateSynchronised() {
+    unsigned long showsBefore = FastLED.shows;
+    int attempt = 0;
+    for (;; stats.retries++) {
+        if (++attempt > RETRY_LIMIT) {
+            return false;
+        }
+        sendLine("fin-sync");
+        if (awaitReply({"fin-ready"}, Clock::now()) == 0) {
+            break;
+        }
+    }
+    if (FastLED.shows != showsBefore) {
+        fprintf(stderr, "staged frame shown before show\n");
+        return false;
+    }
+    for (; attempt <= RETRY_LIMIT; attempt++) {
+        sendLine("show");
+        if (awaitReply({"fin-ack"}, Clock::now()) == 0) {
+            return true;
+        }
+        stats.retries++;
+    }
+    return false;
+}
+
+bool terminate() {
+    if (options.syncCommit) {
+        return terminateSynchronised();
+    }
+    for (int attempt = 0; attempt < RETRY_LIMIT; attempt++) {
+        sendLine("fin");
+        if (awaitReply({"fin-ack"}, Clock::now()) == 0) {
+            return true;
+        }
+        stats.retries++;
+    }
+    return false;
+}
+
+// Stop-and-wait, one quarter row per message, as sendMatrixRows does with text or PIXELS frames. Text lines carry --line-pixels.
+// With FEC a frame shorter than its check bytes must be answered with ROW-FAIL, not read past its end.
+bool rejectsShortFrame() {
+    send({FRAME_DELIMITER, 0x02, FRAME_TYPE_PIXELS, FRAME_DELIMITER});  // decodes to the type byte alone
+    if (awaitReply({"ROW-FAIL", "ROW-SUCCESS"}, Clock::now()) != 0) {
+        fprintf(stderr, "short frame not rejected\n");
+        return false;
+    }
+    return true;
+}
+
+// The first transmission of every --corrupt-th frame is corrupted; returns the body index to corrupt, or -1.
+int corruptionFor(int part) {
+    static int framesBuilt = 0;
+    if (options.corrupt <= 0 || ++framesBuilt % options.corrupt != 0) {
+        return -1;
+    }
+    return (part * 7) % (FRAME_MAX_PAYLOAD / 4);
+}
+
+bool sendStopAndWait(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, bool binary, int pixels = MATRIX_SIZE * MATRIX_SIZE) {
+    const int linePixels = binary ? QUARTER_ROW_PIXELS : options.linePixels;
+    for (int first = 0; first < pixels; first += linePixels) {
+        uint8_t data[MATRIX_SIZE * 4 + 1];
+        runPixels(image, frame, first, linePixels, data);
+
+        std::vector<uint8_t> message;
+        if (binary) {
+            message = buildFrame(FRAME_TYPE_PIXELS, data, QUARTER_ROW_PIXELS * 4);
+        } else {
+            data[linePixels * 4] = onesComplementChecksum(data, linePixels * 4);
+            std::string line = "data:";
+            char hex[3];
+            for (int i = 0; i <= linePixels * 4; i++) {
+                snprintf(hex, sizeof(hex), "%02x", data[i]);
+                line += hex;
+            }
+            line += "\n";
+            message.assign(line.begin(), line.end());
+        }
+
+        // Replies still unread answer earlier parts and are dropped, as BluetoothManager.sendData does; later ones must not
+        // confirm this part, which is checked against the copies that reached the link intact.
+        std::string success = binary ? rowSuccessFor(FRAME_TYPE_PIXELS, data, QUARTER_ROW_PIXELS * 4) : "ROW-SUCCESS";
+        countStaleConfirmations(received);
+        received.clear();
+        int corruptAt = binary ? corruptionFor(first / linePixels) : -1;
+        int attempt = 0;
+        bool delivered = false;
+        Clock::time_point exchangeStart = Clock::now();
+        for (;;) {
+            static unsigned long offered = 0;
+            if (options.loss > 0 && ++offered % options.loss == 0) {
+                stats.messages++;
+                stats.lost++;
+            } else {
+                bool corrupted = corruptAt >= 0 && attempt == 0;
+                send(corrupted ? buildFrame(FRAME_TYPE_PIXELS, data, QUARTER_ROW_PIXELS * 4, corruptAt) : message);
+                delivered = delivered || !corrupted || fecFrames;
+            }
+            if (awaitRetransmitReply({success, "ROW-FAIL"}, attempt == 0) == 0) {
+                exchangeMillis.push_back(elapsedMicros(exchangeStart) / 1000);
+                if (!delivered) {
+                    fprintf(stderr, "part at pixel %d of frame %d confirmed by a reply to another part\n", first, frame);
+                    stats.misattributed++;
+                }
+                break;
+            }
+            stats.retries++;
+            if (++attempt >= RETRY_LIMIT) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Go-back-N with up to `window` PIXELS_SEQ frames in flight, as sendMatrixRowsWindowed does.
+bool sendWindowed(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, int window) {
+    int base = 0;
+    int next = 0;
+    int firstUnsent = 0;
+    int stalledRounds = 0;
+    while (base < PARTS) {
+        Clock::time_point sentAt = Clock::now();
+        while (next < PARTS && next - base < window) {
+            uint8_t payload[1 + QUARTER_ROW_PIXELS * 4];
+            payload[0] = (uint8_t)next;
+            quarterRowPixels(image, frame, next, payload + 1);
+            send(buildFrame(FRAME_TYPE_PIXELS_SEQ, payload, sizeof(payload), next >= firstUnsent ? corruptionFor(next) : -1));
+            next++;
+            firstUnsent = std::max(firstUnsent, next);
+            sentAt = Clock::now();
+        }
+
+        int previousBase = base;
+        std::string sequence;
+        int reply = awaitReply({"ROW-ACK:", "ROW-FAIL:"}, sentAt, &sequence);
+        if (reply < 0) {
+            next = base;
+        } else {
+            int confirmed = base + (((int)strtoul(sequence.c_str(), NULL, 16) - base) & 0xFF);
+            if (confirmed <= next) {
+                base = confirmed;
+            }
+            if (reply == 1) {
+                next = base;
+            }
+        }
+
+        if (base == previousBase) {
+            stats.retries++;
+            if (++stalledRounds >= RETRY_LIMIT) {
+                return false;
+            }
+        } else {
+            stalledRounds = 0;
+        }
+    }
+    return true;
+}
+
+// Refreshes during a stream that showed no complete frame: the firmware assembles streamed frames in leds[] itself, so a dropped
+// frame leaves some of its chunks there, but no refresh may ever show them.
+std::atomic<bool> streamRefreshesChecked(false);
+std::atomic<int> tornRefreshes(0);
+
+struct StreamReport {
+    int lastShown = -1;
+    int shown = 0;
+    int dropped = 0;
+    int reports = 0;
+};
+
+// Adds a "stream:<last shown>:<shown>:<dropped>" report to `report`; returns false if none arrived.
+bool awaitStreamReport(StreamReport& report) {
+    std::string fields;
+    if (awaitReply({"stream:"}, Clock::now(), &fields) != 0) {
+        return false;
+    }
+    unsigned lastShown, shown, dropped;
+    if (sscanf(fields.c_str(), "%x:%x:%x", &lastShown, &shown, &dropped) != 3) {
+        return false;
+    }
+    if (shown > 0) {
+        report.lastShown = (int)lastShown;
+    }
+    report.shown += shown;
+    report.dropped += dropped;
+    report.reports++;
+    return true;
+}
+
+// Streams --frames frames as STREAM chunks, as streamFrames does: no reply per chunk, a pause after every frame for its refresh, and
+// a wait for the report after the last frame of every group. A missing report is not resent; the stream simply goes on.
+StreamReport streamFrames(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frames) {
+    StreamReport report;
+    for (int frame = 0; frame < frames; frame++) {
+        for (int chunk = 0; chunk < MATRIX_SIZE * MATRIX_SIZE / STREAM_CHUNK_PIXELS; chunk++) {
+            uint8_t payload[2 + STREAM_CHUNK_PIXELS * 3];
+            payload[0] = (uint8_t)frame;
+            payload[1] = (uint8_t)chunk;
+            for (int i = 0; i < STREAM_CHUNK_PIXELS; i++) {
+                int position = chunk * STREAM_CHUNK_PIXELS + i;
+                uint32_t color = frameColor(image, frame, position / MATRIX_SIZE, position % MATRIX_SIZE);
+                payload[2 + i * 3] = (uint8_t)(color >> 16);
+                payload[3 + i * 3] = (uint8_t)(color >> 8);
+                payload[4 + i * 3] = (uint8_t)color;
+            }
+            send(buildFrame(FRAME_TYPE_STREAM, payload, sizeof(payload), corruptionFor(chunk)));
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(STREAM_SHOW_PAUSE_MILLIS));
+        if (frame % STREAM_REPORT_INTERVAL == STREAM_REPORT_INTERVAL - 1 && !awaitStreamReport(report)) {
+            stats.retries++;
+        }
+    }
+    sendLine("stream-stop");
+    awaitStreamReport(report);
+    return report;
+}
+
+bool verifyFrame(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, const CRGB* pixels = leds) {
+    for (int row = 0; row < MATRIX_SIZE; row++) {
+        for (int column = 0; column < MATRIX_SIZE; column++) {
+            uint32_t color = frameColor(image, frame, row, column);
+            if (pixels[ledIndex((uint8_t)((row << 4) + column))] != CRGB(color)) {
+                fprintf(stderr, "frame %d: pixel %d,%d differs\n", frame, row, column);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// Counts a refresh as torn unless it shows one of the first `frames` frames completely; runs on the firmware thread, see onShow.
+void checkStreamRefresh(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frames) {
+    if (!streamRefreshesChecked) {
+        return;
+    }
+    for (int frame = 0; frame < frames; frame++) {
+        bool complete = true;
+        for (int position = 0; position < MATRIX_SIZE * MATRIX_SIZE && complete; position++) {
+            uint32_t color = frameColor(image, frame, position / MATRIX_SIZE, position % MATRIX_SIZE);
+            complete = FastLED.shown[ledIndex((uint8_t)position)] == CRGB(color);
+        }
+        if (complete) {
+            return;
+        }
+    }
+    tornRefreshes++;
+}
+
+// The key of a frame in the device's cache: the CRC-16 over R, G, B of every pixel in position order, as frameHash does.
+uint16_t frameHash(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame) {
+    uint16_t crc = 0xFFFF;
+    for (int position = 0; position < MATRIX_SIZE * MATRIX_SIZE; position++) {
+        uint32_t color = frameColor(image, frame, position / MATRIX_SIZE, position % MATRIX_SIZE);
+        uint8_t rgb[3] = {(uint8_t)(color >> 16), (uint8_t)(color >> 8), (uint8_t)color};
+        crc = crc16Update(crc, rgb, 3);
+    }
+    return crc;
+}
+
+// The hashes of the last "cache:<free>:<hash>..." report, like the app's FrameCache mirror.
+std::vector<uint16_t> cachedHashes;
+
+// Shows a frame from the device's cache if the mirror lists it; returns false on a miss, which drops the hash from the mirror.
+// cache-show is resent without an answer, since showing a cached frame twice does no harm.
+bool showCached(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame) {
+    uint16_t hash = frameHash(image, frame);
+    if (std::find(cachedHashes.begin(), cachedHashes.end(), hash) == cachedHashes.end()) {
+        return false;
+    }
+    char line[24];
+    snprintf(line, sizeof(line), "cache-show:%04x", hash);
+    for (int attempt = 0; attempt < RETRY_LIMIT; attempt++) {
+        sendLine(line);
+        int reply = awaitReply({"cache-hit", "cache-miss"}, Clock::now());
+        if (reply == 0) {
+            return true;
+        }
+        if (reply == 1) {
+            break;
+        }
+        stats.retries++;
+    }
+    cachedHashes.erase(std::find(cachedHashes.begin(), cachedHashes.end(), hash));
+    return false;
+}
+
+// Stores the frame just shown in the device's cache and takes over the list the device answers with.
+bool putCached(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame) {
+    char line[24];
+    snprintf(line, sizeof(line), "cache-put:%04x", frameHash(image, frame));
+    sendLine(line);
+    std::string rest;
+    if (awaitReply({"cache:", "cache-fail"}, Clock::now(), &rest) != 0) {
+        fprintf(stderr, "frame %d: not cached\n", frame);
+        return false;
+    }
+    cachedHashes.clear();
+    std::istringstream fields(rest);
+    std::string field;
+    std::getline(fields, field, ':');  // free bytes
+    while (std::getline(fields, field, ':')) {
+        cachedHashes.push_back((uint16_t)strtoul(field.c_str(), NULL, 16));
+    }
+    return true;
+}
+
+// Appends the RLE chunks of pixels [first, last] of a frame to an animation, as compressedPayloads does with CODEC_RLE.
+void appendRleChunks(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame, int first, int last, std::vector<uint8_t>& data) {
+    std::vector<uint8_t> payload;
+    int position = first;
+    while (position <= last) {
+        uint32_t color = frameColor(image, frame, position / MATRIX_SIZE, position % MATRIX_SIZE);
+        int run = 1;
+        while (position + run <= last && run < 255 &&
+               frameColor(image, frame, (position + run) / MATRIX_SIZE, (position + run) % MATRIX_SIZE) == color) {
+            run++;
+        }
+        if (!payload.empty() && payload.size() + 4 > (size_t)FRAME_MAX_PAYLOAD) {
+            data.push_back((uint8_t)payload.size());
+            data.insert(data.end(), payload.begin(), payload.end());
+            payload.clear();
+        }
+        if (payload.empty()) {
+            payload.push_back((uint8_t)position);
+            payload.push_back(CODEC_RLE);
+        }
+        payload.push_back((uint8_t)run);
+        payload.push_back((uint8_t)(color >> 16));
+        payload.push_back((uint8_t)(color >> 8));
+        payload.push_back((uint8_t)color);
+        position += run;
+    }
+    data.push_back((uint8_t)payload.size());
+    data.insert(data.end(), payload.begin(), payload.end());
+}
+
+// Encodes the frames like buildAnimation in AnimationLogic.kt, with RLE only: a whole first frame, then the changed pixel runs.
+std::vector<uint8_t> buildAnimation(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frames) {
+    std::vector<uint8_t> data;
+    const int pixels = MATRIX_SIZE * MATRIX_SIZE;
+    for (int frame = 0; frame < frames; frame++) {
+        if (frame == 0) {
+            appendRleChunks(image, frame, 0, pixels - 1, data);
+        } else {
+            int index = 0;
+            while (index < pixels) {
+                auto changed = [&](int i) {
+                    return frameColor(image, frame, i / MATRIX_SIZE, i % MATRIX_SIZE) !=
+                           frameColor(image, frame - 1, i / MATRIX_SIZE, i % MATRIX_SIZE);
+                };
+                if (!changed(index)) {
+                    index++;
+                    continue;
+                }
+                int end = index;
+                for (int next = index + 1; next < pixels && next - end <= ANIM_MERGE_GAP + 1; next++) {
+                    if (changed(next)) {
+                        end = next;
+                    }
+                }
+                appendRleChunks(image, frame, index, end, data);
+                index = end + 1;
+            }
+        }
+        data.push_back(0);
+    }
+
+    uint16_t crc = crc16Update(0xFFFF, data.data(), (uint16_t)data.size());
+    std::vector<uint8_t> animation = {ANIM_MAGIC, (uint8_t)frames, (uint8_t)ANIM_FPS, 0, (uint8_t)(data.size() >> 8),
+                                      (uint8_t)data.size(), (uint8_t)(crc >> 8), (uint8_t)crc};
+    animation.insert(animation.end(), data.begin(), data.end());
+    return animation;
+}
+
+bool sendAnimationBlock(const std::vector<uint8_t>& animation, size_t offset, size_t length) {
+    std::vector<uint8_t> payload = {(uint8_t)(offset >> 8), (uint8_t)offset};
+    payload.insert(payload.end(), animation.begin() + offset, animation.begin() + offset + length);
+    std::vector<uint8_t> frame = buildFrame(FRAME_TYPE_ANIMATION_DATA, payload.data(), (uint8_t)payload.size());
+    for (int attempt = 0; attempt < RETRY_LIMIT; attempt++) {
+        send(frame);
+        if (awaitReply({"ROW-SUCCESS", "ROW-FAIL"}, Clock::now()) == 0) {
+            return true;
+        }
+        stats.retries++;
+    }
+    return false;
+}
+
+// Uploads the frames as a stored animation, header last as buildAnimationUploadFrames does, and starts it with anim-play.
+bool uploadAnimation(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frames) {
+    int attempt = 0;
+    std::string capacity;
+    for (;;) {
+        sendLine("anim-info");
+        if (awaitReply({"anim-info:"}, Clock::now(), &capacity) == 0) {
+            break;
+        }
+        stats.retries++;
+        if (++attempt >= RETRY_LIMIT) {
+            fprintf(stderr, "no anim-info reply\n");
+            return false;
+        }
+    }
+    std::vector<uint8_t> animation = buildAnimation(image, frames);
+    if (animation.size() > strtoul(capacity.c_str(), NULL, 16)) {
+        fprintf(stderr, "animation of %zu bytes does not fit into %s bytes\n", animation.size(), capacity.c_str());
+        return false;
+    }
+    for (size_t offset = ANIM_HEADER_SIZE; offset < animation.size(); offset += ANIM_BLOCK_SIZE) {
+        if (!sendAnimationBlock(animation, offset, std::min((size_t)ANIM_BLOCK_SIZE, animation.size() - offset))) {
+            return false;
+        }
+    }
+    if (!sendAnimationBlock(animation, 0, ANIM_HEADER_SIZE)) {
+        return false;
+    }
+    sendLine("anim-play");
+    return awaitReply({"anim-ack", "anim-fail"}, Clock::now()) == 0;  // not retried: a lost anim-play fails the run
+}
+
+// Sends an effect command behind the newline burst of wakePlayback, as sendEffectCommand does.
+bool sendEffectCommand(const char* command) {
+    for (int attempt = 0; attempt < RETRY_LIMIT; attempt++) {
+        send(std::vector<uint8_t>(PLAYBACK_WAKE_NEWLINES, '\n'));
+        std::this_thread::sleep_for(std::chrono::milliseconds(PLAYBACK_WAKE_PAUSE_MILLIS));
+        sendLine(command);
+        int reply = awaitReply({"fx-ack", "fx-fail"}, Clock::now());
+        if (reply >= 0) {
+            return reply == 0;
+        }
+        stats.retries++;
+    }
+    return false;
+}
+
+// Sends a report command and returns everything the firmware answers up to and including `endToken`.
+std::string queryReport(const char* command, const char* endToken) {
+    received.clear();
+    sendLine(command);
+    Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(options.timeoutMillis);
+    while (received.find(endToken) == std::string::npos && Clock::now() < deadline) {
+        pollReplies(1000);
+    }
+    return received;
+}
+
+bool parseOptions(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string option = argv[i];
+        if (option == "--flow-control") {
+            options.flowControl = true;
+            continue;
+        }
+        if (option == "--sync-commit") {
+            options.syncCommit = true;
+            continue;
+        }
+        if (option == "--fec") {
+            options.fec = true;
+            continue;
+        }
+        if (option == "--abort") {
+            options.abort = true;
+            continue;
+        }
+        if (option == "--cache") {
+            options.cache = true;
+            continue;
+        }
+        if (option == "--link-speed") {
+            options.linkSpeed = true;
+            continue;
+        }
+        if (option == "--write-vectors") {
+            options.writeVectors = true;
+            continue;
+        }
+        if (option == "--stats") {
+            options.stats = true;
+            continue;
+        }
+        if (option == "--trace") {
+            options.trace = true;
+            continue;
+        }
+        if (option == "--adaptive-rto") {
+            options.adaptiveRto = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            fprintf(stderr, "missing value for %s\n", option.c_str());
+            return false;
+        }
+        const char* value = argv[++i];
+        if (option == "--mode") {
+            options.mode = value;
+        } else if (option == "--baud") {
+            options.baud = strtoul(value, NULL, 10);
+        } else if (option == "--frames") {
+            options.frames = atoi(value);
+        } else if (option == "--corrupt") {
+            options.corrupt = atoi(value);
+        } else if (option == "--loss") {
+            options.loss = atoi(value);
+        } else if (option == "--jitter-ms") {
+            options.jitterMillis = atoi(value);
+        } else if (option == "--max-tail-ms") {
+            options.maxTailMillis = atof(value);
+        } else if (option == "--line-pixels") {
+            options.linePixels = atoi(value);
+        } else if (option == "--corpus") {
+            options.corpus = value;
+        } else if (option == "--vectors") {
+            options.vectors = value;
+        } else if (option == "--image") {
+            options.image = value;
+        } else if (option == "--timeout-ms") {
+            options.timeoutMillis = strtoul(value, NULL, 10);
+        } else if (option == "--min-fps") {
+            options.minFps = atof(value);
+        } else {
+            fprintf(stderr, "unknown option %s\n", option.c_str());
+            return false;
+        }
+    }
+    if (options.mode != "text" && options.mode != "binary" && options.mode != "window" && options.mode != "animation" &&
+        options.mode != "effect" && options.mode != "layout" && options.mode != "frame" && options.mode != "stream" &&
+        options.mode != "codec" && options.mode != "perf") {
+        fprintf(stderr, "unknown mode %s\n", options.mode.c_str());
+        return false;
+    }
+    if (options.linePixels != 4 && options.linePixels != 8 && options.linePixels != MATRIX_SIZE) {
+        fprintf(stderr, "--line-pixels must be 4, 8 or %d\n", MATRIX_SIZE);
+        return false;
+    }
+    if (options.abort && options.mode != "text" && options.mode != "binary") {
+        fprintf(stderr, "--abort needs --mode text or binary\n");
+        return false;
+    }
+    if (options.cache && ((options.mode != "text" && options.mode != "binary") || options.abort)) {
+        fprintf(stderr, "--cache needs --mode text or binary and no --abort\n");
+        return false;
+    }
+    if ((options.loss > 0 || options.adaptiveRto || options.maxTailMillis > 0) && options.mode != "text" && options.mode != "binary") {
+        fprintf(stderr, "--loss, --adaptive-rto and --max-tail-ms need --mode text or binary\n");
+        return false;
+    }
+if (options.jitterMillis > 0 && options.mode != "binary") {
+        fprintf(stderr, "--jitter-ms needs --mode binary\n");
+        return false;
+    }
+    if ((options.fec || options.corrupt > 0) && options.mode != "binary" && options.mode != "window" && options.mode != "stream") {
+        fprintf(stderr, "--fec and --corrupt need --mode binary, window or stream\n");
+        return false;
+    }
+    return options.frames > 0;
+}
+
+// The corners of other panel types, checked while compiling.
+typedef PanelLayout<8, 32, LAYOUT_PROGRESSIVE, LAYOUT_ROTATE_0, LAYOUT_ORIGIN_TOP_LEFT> Progressive8x32;
+typedef PanelLayout<32, 8, LAYOUT_SERPENTINE, LAYOUT_ROTATE_90, LAYOUT_ORIGIN_TOP_LEFT> Sideways8x32;
+typedef PanelLayout<16, 16, LAYOUT_SERPENTINE, LAYOUT_ROTATE_180, LAYOUT_ORIGIN_TOP_LEFT> UpsideDown16x16;
+static_assert(Progressive8x32::index(0) == 0 && Progressive8x32::index(8) == 8 && Progressive8x32::index(255) == 255, "8x32");
+static_assert(Sideways8x32::index(0) == 7 && Sideways8x32::index(1) == 8 && Sideways8x32::index(32) == 6, "8x32 sideways");
+static_assert(UpsideDown16x16::index(255) == 0 && UpsideDown16x16::index(240) == 15 && UpsideDown16x16::index(239) == 31,
+              "16x16 rotated by 180 degrees");
+
+// Every position of a layout must map to a different LED.
+template <typename Layout>
+bool coversEveryLed(const char* name) {
+    std::vector<bool> used(Layout::count, false);
+    for (uint16_t position = 0; position < Layout::count; position++) {
+        uint8_t index = pgm_read_byte(&LayoutTable<Layout>::leds[position]);
+        if (index >= Layout::count || used[index]) {
+            fprintf(stderr, "layout %s: position %u maps to LED %u twice or outside the panel\n", name, position, index);
+            return false;
+        }
+        used[index] = true;
+    }
+    return true;
+}
+
+bool checkLayouts() {
+    // The 16x16 panel as ledIndex computed it before the layout table: serpentine, rows counted from the top, row 0 right to left.
+    for (int position = 0; position < 256; position++) {
+        int row = position >> 4;
+        int column = position & 0x0F;
+        int expected = row * 16 + (row % 2 == 1 ? column : 15 - column);
+        if (ledIndex((uint8_t)position) != expected) {
+            fprintf(stderr, "ledIndex(%d) = %d, the panel is wired as %d\n", position, ledIndex((uint8_t)position), expected);
+            return false;
+        }
+    }
+    return coversEveryLed<Progressive8x32>("8x32") && coversEveryLed<Sideways8x32>("8x32 sideways") &&
+           coversEveryLed<UpsideDown16x16>("16x16 rotated") &&
+           coversEveryLed<PanelLayout<12, 20, LAYOUT_SERPENTINE, LAYOUT_ROTATE_270, LAYOUT_ORIGIN_BOTTOM_RIGHT> >("12x20");
+}
+
+#define FRAME_CHECK(condition)                                                \
+    if (!(condition)) {                                                       \
+        fprintf(stderr, "frame check failed: %s (line %d)\n", #condition, __LINE__); \
+        return false;                                                         \
+    }
+
+bool checkFrames() {
+    static_assert(sizeof(Frame<16, 16>) == 16 * 16 * sizeof(CRGB) + sizeof(CRGB*), "a frame takes 3 bytes per pixel");
+    static_assert(sizeof(IndexedFrame<16, 16, 4>) == 128 && sizeof(IndexedFrame<16, 16, 1>) == 32, "indices are packed");
+
+    Frame<16, 16> frame;
+    frame.fill(CRGB::Blue);
+    frame.row(3).fill(CRGB::Red);
+    frame.span(0, 2).fill(CRGB::White);
+    FRAME_CHECK(frame[0] == CRGB(CRGB::White) && frame[2] == CRGB(CRGB::Blue));
+    FRAME_CHECK(frame.at(3, 0) == CRGB(CRGB::Red) && frame.at(3, 15) == CRGB(CRGB::Red) && frame.at(4, 0) == CRGB(CRGB::Blue));
+
+    // A 4x4 sprite blitted over the top left corner: only its bottom right 2x2 pixels land on the frame.
+    Frame<4, 4> sprite;
+    for (uint16_t position = 0; position < sprite.count; position++) {
+        sprite[position] = CRGB(position, 0, 0);
+    }
+    frame.fill(CRGB::Black);
+    frame.blit(sprite, -2, -2);
+    FRAME_CHECK(frame.at(0, 0) == CRGB(10, 0, 0) && frame.at(1, 1) == CRGB(15, 0, 0) && frame.at(0, 2) == CRGB(CRGB::Black));
+    frame.blit(sprite, 14, 14);
+    FRAME_CHECK(frame.at(15, 15) == CRGB(5, 0, 0) && frame.at(13, 15) == CRGB(CRGB::Black));
+
+    IndexedFrame<16, 16, 4> indexed;
+    indexed.fill(0x0A);
+    FRAME_CHECK(indexed.data()[0] == 0xAA && indexed.get(255) == 0x0A);
+    for (uint16_t position = 0; position < indexed.count; position++) {
+        indexed.set(position, position % 16);
+    }
+    FRAME_CHECK(indexed.data()[0] == 0x01 && indexed.data()[127] == 0xEF);
+    CRGB palette[16];
+    for (uint8_t index = 0; index < 16; index++) {
+        palette[index] = CRGB(0, index, 0);
+    }
+    indexed.expandTo(frame, palette);
+    FRAME_CHECK(frame.at(7, 9) == CRGB(0, 9, 0));
+
+    // The panel view must address the strip exactly as the firmware's ledIndex does.
+    typedef PanelLayout<MATRIX_WIDTH, MATRIX_HEIGHT, MATRIX_WIRING, MATRIX_ROTATION, MATRIX_ORIGIN> Panel;
+    static CRGB strip[Panel::count];
+    PanelView<Panel> panel(strip);
+    for (uint16_t position = 0; position < Panel::count; position++) {
+        FRAME_CHECK(&panel[position] == &strip[ledIndex((uint8_t)position)]);
+    }
+    panel.copyFrom(frame);
+    FRAME_CHECK(strip[ledIndex(7 * 16 + 9)] == CRGB(0, 9, 0));
+    panel.blit(sprite, 15, -1);
+    FRAME_CHECK(panel.at(15, 0) == CRGB(1, 0, 0) && panel.at(15, 2) == CRGB(3, 0, 0) && panel.at(14, 0) == frame.at(14, 0));
+
+    // The back buffer changes nothing until applied, leaves unstaged pixels alone and refuses a 16th color.
+    StagedFrame<16, 16> staged;
+    frame.fill(CRGB::Black);
+    FRAME_CHECK(staged.empty() && staged.stage(5, CRGB::Red) && staged.stage(6, CRGB::Red) && staged.stage(255, CRGB::Green));
+    CRGB color;
+    FRAME_CHECK(staged.get(255, color) && color == CRGB(CRGB::Green) && !staged.get(7, color) && frame[5] == CRGB(CRGB::Black));
+    for (uint8_t i = 2; i < STAGED_FRAME_COLORS; i++) {
+        FRAME_CHECK(staged.stage(100 + i, CRGB(i, i, i)));
+    }
+    FRAME_CHECK(!staged.stage(99, CRGB::Blue) && staged.stage(99, CRGB::Red));
+    staged.applyTo(frame);
+    FRAME_CHECK(staged.empty() && !staged.get(5, color));
+    FRAME_CHECK(frame[5] == CRGB(CRGB::Red) && frame[99] == CRGB(CRGB::Red) && frame[114] == CRGB(14, 14, 14) && frame[7] == CRGB(CRGB::Black));
+    return true;
+}
+
+// A packet of the codec suite: pixel records (position, R, G, B) as a "data:" line and a FRAME_TYPE_PIXELS frame carry them.
+struct CodecPacket {
+    std::vector<uint8_t> records;
+    std::string hex;                   // the records as the hex digits of a "data:" line
+    std::string line;                  // hex followed by the checksum byte, what addChecksumToRow sends
+    std::vector<uint8_t> frame;        // buildFrame of the records, delimiters included
+};
+
+volatile uint32_t codecSink;           // keeps the timed results alive
+
+std::string hexString(const uint8_t* data, size_t length) {
+    static const char digits[] = "0123456789abcdef";
+    std::string hex;
+    for (size_t i = 0; i < length; i++) {
+        hex += digits[data[i] >> 4];
+        hex += digits[data[i] & 0x0F];
+    }
+    return hex;
+}
+
+std::vector<uint8_t> hexBytes(const std::string& hex) {
+    std::vector<uint8_t> bytes;
+    for (size_t i = 0; i + 1 < hex.size(); i += 2) {
+        bytes.push_back((uint8_t)strtoul(hex.substr(i, 2).c_str(), NULL, 16));
+    }
+    return bytes;
+}
+
+CodecPacket codecPacket(const std::vector<uint8_t>& records) {
+    CodecPacket packet;
+    packet.records = records;
+    packet.hex = hexString(records.data(), records.size());
+    uint8_t checksum = onesComplementChecksum(records.data(), (uint8_t)records.size());
+    packet.line = packet.hex + hexString(&checksum, 1);
+    packet.frame = buildFrame(FRAME_TYPE_PIXELS, records.data(), (uint8_t)records.size());
+    return packet;
+}
+
+// R, G, B of every pixel of a frame in position order, the input of frameHash and encodeRle.
+std::vector<uint8_t> frameRgb(uint32_t image[MATRIX_SIZE][MATRIX_SIZE], int frame) {
+    std::vector<uint8_t> rgb;
+    for (int position = 0; position < MATRIX_SIZE * MATRIX_SIZE; position++) {
+        uint32_t color = frameColor(image, frame, position / MATRIX_SIZE, position % MATRIX_SIZE);
+        rgb.push_back((uint8_t)(color >> 16));
+        rgb.push_back((uint8_t)(color >> 8));
+        rgb.push_back((uint8_t)color);
+    }
+    return rgb;
+}
+
+// CODEC_RLE tokens of a whole frame, as encodeRle builds them.
+std::vector<uint8_t> rleTokens(const std::vector<uint8_t>& rgb) {
+    std::vector<uint8_t> tokens;
+    size_t pixels = rgb.size() / 3;
+    for (size_t position = 0; position < pixels;) {
+        size_t run = 1;
+        while (position + run < pixels && run < 255 && std::equal(rgb.begin() + position * 3, rgb.begin() + position * 3 + 3,
+                                                                  rgb.begin() + (position + run) * 3)) {
+            run++;
+        }
+        tokens.push_back((uint8_t)run);
+        tokens.insert(tokens.end(), rgb.begin() + position * 3, rgb.begin() + position * 3 + 3);
+        position += run;
+    }
+    return tokens;
+}
+
+// Splits RLE tokens into FRAME_TYPE_PIXELS_COMPRESSED payloads of whole tokens, as compressedPayloads does.
+std::vector<std::vector<uint8_t> > rlePayloads(const std::vector<uint8_t>& tokens) {
+    std::vector<std::vector<uint8_t> > payloads;
+    int position = 0;
+    for (size_t i = 0; i + 4 <= tokens.size(); i += 4) {
+        if (payloads.empty() || payloads.back().size() + 4 > (size_t)FRAME_MAX_PAYLOAD) {
+            payloads.push_back({(uint8_t)position, CODEC_RLE});
+        }
+        payloads.back().insert(payloads.back().end(), tokens.begin() + i, tokens.begin() + i + 4);
+        position += tokens[i];
+    }
+    return payloads;
+}
+
+uint16_t rgbHash(const std::vector<uint8_t>& rgb) {
+    return crc16Update(0xFFFF, rgb.data(), (uint16_t)rgb.size());
+}
+
+// Decodes a frame's RLE payloads into the firmware's back buffer and compares every pixel with rgb.
+bool rleDecodes(const std::vector<std::vector<uint8_t> >& payloads, const std::vector<uint8_t>& rgb) {
+    abandonPendingFrame();
+    bool valid = true;
+    for (const std::vector<uint8_t>& payload : payloads) {
+        valid = valid && processCompressedFrame(payload.data(), (uint8_t)payload.size(), true);
+    }
+    for (size_t position = 0; valid && position < rgb.size() / 3; position++) {
+        valid = getStagedPixelColor((uint8_t)position) == CRGB(rgb[position * 3], rgb[position * 3 + 1], rgb[position * 3 + 2]);
+    }
+    abandonPendingFrame();
+    return valid;
+}
+
+// Every implementation has to agree on a packet: both bit-string checksums, the byte-native one, the firmware's streaming decoder
+// of "data:" lines, the frame decoder and the pixel writes.
+bool codecPacketAgrees(const CodecPacket& packet) {
+    uint8_t length = (uint8_t)packet.records.size();
+    uint8_t checksum = onesComplementChecksum(packet.records.data(), length);
+    if (legacyStringChecksum(packet.hex) != checksum || legacyCharArrayChecksum(packet.hex) != checksum) {
+        fprintf(stderr, "checksum of %s: std::string %02x, char[] %02x, byte-native %02x\n", packet.hex.c_str(),
+                legacyStringChecksum(packet.hex), legacyCharArrayChecksum(packet.hex), checksum);
+        return false;
+    }
+
+    beginDataLine();
+    for (char c : packet.line) {
+        receiveDataChar(c);
+    }
+    if (dataLength != length + 1 || dataSum != ONES_COMPLEMENT_VALID || !std::equal(packet.records.begin(), packet.records.end(), frameBuffer)) {
+        fprintf(stderr, "data line %s decoded to %u bytes, sum %02x\n", packet.line.c_str(), dataLength, dataSum);
+        return false;
+    }
+
+    uint8_t decoded[FRAME_MAX_PAYLOAD + 3];
+    uint8_t decodedLength = cobsDecode(packet.frame.data() + 1, (uint8_t)(packet.frame.size() - 2), decoded);
+    if (!frameIsValid(decoded, decodedLength) || !std::equal(packet.records.begin(), packet.records.end(), decoded + 2)) {
+        fprintf(stderr, "frame of %s does not decode\n", packet.hex.c_str());
+        return false;
+    }
+
+    abandonPendingFrame();
+    processPixels(packet.records.data(), length / 4);
+    for (uint8_t i = 0; i < length; i += 4) {
+        if (getStagedPixelColor(packet.records[i]) != CRGB(packet.records[i + 1], packet.records[i + 2], packet.records[i + 3])) {
+            fprintf(stderr, "pixel %u of %s not written\n", packet.records[i], packet.hex.c_str());
+            return false;
+        }
+    }
+    abandonPendingFrame();
+    return true;
+}
+
+// Runs `code` on every item, repeating the set until CODEC_MIN_MICROS have passed; returns the time per item.
+template <typename Item, typename Code>
+double nanosPerItem(const std::vector<Item>& items, Code code) {
+    unsigned long rounds = 0;
+    Clock::time_point start = Clock::now();
+    do {
+        for (const Item& item : items) {
+            code(item);
+        }
+        rounds++;
+    } while (elapsedMicros(start) < CODEC_MIN_MICROS);
+    return elapsedMicros(start) * 1000.0 / ((double)rounds * items.size());
+}
+
+void printTiming(const char* name, const char* size, double bytes, double nanos) {
+    printf("%-26s %-22s %10.1f ns %9.1f MB/s\n", name, size, nanos, bytes * 1000.0 / nanos);
+}
+
+// The vectors of codec_vectors.txt: one "<kind> <input hex> <expected hex>" per line, see codec_vectors.txt.
+std::vector<std::string> codecVectors(uint32_t images[][MATRIX_SIZE][MATRIX_SIZE], int imageCount) {
+    std::vector<std::string> lines = {
+        "# Codec vectors checked by bench --mode codec against the host build of the firmware and the benchmark's encoders.",
+        "# Regenerate with: bench --mode codec --write-vectors. One vector per line: <kind> <input hex> <expected hex>.",
+        "# data:  pixel records (position, R, G, B) -> the \"data:\" line payload with its one's complement checksum (addChecksumToRow)",
+        "# frame: pixel records -> the FRAME_TYPE_PIXELS frame with COBS, CRC-8 and delimiters (buildFrame)",
+        "# rle:   R, G, B of a 16x16 frame in position order -> its CODEC_RLE tokens (encodeRle)",
+        "# hash:  R, G, B of a 16x16 frame in position order -> its frame cache key, a CRC-16/CCITT-FALSE (frameHash)",
+    };
+    for (int i = 0; i < imageCount; i++) {
+        for (int frame = 0; frame < MATRIX_SIZE; frame += 5) {
+            for (int linePixels : CODEC_LINE_PIXELS) {
+                std::vector<uint8_t> records(linePixels * 4);
+                runPixels(images[i], frame, (frame * MATRIX_SIZE) % (MATRIX_SIZE * MATRIX_SIZE) / linePixels * linePixels,
+                          linePixels, records.data());
+                CodecPacket packet = codecPacket(records);
+                lines.push_back("data " + packet.hex + " " + packet.line);
+                lines.push_back("frame " + packet.hex + " " + hexString(packet.frame.data(), packet.frame.size()));
+            }
+            std::vector<uint8_t> rgb = frameRgb(images[i], frame);
+            std::vector<uint8_t> tokens = rleTokens(rgb);
+            uint8_t hash[2] = {(uint8_t)(rgbHash(rgb) >> 8), (uint8_t)rgbHash(rgb)};
+            lines.push_back("rle " + hexString(rgb.data(), rgb.size()) + " " + hexString(tokens.data(), tokens.size()));
+            lines.push_back("hash " + hexString(rgb.data(), rgb.size()) + " " + hexString(hash, 2));
+        }
+    }
+    return lines;
+}
+
+// Checks the stored vectors against the encoders of the benchmark and the firmware's decoders.
+bool checkCodecVectors(const std::vector<std::string>& expected) {
+    std::ifstream file(options.vectors);
+    if (!file) {
+        fprintf(stderr, "cannot open %s\n", options.vectors.c_str());
+        return false;
+    }
+    std::vector<std::string> stored;
+    for (std::string line; std::getline(file, line);) {
+        stored.push_back(line);
+    }
+    bool valid = stored == expected;
+    if (!valid) {
+        fprintf(stderr, "%s differs from the firmware and the benchmark encoders; rerun with --write-vectors if the protocol "
+                "changed on purpose\n", options.vectors.c_str());
+    }
+    for (const std::string& line : stored) {
+        std::istringstream fields(line);
+        std::string kind, input, output;
+        fields >> kind >> input >> output;
+        if (kind == "data" || kind == "frame") {
+            valid = codecPacketAgrees(codecPacket(hexBytes(input))) && valid;
+        } else if (kind == "rle" && !rleDecodes(rlePayloads(hexBytes(output)), hexBytes(input))) {
+            fprintf(stderr, "rle vector does not decode to its frame\n");
+            valid = false;
+        }
+    }
+    return valid;
+}
+
+bool runCodecSuite() {
+    const int imageCount = sizeof(CODEC_IMAGES) / sizeof(CODEC_IMAGES[0]);
+    static uint32_t images[imageCount][MATRIX_SIZE][MATRIX_SIZE];
+    for (int i = 0; i < imageCount; i++) {
+        if (!loadImage(options.corpus, CODEC_IMAGES[i], images[i])) {
+            return false;
+        }
+    }
+
+    std::vector<std::string> vectors = codecVectors(images, imageCount);
+    if (options.writeVectors) {
+        std::ofstream file(options.vectors);
+        for (const std::string& line : vectors) {
+            file << line << "\n";
+        }
+        printf("%zu vectors written to %s\n", vectors.size(), options.vectors.c_str());
+    }
+    bool valid = checkCodecVectors(vectors);
+
+    // Packets of every line size from every rotation of every image, and the whole frames.
+    std::vector<std::vector<uint8_t> > rgbFrames;
+    std::vector<std::vector<std::vector<uint8_t> > > rleFrames;
+    for (int i = 0; i < imageCount; i++) {
+        for (int frame = 0; frame < MATRIX_SIZE; frame++) {
+            rgbFrames.push_back(frameRgb(images[i], frame));
+            rleFrames.push_back(rlePayloads(rleTokens(rgbFrames.back())));
+            valid = rleDecodes(rleFrames.back(), rgbFrames.back()) && valid;
+        }
+    }
+    printf("%-26s %-22s %13s %14s\n", "codec", "packet", "time", "throughput");
+    for (int linePixels : CODEC_LINE_PIXELS) {
+        std::vector<CodecPacket> packets;
+        for (int i = 0; i < imageCount; i++) {
+            for (int frame = 0; frame < MATRIX_SIZE; frame++) {
+                for (int first = 0; first < MATRIX_SIZE * MATRIX_SIZE; first += linePixels) {
+                    std::vector<uint8_t> records(linePixels * 4);
+                    runPixels(images[i], frame, first, linePixels, records.data());
+                    packets.push_back(codecPacket(records));
+                }
+            }
+        }
+        for (size_t i = 0; valid && i < packets.size(); i++) {
+            valid = codecPacketAgrees(packets[i]);
+        }
+
+        double bytes = linePixels * 4;
+        char size[40];
+        snprintf(size, sizeof(size), "%d pixels (%d+1 B)", linePixels, linePixels * 4);
+        double stringNanos = nanosPerItem(packets, [](const CodecPacket& p) { codecSink += legacyStringChecksum(p.hex); });
+        double charArrayNanos = nanosPerItem(packets, [](const CodecPacket& p) { codecSink += legacyCharArrayChecksum(p.hex); });
+        double byteNanos = nanosPerItem(packets, [](const CodecPacket& p) {
+            codecSink += onesComplementChecksum(p.records.data(), (uint8_t)p.records.size());
+        });
+        printTiming("checkSum std::string", size, bytes, stringNanos);
+        printTiming("checkSum char[]", size, bytes, charArrayNanos);
+        printTiming("onesComplementChecksum", size, bytes, byteNanos);
+        printTiming("receiveDataChar (hex+sum)", size, bytes, nanosPerItem(packets, [](const CodecPacket& p) {
+            beginDataLine();
+            for (char c : p.line) {
+                receiveDataChar(c);
+            }
+            codecSink += dataSum;
+        }));
+        printTiming("crc8", size, bytes, nanosPerItem(packets, [](const CodecPacket& p) {
+            codecSink += crc8(p.records.data(), (uint8_t)p.records.size());
+        }));
+        printTiming("cobsDecode+frameIsValid", size, bytes, nanosPerItem(packets, [](const CodecPacket& p) {
+            uint8_t decoded[FRAME_MAX_PAYLOAD + 3];
+            uint8_t length = cobsDecode(p.frame.data() + 1, (uint8_t)(p.frame.size() - 2), decoded);
+            codecSink += frameIsValid(decoded, length);
+        }));
+        printTiming("processPixels", size, bytes, nanosPerItem(packets, [](const CodecPacket& p) {
+            processPixels(p.records.data(), (uint8_t)(p.records.size() / 4));
+        }));
+        abandonPendingFrame();
+
+        if (byteNanos * CODEC_MIN_SPEEDUP > std::min(stringNanos, charArrayNanos)) {
+            fprintf(stderr, "onesComplementChecksum takes %.1f ns for %s, less than %.0fx faster than the bit-string checksums\n",
+                    byteNanos, size, CODEC_MIN_SPEEDUP);
+            valid = false;
+        }
+    }
+
+    const double frameBytes = MATRIX_SIZE * MATRIX_SIZE * 3;
+    printTiming("RLE processCompressedFrame", "16x16 frame (768 B)", frameBytes, nanosPerItem(rleFrames,
+        [](const std::vector<std::vector<uint8_t> >& payloads) {
+            for (const std::vector<uint8_t>& payload : payloads) {
+                codecSink += processCompressedFrame(payload.data(), (uint8_t)payload.size(), true);
+            }
+        }));
+    abandonPendingFrame();
+    printTiming("crc16 (frame hash)", "16x16 frame (768 B)", frameBytes, nanosPerItem(rgbFrames, [](const std::vector<uint8_t>& rgb) {
+        codecSink += rgbHash(rgb);
+    }));
+    return valid;
+}
+
+}  // namespace
+// Collects the lines of a report that is produced without the link, each ended with a newline like sendReply does.
+std::string reportText;
+
+void collectReply(const char* reply) {
+    reportText += reply;
+    reportText += '\n';
+}
+
+// Slots of the "msg:" lines: text commands, the binary frames by FRAME_TYPE_* and "data:" lines right after the last frame type.
+const int PERF_SLOTS = 1 + FRAME_TYPE_STREAM + 1;
+
+bool checkPerfSlots() {
+    // Type t is recorded t + 1 times, so a type sharing a slot with another, or dropped, shows up with the wrong count.
+    perfStatsReset();
+    for (int type = 0; type <= PERF_SLOTS; type++) {
+        for (int i = 0; i <= type; i++) {
+            perfMessageAdd((uint8_t)type, micros());
+        }
+    }
+    reportText.clear();
+    perfStatsReport(collectReply);
+    for (int type = 0; type <= PERF_SLOTS; type++) {
+        char line[24];
+        snprintf(line, sizeof(line), "\nmsg:%d:%d:", type, type + 1);
+        bool found = reportText.find(line) != std::string::npos;
+        if (found != (type < PERF_SLOTS)) {
+            fprintf(stderr, "message type %d %s\n%s", type, found ? "beyond the data slot was counted" : "has no slot of its own",
+                    reportText.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseOptions(argc, argv)) {
+        return 2;
+    }
+    if (options.mode == "layout") {
+        bool valid = checkLayouts();
+        printf("layouts %s\n", valid ? "valid" : "INVALID");
+        return valid ? 0 : 1;
+    }
+    if (options.mode == "frame") {
+        bool valid = checkFrames();
+        printf("frames %s\n", valid ? "valid" : "INVALID");
+        return valid ? 0 : 1;
+    }
+    if (options.mode == "perf") {
+        bool valid = checkPerfSlots();
+        printf("perf slots %s\n", valid ? "valid" : "INVALID");
+        return valid ? 0 : 1;
+    }
+    if (options.mode == "codec") {
+        bool valid = runCodecSuite();
+        printf("codecs %s\n", valid ? "valid" : "INVALID");
+        return valid ? 0 : 1;
+    }
+    static uint32_t image[MATRIX_SIZE][MATRIX_SIZE];
+    if (!loadImage(options.corpus, options.image, image)) {
+        return 2;
+    }
+
+    unsigned caps = 0;
+    if (options.mode == "binary") {
+        caps = PROTO_CAP_BINARY_FRAMES | PROTO_CAP_TAGGED_REPLIES;
+        taggedReplies = true;
+    } else if (options.mode == "animation") {
+        caps = PROTO_CAP_BINARY_FRAMES;
+    } else if (options.mode == "window") {
+        caps = PROTO_CAP_BINARY_FRAMES | PROTO_CAP_WINDOW;
+    } else if (options.mode == "stream") {
+        caps = PROTO_CAP_BINARY_FRAMES | PROTO_CAP_STREAM;
+    }
+    if (options.flowControl) {
+        caps |= PROTO_CAP_FLOW_CONTROL;
+    }
+    if (options.fec) {
+        caps |= PROTO_CAP_FEC;
+        fecFrames = true;
+    }
+    if (options.cache) {
+        caps |= PROTO_CAP_CACHE;
+    }
+    if (options.linkSpeed) {
+        caps |= PROTO_CAP_LINK_SPEED;
+    }
+
+    if (options.mode == "stream") {
+        int frames = options.frames;
+        FastLED.onShow = [frames]() { checkStreamRefresh(image, frames); };
+    }
+    hostLinkOpen(options.baud);
+    std::thread firmware(firmwareMain);
+
+    int verified = 0;
+    int cacheHits = 0;
+    int linkSpeedCode = LINK_BAUD_DEFAULT_CODE;
+    Clock::time_point start = Clock::now();
+    double uploadSeconds = 0;
+    double seconds = 0;
+    if (options.mode == "animation") {
+        // Playback is timed from the refresh of the first frame to that of the last; the link stays silent meanwhile.
+        unsigned long showsBefore = FastLED.shows;
+        bool playing = handshake(caps) && uploadAnimation(image, options.frames);
+        uploadSeconds = elapsedMicros(start) / 1e6;
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(options.timeoutMillis * options.frames);
+        auto waitForShows = [&](unsigned long count) {
+            while (playing && FastLED.shows - showsBefore < count && Clock::now() < deadline) {
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+            }
+        };
+        waitForShows(1);
+        start = Clock::now();
+        waitForShows(options.frames);
+        if (playing && FastLED.shows - showsBefore == (unsigned long)options.frames && verifyFrame(image, options.frames - 1)) {
+            verified = options.frames;
+        }
+    }
+    if (options.mode == "effect") {
+        // Timed from the first rendered frame to the last; then the effect must stop on fx-stop and leave a varied picture.
+        unsigned long showsBefore = FastLED.shows;
+        bool running = sendEffectCommand(EFFECT_BENCH_COMMAND);
+        uploadSeconds = elapsedMicros(start) / 1e6;
+        Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(options.timeoutMillis * options.frames);
+        while (running && FastLED.shows == showsBefore && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        start = Clock::now();
+        while (running && FastLED.shows - showsBefore < (unsigned long)options.frames && Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        seconds = elapsedMicros(start) / 1e6;
+        bool rendered = running && FastLED.shows - showsBefore >= (unsigned long)options.frames;
+        bool stopped = rendered && sendEffectCommand("fx-stop");
+        unsigned long showsStopped = FastLED.shows;
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        bool varied = std::any_of(leds + 1, leds + MATRIX_SIZE * MATRIX_SIZE, [](const CRGB& led) { return led != leds[0]; });
+        if (stopped && FastLED.shows == showsStopped && varied) {
+            verified = options.frames;
+        } else {
+            fprintf(stderr, "effect %s, %s, %s\n", rendered ? "rendered" : "not rendered", stopped ? "stopped" : "not stopped",
+                    varied ? "varied" : "uniform");
+        }
+    }
+    if (options.mode == "stream") {
+        // Every frame is either shown or dropped, never lost silently; without corruption, or with FEC, all are shown. A dropped frame
+        // may leave some of its chunks in leds[], so the last shown frame is checked as it was refreshed, and no refresh may be torn.
+        StreamReport report;
+        if (handshake(caps)) {
+            streamRefreshesChecked = true;
+            report = streamFrames(image, options.frames);
+            streamRefreshesChecked = false;
+        }
+        int lastShown = options.frames - 1 - ((options.frames - 1 - report.lastShown) & 0xFF);  // sequence numbers wrap after 255
+        bool lastIntact = report.lastShown >= 0 && verifyFrame(image, lastShown, FastLED.shown.data());
+        if (report.shown + report.dropped == options.frames && lastIntact && tornRefreshes == 0 &&
+            ((options.corrupt > 0 && !options.fec) || report.shown == options.frames)) {
+            verified = options.frames;
+        } else {
+            fprintf(stderr, "stream: %d shown, %d dropped in %d reports, last shown %d, %d torn refreshes\n", report.shown, report.dropped,
+                    report.reports, report.lastShown, tornRefreshes.load());
+        }
+        printf("stream reports      %d, %d frames shown, %d dropped\n", report.reports, report.shown, report.dropped);
+    }
+    for (int frame = 0; frame < options.frames && options.mode != "animation" && options.mode != "effect" && options.mode != "stream";
+         frame++) {
+        if (options.abort) {
+            // The broken-off transfer must leave the committed frame in leds[] and on the LEDs.
+            unsigned long showsBefore = FastLED.shows;
+            bool broken = handshake(caps) && sendStopAndWait(image, frame + 1, options.mode == "binary", MATRIX_SIZE * MATRIX_SIZE / 2);
+            if (!broken || FastLED.shows != showsBefore || (frame > 0 && !verifyFrame(image, frame - 1))) {
+                fprintf(stderr, "frame %d: broken-off transfer reached the panel\n", frame);
+                continue;
+            }
+        }
+        int shown = options.cache ? frame % CACHE_BENCH_FRAMES : frame;
+        bool sent = handshake(caps);
+        if (sent && options.linkSpeed && linkSpeedCode <= LINK_BAUD_DEFAULT_CODE) {
+            linkSpeedCode = negotiateLinkSpeed();
+            sent = linkSpeedCode > LINK_BAUD_DEFAULT_CODE;
+        }
+        if (sent && options.cache && showCached(image, shown)) {
+            cacheHits++;
+            verified += verifyFrame(image, shown) ? 1 : 0;
+            continue;
+        }
+        if (sent && options.fec && options.mode == "binary" && frame == 0) {
+            sent = rejectsShortFrame();
+        }
+        if (sent) {
+            if (options.mode == "window") {
+                sent = sendWindowed(image, shown, 16);
+            } else {
+                sent = sendStopAndWait(image, shown, options.mode == "binary");
+            }
+        }
+        sent = sent && terminate();
+        sent = sent && (!options.cache || putCached(image, shown));
+        if (sent && verifyFrame(image, shown)) {
+            verified++;
+        }
+    }
+    if (options.mode != "effect") {
+        seconds = elapsedMicros(start) / 1e6;
+    }
+    HostLinkCounters link = hostLinkCounters();
+    DriverStats transfer = stats;
+
+    std::string firmwareStats = options.stats ? queryReport("stats", "stats-end") : "";
+    std::string firmwareTrace = options.trace ? queryReport("trace", "trace-end") : "";
+
+    firmwareRunning = false;
+    firmware.join();
+    hostLinkClose();
+
+    double fps = (options.mode == "animation" || options.mode == "effect" ? options.frames - 1 : options.frames) / seconds;
+    printf("mode %s, %lu baud, %d frames of %s%s%s%s%s%s%s%s\n", options.mode.c_str(), options.baud, options.frames, options.image.c_str(),
+           options.flowControl ? ", flow control" : "", options.syncCommit ? ", synchronised commit" : "", options.fec ? ", FEC" : "",
+           options.abort ? ", broken-off transfers" : "", options.cache ? ", frame cache" : "", options.linkSpeed ? ", link speed" : "",
+           options.adaptiveRto ? ", adaptive retransmission timeout" : "");
+    printf("frames verified     %d/%d\n", verified, options.frames);
+    if (options.cache) {
+        printf("cache hits          %d of %d frames\n", cacheHits, options.frames);
+    }
+    if (options.mode == "animation") {
+        printf("upload              %.3f s, then played without link traffic\n", uploadSeconds);
+    } else if (options.mode == "effect") {
+        printf("effect start        %.3f s for \"%s\", then rendered without link traffic\n", uploadSeconds, EFFECT_BENCH_COMMAND);
+    }
+    printf("frames/s            %.3f (%.1f ms/frame)\n", fps, 1000.0 / fps);
+    printf("bytes/frame         %.1f to device, %.1f from device\n", (double)link.bytesToDevice / options.frames,
+           (double)link.bytesFromDevice / options.frames);
+    printf("messages/frame      %.1f, retries %lu, corrupted %lu, lost %lu\n", (double)transfer.messages / options.frames,
+           transfer.retries, transfer.corrupted, transfer.lost);
+    if (options.jitterMillis > 0) {
+        printf("reply jitter        up to %d ms, %lu late confirmations dropped\n", options.jitterMillis, transfer.staleConfirmations);
+    }
+    double tailMillis = 0;
+    if (!exchangeMillis.empty()) {
+        std::sort(exchangeMillis.begin(), exchangeMillis.end());
+        tailMillis = exchangeMillis.back();
+        printf("row exchange        p50 %.1f ms, p99 %.1f ms, max %.1f ms", exchangeMillis[exchangeMillis.size() / 2],
+               exchangeMillis[(exchangeMillis.size() - 1) * 99 / 100], tailMillis);
+        if (options.adaptiveRto) {
+            printf(", srtt %.1f ms, timeout %lu ms", retransmitTimer.srttMillis, retransmitTimer.timeoutMillis());
+        }
+        printf("\n");
+    }
+    printf("reply turnaround    avg %.0f us, max %.0f us\n", transfer.replies ? transfer.turnaroundTotalMicros / transfer.replies : 0.0,
+           transfer.turnaroundMaxMicros);
+    printf("firmware per msg    %.1f us host CPU, %.0f us wall incl. link and show\n",
+           transfer.messages ? busyCpuMicros / transfer.messages : 0.0, transfer.messages ? busyWallMicros / transfer.messages : 0.0);
+    printf("firmware busy loop  %lu calls, max %.0f us wall\n", busyLoops, busyWallMaxMicros);
+    printf("bytes dropped       %lu buffer overflow, %lu during write, %lu during show\n", link.droppedOverflow, link.droppedDuringWrite,
+           link.droppedDuringShow);
+    if (options.stats) {
+        printf("firmware stats\n%s", firmwareStats.c_str());
+    }
+    if (options.trace) {
+        printf("firmware trace\n%s", firmwareTrace.c_str());
+    }
+
+    if (verified != options.frames || fps < options.minFps) {
+        return 1;
+    }
+    if (options.linkSpeed && (link.baudChanges != 1 || hostDeviceBaud() != LINK_BAUD_RATES[linkSpeedCode])) {
+        fprintf(stderr, "link speed changed %lu times, now %lu baud\n", link.baudChanges, hostDeviceBaud());
+        return 1;
+    }
+    if (options.cache && cacheHits != std::max(0, options.frames - CACHE_BENCH_FRAMES)) {
+        fprintf(stderr, "%d cache hits, expected %d\n", cacheHits, std::max(0, options.frames - CACHE_BENCH_FRAMES));
+        return 1;
+    }
+    if (options.maxTailMillis > 0 && tailMillis > options.maxTailMillis) {
+        fprintf(stderr, "slowest row exchange took %.1f ms, allowed %.1f ms\n", tailMillis, options.maxTailMillis);
+        return 1;
+    }
+    if (transfer.misattributed > 0) {
+        fprintf(stderr, "%lu parts confirmed by replies to other parts\n", transfer.misattributed);
+        return 1;
+    }
+    if (options.jitterMillis > 0 && transfer.staleConfirmations == 0) {
+        fprintf(stderr, "no reply arrived late; --jitter-ms must exceed the retransmission timeout\n");
+        return 1;
+    }
+    if (options.fec && transfer.corrupted > 0 && transfer.retries > 0) {
+        fprintf(stderr, "%lu corrupted frames, but %lu resends with FEC\n", transfer.corrupted, transfer.retries);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,146 @@
+// Host implementations of the Arduino core functions declared in stubs/Arduino.h and the FastLED helpers declared in stubs/FastLED.h.
+#include "Arduino.h"
+#include "EEPROM.h"
+#include "FastLED.h"
+
+#include <chrono>
+#include <thread>
+
+#include <math.h>
+
+namespace {
+
+const std::chrono::steady_clock::time_point bootTime = std::chrono::steady_clock::now();
+
+}  // namespace
+
+HardwareSerial Serial;
+CFastLED FastLED;
+EEPROMClass EEPROM;
+
+unsigned long millis() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+unsigned long micros() {
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - bootTime).count();
+}
+
+void delay(unsigned long ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(unsigned int us) {
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+size_t HardwareSerial::write(uint8_t c) {
+    static const bool echo = getenv("HOST_SERIAL_ECHO") != nullptr;
+    if (echo) {
+        fputc(c, stderr);
+    }
+    return 1;
+}
+
+uint8_t scale8(uint8_t value, uint8_t scale) {
+    return (uint8_t)(((uint16_t)value * (1 + scale)) >> 8);
+}
+
+uint8_t qadd8(uint8_t a, uint8_t b) {
+    return a + b > 255 ? 255 : a + b;
+}
+
+uint8_t qsub8(uint8_t a, uint8_t b) {
+    return a > b ? a - b : 0;
+}
+
+uint8_t sin8(uint8_t theta) {
+    return (uint8_t)lround(127.5 + 127.5 * sin(theta * 2 * M_PI / 256));
+}
+
+uint8_t cos8(uint8_t theta) {
+    return sin8(theta + 64);
+}
+
+namespace {
+
+uint8_t noiseLattice(int x, int y, int z) {
+    uint32_t hash = (uint32_t)x * 73856093u ^ (uint32_t)y * 19349663u ^ (uint32_t)z * 83492791u;
+    hash ^= hash >> 13;
+    hash *= 0x5bd1e995u;
+    return (uint8_t)(hash >> 24);
+}
+
+double smooth(double t) {
+    return t * t * (3 - 2 * t);
+}
+
+}  // namespace
+
+// Value noise on a lattice of 256 units, smoothly interpolated; FastLED uses Perlin gradient noise with the same scale.
+uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z) {
+    int cells[3] = {x >> 8, y >> 8, z >> 8};
+    double weights[3] = {smooth((x & 0xFF) / 256.0), smooth((y & 0xFF) / 256.0), smooth((z & 0xFF) / 256.0)};
+    double value = 0;
+    for (int corner = 0; corner < 8; corner++) {
+        double weight = 1;
+        int point[3];
+        for (int axis = 0; axis < 3; axis++) {
+            bool upper = (corner >> axis) & 1;
+            point[axis] = cells[axis] + upper;
+            weight *= upper ? weights[axis] : 1 - weights[axis];
+        }
+        value += weight * noiseLattice(point[0], point[1], point[2]);
+    }
+    return (uint8_t)lround(value);
+}
+
+CRGB::CRGB(const CHSV& hsv) {
+    // Plain HSV spectrum; FastLED's hsv2rgb_rainbow shifts yellow a little, which the effects do not depend on.
+    uint8_t region = hsv.h / 43;
+    uint8_t remainder = (hsv.h - region * 43) * 6;
+    uint8_t p = scale8(hsv.v, 255 - hsv.s);
+    uint8_t q = scale8(hsv.v, 255 - scale8(hsv.s, remainder));
+    uint8_t t = scale8(hsv.v, 255 - scale8(hsv.s, 255 - remainder));
+    switch (region) {
+        case 0: r = hsv.v; g = t; b = p; break;
+        case 1: r = q; g = hsv.v; b = p; break;
+        case 2: r = p; g = hsv.v; b = t; break;
+        case 3: r = p; g = q; b = hsv.v; break;
+        case 4: r = t; g = p; b = hsv.v; break;
+        default: r = hsv.v; g = p; b = q; break;
+    }
+}
+
+const TProgmemRGBPalette16 RainbowColors_p = {0xFF0000, 0xD52A00, 0xAB5500, 0xAB7F00, 0xABAB00, 0x56D500, 0x00FF00, 0x00D52A,
+                                              0x00AB55, 0x0056AA, 0x0000FF, 0x2A00D5, 0x5500AB, 0x7F0081, 0xAB0055, 0xD5002B};
+const TProgmemRGBPalette16 PartyColors_p = {0x5500AB, 0x84007C, 0xB5004B, 0xE5001B, 0xE81700, 0xB84700, 0xAB7700, 0xABAB00,
+                                            0xAB5500, 0xDD2200, 0xF2000E, 0xC2003E, 0x8F0071, 0x5F00A1, 0x2F00D0, 0x0007F9};
+const TProgmemRGBPalette16 OceanColors_p = {0x191970, 0x00008B, 0x191970, 0x000080, 0x00008B, 0x0000CD, 0x2E8B57, 0x008080,
+                                            0x5F9EA0, 0x0000FF, 0x008B8B, 0x6495ED, 0x7FFFD4, 0x2E8B57, 0x00FFFF, 0x87CEFA};
+const TProgmemRGBPalette16 ForestColors_p = {0x006400, 0x006400, 0x556B2F, 0x006400, 0x008000, 0x228B22, 0x6B8E23, 0x008000,
+                                             0x2E8B57, 0x66CDAA, 0x32CD32, 0x9ACD32, 0x90EE90, 0x7CFC00, 0x66CDAA, 0x228B22};
+const TProgmemRGBPalette16 LavaColors_p = {0x000000, 0x800000, 0x000000, 0x800000, 0x8B0000, 0x800000, 0x8B0000, 0x8B0000,
+                                           0x8B0000, 0xFF0000, 0xFFA500, 0xFFFFFF, 0xFFA500, 0xFF0000, 0x8B0000, 0x000000};
+const TProgmemRGBPalette16 HeatColors_p = {0x000000, 0x330000, 0x660000, 0x990000, 0xCC0000, 0xFF0000, 0xFF3300, 0xFF6600,
+                                           0xFF9900, 0xFFCC00, 0xFFFF00, 0xFFFF33, 0xFFFF66, 0xFFFF99, 0xFFFFCC, 0xFFFFFF};
+const TProgmemRGBPalette16 CloudColors_p = {0x0000FF, 0x00008B, 0x00008B, 0x00008B, 0x00008B, 0x00008B, 0x00008B, 0x00008B,
+                                            0x0000FF, 0x00008B, 0x87CEEB, 0x87CEEB, 0xADD8E6, 0xFFFFFF, 0xADD8E6, 0x87CEEB};
+
+CRGB ColorFromPalette(const TProgmemRGBPalette16& palette, uint8_t index, uint8_t brightness, TBlendType blendType) {
+    CRGB low(palette[index >> 4]);
+    CRGB color = low;
+    uint8_t fraction = (index & 0x0F) << 4;
+    if (blendType == LINEARBLEND && fraction != 0) {
+        CRGB high(palette[((index >> 4) + 1) & 0x0F]);
+        color.r = scale8(low.r, 255 - fraction) + scale8(high.r, fraction);
+        color.g = scale8(low.g, 255 - fraction) + scale8(high.g, fraction);
+        color.b = scale8(low.b, 255 - fraction) + scale8(high.b, fraction);
+    }
+    if (brightness != 255) {
+        color.r = scale8(color.r, brightness);
+        color.g = scale8(color.g, brightness);
+        color.b = scale8(color.b, brightness);
+    }
+    return color;
+}
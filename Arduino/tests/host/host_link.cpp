@@ -0,0 +1,207 @@
+#include "host_link.h"
+
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <errno.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+int deviceFd = -1;
+int driverFd = -1;
+unsigned long linkBaud = 0;
+unsigned long deviceBaud = 0;
+std::deque<uint8_t> deviceRx;
+HostLinkCounters counters;
+
+// Arrival time of every paced byte the driver sent and the device has not read from the socket yet, in order. A host thread can
+// run late, so what the device could not receive is decided by these times rather than by when the device looks at the socket.
+std::mutex arrivalsMutex;
+std::deque<Clock::time_point> deviceArrivals;
+
+// Writes bytes paced at the link rate and returns the time the last stop bit left, like a blocking UART write; with
+// `recordArrivals` the time every byte reaches the device is queued in deviceArrivals first.
+Clock::time_point pacedSend(int fd, const uint8_t* data, size_t length, bool recordArrivals) {
+    if (linkBaud == 0) {
+        while (length > 0) {
+            ssize_t sent = send(fd, data, length, 0);
+            if (sent < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                perror("host link send");
+                exit(1);
+            }
+            data += sent;
+            length -= sent;
+        }
+        return Clock::now();
+    }
+
+    // A byte reaches the receiver with its stop bit, so it is handed over at the end of its byte time.
+    const std::chrono::nanoseconds byteTime(10ull * 1000000000ull / linkBaud);
+    Clock::time_point start = Clock::now();
+    for (size_t i = 0; i < length; i++) {
+        std::this_thread::sleep_until(start + byteTime * (i + 1));
+        if (recordArrivals) {
+            std::lock_guard<std::mutex> lock(arrivalsMutex);
+            deviceArrivals.push_back(start + byteTime * (i + 1));
+        }
+        if (send(fd, data + i, 1, 0) != 1) {
+            perror("host link send");
+            exit(1);
+        }
+    }
+    return start + byteTime * length;
+}
+
+// Takes the arrival time of the next byte read from the device's socket; paced links only.
+Clock::time_point nextArrival() {
+    std::lock_guard<std::mutex> lock(arrivalsMutex);
+    Clock::time_point arrival = deviceArrivals.front();
+    deviceArrivals.pop_front();
+    return arrival;
+}
+
+// Queues a received byte in the device's receive buffer, dropping it if the buffer is full.
+void receiveByte(uint8_t byte) {
+    if (linkBaud == 0 || deviceRx.size() < HOST_LINK_RX_BUFFER) {
+        deviceRx.push_back(byte);
+    } else {
+        counters.droppedOverflow++;
+    }
+}
+
+// Moves the bytes waiting in the socket into the device's receive buffer, dropping what does not fit.
+void pumpDevice() {
+    uint8_t buffer[256];
+    for (;;) {
+        ssize_t received = recv(deviceFd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received <= 0) {
+            return;
+        }
+        for (ssize_t i = 0; i < received; i++) {
+            if (linkBaud != 0) {
+                nextArrival();
+            }
+            receiveByte(buffer[i]);
+        }
+    }
+}
+
+// Discards the bytes waiting in the socket that arrived before `deaf`, while the device could not receive; bytes that arrived
+// later are received as usual.
+unsigned long discardDevice(Clock::time_point deaf) {
+    if (linkBaud == 0) {
+        pumpDevice();
+        return 0;
+    }
+    uint8_t buffer[256];
+    unsigned long discarded = 0;
+    for (;;) {
+        ssize_t received = recv(deviceFd, buffer, sizeof(buffer), MSG_DONTWAIT);
+        if (received <= 0) {
+            return discarded;
+        }
+        for (ssize_t i = 0; i < received; i++) {
+            if (nextArrival() <= deaf) {
+                discarded++;
+            } else {
+                receiveByte(buffer[i]);
+            }
+        }
+    }
+}
+
+}  // namespace
+
+void hostLinkOpen(unsigned long baud) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        perror("socketpair");
+        exit(1);
+    }
+    deviceFd = fds[0];
+    driverFd = fds[1];
+    linkBaud = baud;
+    deviceRx.clear();
+    deviceArrivals.clear();
+    counters = HostLinkCounters();
+}
+
+void hostLinkClose() {
+    close(deviceFd);
+    close(driverFd);
+    deviceFd = driverFd = -1;
+}
+
+void hostDeviceBegin(unsigned long baud) {
+    if (deviceBaud != 0 && baud != deviceBaud) {
+        counters.baudChanges++;
+    }
+    deviceBaud = baud;
+}
+
+unsigned long hostDeviceBaud() {
+    return deviceBaud;
+}
+
+HostLinkCounters& hostLinkCounters() {
+    return counters;
+}
+
+int hostDeviceAvailable() {
+    pumpDevice();
+    return (int)deviceRx.size();
+}
+
+int hostDeviceRead() {
+    pumpDevice();
+    if (deviceRx.empty()) {
+        return -1;
+    }
+    uint8_t c = deviceRx.front();
+    deviceRx.pop_front();
+    counters.deviceBytesRead++;
+    return c;
+}
+
+void hostDeviceWrite(const uint8_t* data, size_t length, bool blocksReceive) {
+    pumpDevice();
+    Clock::time_point end = pacedSend(deviceFd, data, length, false);
+    counters.bytesFromDevice += length;
+    if (blocksReceive) {
+        counters.droppedDuringWrite += discardDevice(end);
+    }
+}
+
+void hostDeviceInterruptsOff(unsigned long micros) {
+    pumpDevice();
+    Clock::time_point end = Clock::now() + std::chrono::microseconds(micros);
+    std::this_thread::sleep_until(end);
+    counters.droppedDuringShow += discardDevice(end);
+}
+
+void hostDriverWrite(const uint8_t* data, size_t length) {
+    pacedSend(driverFd, data, length, linkBaud != 0);
+    counters.bytesToDevice += length;
+}
+
+size_t hostDriverRead(uint8_t* buffer, size_t capacity, unsigned long timeoutMicros) {
+    struct pollfd descriptor = {driverFd, POLLIN, 0};
+    int ready = poll(&descriptor, 1, (int)((timeoutMicros + 999) / 1000));
+    if (ready <= 0) {
+        return 0;
+    }
+    ssize_t received = recv(driverFd, buffer, capacity, MSG_DONTWAIT);
+    return received > 0 ? (size_t)received : 0;
+}
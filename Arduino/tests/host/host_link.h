@@ -0,0 +1,45 @@
+// Simulated serial link between the host build of the firmware and the benchmark driver.
+//
+// The two ends are a socketpair. Every byte takes 10 bit times (start, 8 data, stop) at the configured baud rate, so writes are paced
+// like a UART and the receive side models what the Uno's serial libraries would see:
+// - the receive buffer of SoftwareSerial/AltSoftSerial holds HOST_LINK_RX_BUFFER bytes; bytes that arrive while it is full are dropped,
+// - SoftwareSerial transmits with interrupts disabled, so bytes arriving during its own writes are dropped (half duplex),
+// - FastLED.show disables interrupts as well, so bytes arriving during a refresh are dropped.
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define HOST_LINK_RX_BUFFER 64        // _SS_MAX_RX_BUFF of SoftwareSerial
+
+struct HostLinkCounters {
+    unsigned long bytesToDevice;       // bytes the driver wrote
+    unsigned long bytesFromDevice;     // bytes the firmware wrote
+    unsigned long droppedOverflow;     // lost because the receive buffer was full
+    unsigned long droppedDuringWrite;  // lost while SoftwareSerial was transmitting
+    unsigned long droppedDuringShow;   // lost while FastLED.show had interrupts disabled
+    unsigned long deviceBytesRead;     // bytes the firmware consumed, used to tell idle from busy loop() calls
+    unsigned long baudChanges;         // times the firmware restarted its transport at a different rate
+};
+
+// Creates the socketpair. Both ends are paced at `baud` whatever rate the firmware configures, so one build can be measured at any
+// rate; baud = 0 is an ideal link without pacing or losses, which measures the firmware alone.
+void hostLinkOpen(unsigned long baud);
+void hostLinkClose();
+HostLinkCounters& hostLinkCounters();
+
+// Device end, used by the SoftwareSerial/AltSoftSerial stand-ins.
+// Records the rate the firmware asked for, see hostDeviceBaud.
+void hostDeviceBegin(unsigned long baud);
+unsigned long hostDeviceBaud();
+int hostDeviceAvailable();
+int hostDeviceRead();
+// blocksReceive: the transport cannot receive while it transmits (SoftwareSerial).
+void hostDeviceWrite(const uint8_t* data, size_t length, bool blocksReceive);
+// Stops receiving for the given time, as FastLED.show does with interrupts disabled.
+void hostDeviceInterruptsOff(unsigned long micros);
+
+// Driver end, used by the benchmark.
+void hostDriverWrite(const uint8_t* data, size_t length);
+// Reads whatever arrives within timeoutMicros; returns the number of bytes copied into buffer.
+size_t hostDriverRead(uint8_t* buffer, size_t capacity, unsigned long timeoutMicros);
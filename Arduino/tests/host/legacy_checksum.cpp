@@ -0,0 +1,34 @@
+// The bit-string checksums the firmware and the app used before the byte-native one's complement sum of checksumbin.h: the
+// std::string version of checksum.cpp and the char-array version of libs/checksum.h, both compiled unchanged. bench --mode codec
+// times them and checks that all implementations agree byte for byte.
+#define main checksumDemoMain
+#include "../checksum.cpp"
+#undef main
+#include "../libs/checksum.h"
+
+#include <stdint.h>
+
+namespace {
+
+uint8_t bitStringValue(const char* bits) {
+    uint8_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        value = (uint8_t)((value << 1) | (bits[i] == '1'));
+    }
+    return value;
+}
+
+}  // namespace
+
+// hex holds the message as lowercase hex digits, like the "data:" lines of the app; both return the checksum over 8-bit blocks.
+uint8_t legacyStringChecksum(const std::string& hex) {
+    return bitStringValue(checkSum(hexstring_to_binarystring(hex), 8).c_str());
+}
+
+uint8_t legacyCharArrayChecksum(const std::string& hex) {
+    std::vector<char> bits(hex.size() * 4 + 8 + 1, '\0');  // 4 bits per digit, up to one block of padding, terminator
+    char result[9] = {0};
+    hexstring_to_binarystring(hex.c_str(), bits.data());
+    checkSum(bits.data(), 8, result);
+    return bitStringValue(result);
+}
@@ -0,0 +1,18 @@
+// Compiles ProjectColor.ino as a C++ translation unit, the way the Arduino builder does: core headers first, then the generated
+// function prototypes, then the sketch itself. The frame cache is built for an external store, with this array standing in for the
+// chip, so it does not take its share of the EEPROM from the stored animations the benchmark uploads. The simulated link paces
+// both ends at the benchmark's rate whatever the firmware configures, so it follows every negotiated link speed.
+#include "Arduino.h"
+#include "SoftwareSerial.h"
+#include "AltSoftSerial.h"
+#include "FastLED.h"
+#include "sketch_prototypes.h"
+
+#define BT_MODULE_FOLLOWS_BAUD 1
+#define FRAME_CACHE_EXTERNAL
+#define FRAME_CACHE_SIZE 1024
+uint8_t hostFrameCache[FRAME_CACHE_SIZE];
+uint8_t cacheStorageRead(uint16_t address) { return hostFrameCache[address]; }
+void cacheStorageWrite(uint16_t address, uint8_t value) { hostFrameCache[address] = value; }
+
+#include "ProjectColor.ino"
@@ -0,0 +1,19 @@
+// Host stand-in for AltSoftSerial on the device end of the simulated link. It keeps receiving while it transmits.
+#pragma once
+
+#include "Arduino.h"
+#include "../host_link.h"
+
+class AltSoftSerial : public Stream {
+public:
+    void begin(unsigned long baud) { hostDeviceBegin(baud); }
+    void end() {}
+    int available() override { return hostDeviceAvailable(); }
+    int read() override { return hostDeviceRead(); }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override {
+        hostDeviceWrite(data, length, false);
+        return length;
+    }
+    using Stream::write;
+};
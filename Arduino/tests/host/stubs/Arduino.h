@@ -0,0 +1,86 @@
+// Host stand-in for the parts of the Arduino core the firmware uses. Time comes from the host's steady clock, program memory is
+// ordinary memory, and every Stream is backed by the simulated serial link in host_link.h.
+#pragma once
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <type_traits>
+
+#define PROGMEM
+#define PSTR(x) (x)
+#define F(x) (reinterpret_cast<const __FlashStringHelper*>(PSTR(x)))
+#define DEC 10
+#define HEX 16
+
+typedef uint8_t byte;
+typedef const char* PGM_P;
+class __FlashStringHelper;
+
+inline int strcmp_P(const char* text, PGM_P flash) { return strcmp(text, flash); }
+inline int strncmp_P(const char* text, PGM_P flash, size_t length) { return strncmp(text, flash, length); }
+inline size_t strlen_P(PGM_P flash) { return strlen(flash); }
+#define snprintf_P snprintf
+
+inline uint8_t pgm_read_byte(const void* address) { return *(const uint8_t*)address; }
+inline uint16_t pgm_read_word(const void* address) { return *(const uint16_t*)address; }
+inline uint32_t pgm_read_dword(const void* address) { return *(const uint32_t*)address; }
+
+unsigned long millis();
+unsigned long micros();
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+// Minimal Print/Stream: subclasses implement the byte primitives, the text helpers format on top of them.
+class Stream {
+public:
+    virtual ~Stream() {}
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() { return -1; }
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* data, size_t length) {
+        size_t written = 0;
+        while (length--) {
+            written += write(*data++);
+        }
+        return written;
+    }
+    virtual void flush() {}
+
+    size_t write(const char* text) { return write((const uint8_t*)text, strlen(text)); }
+    size_t print(const char* text) { return write(text); }
+    size_t print(const __FlashStringHelper* text) { return write(reinterpret_cast<const char*>(text)); }
+    size_t print(char c) { return write((uint8_t)c); }
+    template <typename T>
+    typename std::enable_if<std::is_integral<T>::value && !std::is_same<T, char>::value, size_t>::type print(T value, int base = DEC) {
+        char text[24];
+        if (base == HEX) {
+            snprintf(text, sizeof(text), "%llx", (unsigned long long)value);
+        } else if (std::is_signed<T>::value) {
+            snprintf(text, sizeof(text), "%lld", (long long)value);
+        } else {
+            snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+        }
+        return write(text);
+    }
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(T value) { return print(value) + println(); }
+    template <typename T>
+    size_t println(T value, int base) { return print(value, base) + println(); }
+};
+
+// Debug console. Output goes to stderr when the host build runs with HOST_SERIAL_ECHO set, and is discarded otherwise.
+class HardwareSerial : public Stream {
+public:
+    void begin(unsigned long) {}
+    void end() {}
+    int available() override { return 0; }
+    int read() override { return -1; }
+    size_t write(uint8_t c) override;
+    using Stream::write;
+};
+
+extern HardwareSerial Serial;
@@ -0,0 +1,24 @@
+// Host stand-in for the EEPROM library: the Uno's 1 KB EEPROM as a RAM array that starts out erased (0xFF), like a new chip.
+// Writes are not delayed; the 3.3 ms per byte of the real EEPROM is not modelled.
+#pragma once
+
+#include "Arduino.h"
+
+#define E2END 0x3FF
+
+class EEPROMClass {
+public:
+    EEPROMClass() { memset(cells, 0xFF, sizeof(cells)); }
+    uint8_t read(int address) { return cells[address]; }
+    void write(int address, uint8_t value) { cells[address] = value; }
+    void update(int address, uint8_t value) {
+        if (cells[address] != value) {
+            write(address, value);
+        }
+    }
+    uint16_t length() { return E2END + 1; }
+
+    uint8_t cells[E2END + 1];
+};
+
+extern EEPROMClass EEPROM;
@@ -0,0 +1,95 @@
+// Host stand-in for FastLED. show() does not drive a strip; it blocks the receive side of the simulated link for as long as the
+// WS2812B protocol keeps interrupts disabled on the Uno (30 us per LED), which is what limits the firmware's throughput.
+// The math, noise and palette helpers behave like FastLED's within a few counts, which is close enough to exercise the effects.
+#pragma once
+
+#include "Arduino.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+#include "../host_link.h"
+
+#define HOST_LED_MICROS 30     // 24 bits at 800 kHz plus the latch share, per LED
+
+struct CHSV {
+    uint8_t h;
+    uint8_t s;
+    uint8_t v;
+
+    CHSV(uint8_t hue, uint8_t saturation, uint8_t value) : h(hue), s(saturation), v(value) {}
+};
+
+struct CRGB {
+    uint8_t r;
+    uint8_t g;
+    uint8_t b;
+
+    enum HTMLColorCode {
+        Black = 0x000000,
+        White = 0xFFFFFF,
+        Red = 0xFF0000,
+        Green = 0x008000,
+        Blue = 0x0000FF
+    };
+
+    CRGB() : r(0), g(0), b(0) {}
+    CRGB(uint8_t red, uint8_t green, uint8_t blue) : r(red), g(green), b(blue) {}
+    CRGB(uint32_t colorCode) : r(colorCode >> 16), g(colorCode >> 8), b(colorCode) {}
+    CRGB(HTMLColorCode colorCode) : CRGB((uint32_t)colorCode) {}
+    CRGB(const CHSV& hsv);
+    void setRGB(uint8_t red, uint8_t green, uint8_t blue) { r = red; g = green; b = blue; }
+    bool operator==(const CRGB& other) const { return r == other.r && g == other.g && b == other.b; }
+    bool operator!=(const CRGB& other) const { return !(*this == other); }
+};
+
+uint8_t scale8(uint8_t value, uint8_t scale);
+uint8_t qadd8(uint8_t a, uint8_t b);
+uint8_t qsub8(uint8_t a, uint8_t b);
+uint8_t sin8(uint8_t theta);
+uint8_t cos8(uint8_t theta);
+uint8_t inoise8(uint16_t x, uint16_t y, uint16_t z);
+
+enum TBlendType { NOBLEND, LINEARBLEND };
+typedef const uint32_t TProgmemRGBPalette16[16];
+extern const TProgmemRGBPalette16 RainbowColors_p;
+extern const TProgmemRGBPalette16 PartyColors_p;
+extern const TProgmemRGBPalette16 OceanColors_p;
+extern const TProgmemRGBPalette16 ForestColors_p;
+extern const TProgmemRGBPalette16 LavaColors_p;
+extern const TProgmemRGBPalette16 HeatColors_p;
+extern const TProgmemRGBPalette16 CloudColors_p;
+CRGB ColorFromPalette(const TProgmemRGBPalette16& palette, uint8_t index, uint8_t brightness = 255, TBlendType blendType = LINEARBLEND);
+
+enum ESPIChipsets { WS2812B };
+enum EOrder { RGB, GRB };
+
+class CFastLED {
+public:
+    template <int CHIPSET, uint8_t DATA_PIN, EOrder RGB_ORDER>
+    void addLeds(CRGB* data, int count) {
+        leds = data;
+        ledCount = count;
+    }
+    void show(uint8_t scale = 255) {
+        (void)scale;
+        hostDeviceInterruptsOff((unsigned long)ledCount * HOST_LED_MICROS);
+        shown.assign(leds, leds + ledCount);
+        shows++;
+        if (onShow) {
+            onShow();
+        }
+    }
+    void showColor(const CRGB& color, uint8_t scale = 255) {
+        (void)color;
+        show(scale);
+    }
+    void setBrightness(uint8_t scale) { (void)scale; }
+
+    CRGB* leds = nullptr;
+    int ledCount = 0;
+    std::atomic<unsigned long> shows{0};  // refreshes so far, read by the benchmark to time animation playback
+    std::vector<CRGB> shown;               // leds[] as of the last refresh; leds[] may already hold parts of the next frame
+    std::function<void()> onShow;          // called on the firmware thread after every refresh, set by the benchmark before it starts
+};
+
+extern CFastLED FastLED;
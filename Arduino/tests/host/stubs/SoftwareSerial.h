@@ -0,0 +1,22 @@
+// Host stand-in for SoftwareSerial on the device end of the simulated link. Like the real library it transmits with interrupts
+// disabled, so it cannot receive while it writes.
+#pragma once
+
+#include "Arduino.h"
+#include "../host_link.h"
+
+class SoftwareSerial : public Stream {
+public:
+    SoftwareSerial(uint8_t receivePin, uint8_t transmitPin) { (void)receivePin; (void)transmitPin; }
+    void begin(unsigned long baud) { hostDeviceBegin(baud); }
+    void end() {}
+    bool listen() { return true; }
+    int available() override { return hostDeviceAvailable(); }
+    int read() override { return hostDeviceRead(); }
+    size_t write(uint8_t c) override { return write(&c, 1); }
+    size_t write(const uint8_t* data, size_t length) override {
+        hostDeviceWrite(data, length, true);
+        return length;
+    }
+    using Stream::write;
+};